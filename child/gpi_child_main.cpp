@@ -2,23 +2,32 @@
 #include <iostream>
 #include <vector>
 #include <sstream>
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <chrono>
 #include <sys/stat.h>
 #include "../include/gpi/gpi_plugin.h"
 #include "../src/runtime/plugin_loader.h"
 #include "../src/runtime/child_shm.h"
+#include "../src/runtime/plugin_trace.h"
+#include "../src/runtime/plugin_profile.h"
+#include "../src/platform/perf_counters.h"
 #include "crash_report.h"
 #include "../src/platform/sandbox.h"
 
 static LoadedLibrary lib{};
 static GPI_HostApi host{}; 
 static GPI_VersionInfo ver{ GPI_ABI_VERSION, 0 };
-static GPI_InputV1 inbuf{};
+static GPI_InputV2 inbuf{};
 static GPI_FrameContext ctx{};
+static PluginTraceBuf* trace_buf = nullptr;   // in the shared block, drained by the host
+static PerfCounters counters;                 // --perf 1: update/render counts go back in RspOk
+static PluginProfiler profiler;               // --profile HZ: stacks go to the shared block
 static struct {
   decltype(&gpi_init)    init=nullptr;
+  decltype(&gpi_query_capabilities) caps=nullptr;
   decltype(&gpi_update)  update=nullptr;
   decltype(&gpi_render)  render=nullptr;
   decltype(&gpi_shutdown)shutdown=nullptr;
@@ -42,25 +51,42 @@ static std::vector<uint8_t> from_b64(const std::string& s) {
   return out;
 }
 
-static void send_rsp(shm::Block& shm, uint8_t phase, float ms) {
+static uint32_t trace_register(const char* name) { return trace_buf->register_name(name); }
+static void trace_begin(uint32_t id) { trace_buf->begin(id); }
+static void trace_end() { trace_buf->end(); }
+
+static void send_rsp(shm::Block& shm, uint8_t phase, float ms, const PerfSample* pc = nullptr) {
   std::vector<uint8_t> rsp = {3, phase}; // RspOk
   rsp.insert(rsp.end(), (uint8_t*)&ms, (uint8_t*)&ms + 4);
+  if (pc && pc->valid) {
+    rsp.insert(rsp.end(), (const uint8_t*)&pc->valid, (const uint8_t*)&pc->valid + 4);
+    rsp.insert(rsp.end(), (const uint8_t*)pc->v, (const uint8_t*)pc->v + sizeof(pc->v));
+  }
   shm::write_msg(shm.rsp, rsp.data(), rsp.size());
   shm::signal(shm.ctrl->ev_host_wake);
 }
 
 int main(int argc, char** argv) {
   std::string shm_name, lib_path, workdir = "userdata/child";
+  bool want_counters = false;
+  double profile_hz = 0;
   for (int i = 1; i < argc; i += 2) {
     if (i + 1 >= argc) break;
     std::string arg = argv[i];
     if (arg == "--shm") shm_name = argv[i + 1];
     else if (arg == "--lib") lib_path = argv[i + 1];
     else if (arg == "--work") workdir = argv[i + 1];
+    else if (arg == "--perf") want_counters = std::string(argv[i + 1]) == "1";
+    else if (arg == "--profile") profile_hz = std::atof(argv[i + 1]);
   }
   
   if (shm_name.empty() || lib_path.empty()) return 1;
   
+  // Before the sandbox: the counters are this (main) thread's, and stay
+  // open once privileges are dropped
+  std::string perr;
+  if (want_counters && !counters.open(perr)) std::fprintf(stderr, "counters off: %s\n", perr.c_str());
+
   // Phase 11: Security hardening
   std::string dumps = workdir + "/crashdumps";
   mkdir(dumps.c_str(), 0755);
@@ -77,6 +103,12 @@ int main(int argc, char** argv) {
   
   shm::Block shm;
   if (!shm::open_child(shm, shm_name)) return 1;
+  if (shm.aux && shm.aux_bytes >= sizeof(PluginTraceBuf) && ((PluginTraceBuf*)shm.aux)->magic == PluginTraceBuf::kMagic) {
+    trace_buf = (PluginTraceBuf*)shm.aux;
+    host.trace_register = &trace_register;
+    host.trace_begin = &trace_begin;
+    host.trace_end = &trace_end;
+  }
   
   // Load plugin
   lib = PluginLoader::open(lib_path);
@@ -84,9 +116,19 @@ int main(int argc, char** argv) {
   P.init = (decltype(P.init)) PluginLoader::sym(lib, "gpi_init");
   P.update = (decltype(P.update))PluginLoader::sym(lib, "gpi_update");
   P.render = (decltype(P.render))PluginLoader::sym(lib, "gpi_render");
+  P.caps = (decltype(P.caps))PluginLoader::sym(lib, "gpi_query_capabilities");
   P.shutdown = (decltype(P.shutdown))PluginLoader::sym(lib,"gpi_shutdown");
   if (!P.init || !P.update || !P.render) return 1;
   if (P.init(&ver, &host) != GPI_OK) return 1;
+  if (trace_buf && P.caps && (P.caps().caps & GPI_CAP_TRACE)) trace_buf->enabled = 1;
+  const uint32_t prof_off = PluginProfileBuf::aux_offset(sizeof(PluginTraceBuf));
+  if (profile_hz > 0 && shm.aux && shm.aux_bytes >= prof_off + sizeof(PluginProfileBuf)) {
+    std::string perr;
+    if (profiler.start((PluginProfileBuf*)((char*)shm.aux + prof_off), profile_hz, perr))
+      profiler.set_library((const void*)P.update);
+    else
+      std::fprintf(stderr, "profiler off: %s\n", perr.c_str());
+  }
   
   // Send init response
   send_rsp(shm, 0, 0.0f);
@@ -111,19 +153,40 @@ int main(int argc, char** argv) {
       
       if (cmd.size() < 25 + input_n) continue;
       if (input_n >= sizeof(GPI_InputV1)) {
-        std::memcpy(&inbuf, &cmd[25], sizeof(GPI_InputV1));
-        ctx = GPI_FrameContext{dt, w, h, t, &inbuf, (uint32_t)sizeof(GPI_InputV1), GPI_INPUT_VERSION};
-        if (P.update(&ctx) == GPI_OK) {
+        // V1 or V2 (the host may trim a V2 blob after its last event)
+        const uint32_t n = input_n < sizeof(GPI_InputV2) ? input_n : (uint32_t)sizeof(GPI_InputV2);
+        inbuf = GPI_InputV2{};
+        std::memcpy(&inbuf, &cmd[25], n);
+        uint32_t in_size = (uint32_t)sizeof(GPI_InputV1);
+        if (n >= offsetof(GPI_InputV2, events)) {
+          const uint32_t stored = (n - (uint32_t)offsetof(GPI_InputV2, events)) / (uint32_t)sizeof(GPI_InputEventV2);
+          if (inbuf.event_count > stored) inbuf.event_count = stored;
+          in_size = (uint32_t)sizeof(GPI_InputV2);
+        }
+        ctx = GPI_FrameContext{dt, w, h, t, &inbuf, in_size, GPI_INPUT_VERSION};
+        PerfSample pc;
+        counters.begin();
+        profiler.begin();
+        const GPI_Result r = P.update(&ctx);
+        profiler.end();
+        counters.end(pc);
+        if (r == GPI_OK) {
           auto end = std::chrono::high_resolution_clock::now();
           float ms = std::chrono::duration<float, std::milli>(end - start).count();
-          send_rsp(shm, 1, ms);
+          send_rsp(shm, 1, ms, &pc);
         }
       }
     } else if (type == 2) { // CmdRender
-      if (P.render() == GPI_OK) {
+      PerfSample pc;
+      counters.begin();
+      profiler.begin();
+      const GPI_Result r = P.render();
+      profiler.end();
+      counters.end(pc);
+      if (r == GPI_OK) {
         auto end = std::chrono::high_resolution_clock::now();
         float ms = std::chrono::duration<float, std::milli>(end - start).count();
-        send_rsp(shm, 2, ms);
+        send_rsp(shm, 2, ms, &pc);
       }
     }
   }
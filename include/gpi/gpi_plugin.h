@@ -29,7 +29,9 @@ typedef enum {
   GPI_CAP_DRAW_PRIMS    = 1 << 2,
   GPI_CAP_DRAWLIST_V1   = 1 << 3,
   GPI_CAP_DRAWLIST_V15  = 1 << 4,
-  GPI_CAP_IMAGES_V1     = 1 << 5
+  GPI_CAP_IMAGES_V1     = 1 << 5,
+  GPI_CAP_DRAWLIST_V2   = 1 << 6,
+  GPI_CAP_TRACE         = 1 << 7
 } GPI_CapabilityFlags;
 
 typedef struct {
@@ -55,16 +57,59 @@ typedef struct {
   uint8_t  _pad1[3];
 } GPI_InputV1;
 
+/* ---- Input V2 (timestamped events) ----
+ * A V2 blob is a complete GPI_InputV1 snapshot followed by the frame's
+ * input events in arrival order, so GPI_FrameContext.input_version stays
+ * GPI_INPUT_VERSION and V1 plugins read it unchanged; V2 readers detect the
+ * tail by size (gpi_input_v2). Presses and releases that happen between two
+ * frames all appear here even when the snapshot can only show the last state.
+ * The host keeps the newest GPI_INPUT_V2_MAX_EVENTS and counts the rest in
+ * `dropped`. Recorded replays store the whole blob. */
+#define GPI_INPUT_V2_MAX_EVENTS 64
+
+typedef enum {
+  GPI_EV_KEY_DOWN    = 1,  /* code = scancode (USB HID usage), x = 1 on auto-repeat */
+  GPI_EV_KEY_UP      = 2,
+  GPI_EV_MOUSE_MOVE  = 3,  /* x, y = position */
+  GPI_EV_MOUSE_DOWN  = 4,  /* code = button (1 left, 2 middle, 3 right), x, y = position */
+  GPI_EV_MOUSE_UP    = 5,
+  GPI_EV_MOUSE_WHEEL = 6,  /* x, y = scroll steps */
+  GPI_EV_PAD_DOWN    = 7,  /* code = button (SDL_GameControllerButton order) */
+  GPI_EV_PAD_UP      = 8,
+  GPI_EV_PAD_AXIS    = 9   /* code = axis, x = value (-32768..32767) */
+} GPI_InputEventType;
+
+typedef struct {
+  uint64_t time_ns;   /* when the OS received it, same clock as GPI_FrameContext.time_ns */
+  uint16_t type;      /* GPI_InputEventType */
+  uint16_t code;
+  int16_t  x, y;
+} GPI_InputEventV2;   /* 16 bytes */
+
+typedef struct {
+  GPI_InputV1 base;         /* end-of-frame snapshot */
+  uint32_t event_count;     /* valid entries in events[], <= GPI_INPUT_V2_MAX_EVENTS */
+  uint32_t dropped;         /* older events discarded this frame */
+  GPI_InputEventV2 events[GPI_INPUT_V2_MAX_EVENTS];
+} GPI_InputV2;
+
 typedef struct {
   float     dt_sec;
   int32_t   fb_width;
   int32_t   fb_height;
-  uint64_t  time_ns;
+  uint64_t  time_ns;        /* monotonic */
   const void* input_blob;
   uint32_t  input_size;
   uint32_t  input_version;
 } GPI_FrameContext;
 
+/* The frame's V2 input, or 0 when the host (or an old replay) sent V1 only. */
+static inline const GPI_InputV2* gpi_input_v2(const GPI_FrameContext* ctx) {
+  if (!ctx || !ctx->input_blob || ctx->input_version != GPI_INPUT_VERSION) return 0;
+  if (ctx->input_size < sizeof(GPI_InputV2)) return 0;
+  return (const GPI_InputV2*)ctx->input_blob;
+}
+
 typedef struct {
   float x, y, w, h;
   unsigned int rgba;
@@ -72,9 +117,20 @@ typedef struct {
 
 typedef void (*GPI_LogFn)(const char* msg);
 typedef void (*GPI_TelemetryFn)(const char* key, double value);
+/* Interned keys: resolve once (e.g. in gpi_init), then mark by id. */
+typedef uint32_t (*GPI_TelemetryKeyFn)(const char* key);
+typedef void (*GPI_TelemetryMarkIdFn)(uint32_t key_id, double value);
 typedef int  (*GPI_SavePutFn)(const char* key, const void* data, int32_t size);
 typedef int  (*GPI_SaveGetFn)(const char* key, void* out, int32_t capacity);
 typedef void (*GPI_DrawRectFn)(const GPI_DrawRect* r, int count);
+/* Tracing: register each zone name once (e.g. in gpi_init), then bracket
+ * work with trace_begin(id) / trace_end(). Zones nest and must close within
+ * the gpi_update / gpi_render call that opened them (the host closes any
+ * left open). They are recorded only when gpi_query_capabilities reports
+ * GPI_CAP_TRACE, and only from the thread that calls into the plugin. */
+typedef uint32_t (*GPI_TraceRegisterFn)(const char* name);   /* 0 = table full */
+typedef void (*GPI_TraceBeginFn)(uint32_t id);
+typedef void (*GPI_TraceEndFn)(void);
 
 /* ---- DrawList V1 (optional) ---- */
 typedef struct { float x, y, w, h; unsigned int rgba; } GPI_QuadV1;
@@ -138,6 +194,123 @@ typedef struct {
   unsigned int rgba;    /* tint color (0xAABBGGRR) */
 } GPI_SpriteV1;
 
+/* ---- DrawList V2 (byte-packed command stream) ----
+ * Header followed by `size` bytes of commands. Each command is a 1-byte
+ * opcode plus a packed little-endian payload (no alignment):
+ *
+ *   COLOR      u32 rgba                       sets colour for later cmds
+ *   RECT       i16 x,y,w,h                    square corners
+ *   RRECT      i16 x,y,w,h  u8 radius         radius in 1/4 px
+ *   LINE       i16 x0,y0,x1,y1  u8 thickness  thickness in 1/4 px
+ *   CIRCLE     i16 cx,cy  u16 r               filled
+ *   SPRITE     i16 x,y,w,h  u16 u0,v0,u1,v1  u32 image   uv unorm16, colour = tint
+ *   TEXT       i16 x,y  u8 size_px  u8 align  u16 len  len bytes utf-8
+ *   PUSH_CLIP  i16 x,y,w,h                    intersected with the current clip
+ *   POP_CLIP
+ *   PUSH_XFORM i16 tx,ty  u16 scale           p' = t + scale*p, scale 8.8 fixed
+ *   POP_XFORM
+ *
+ * i16 coordinates are quantized to 1/4 px (GPI_DL2_Q), i.e. +/-8191.75 px.
+ * The host validates the whole stream (bounds, opcodes, stack balance,
+ * cmd_count) before drawing; an invalid list is skipped for that frame. */
+#define GPI_DL2_MAGIC   0x325f4c44u /* 'DL_2' */
+#define GPI_DL2_VERSION 0x00020000u
+#define GPI_DL2_MAX_STACK 16
+
+typedef enum {
+  GPI_DL2_COLOR      = 1,
+  GPI_DL2_RECT       = 2,
+  GPI_DL2_RRECT      = 3,
+  GPI_DL2_LINE       = 4,
+  GPI_DL2_CIRCLE     = 5,
+  GPI_DL2_SPRITE     = 6,
+  GPI_DL2_TEXT       = 7,
+  GPI_DL2_PUSH_CLIP  = 8,
+  GPI_DL2_POP_CLIP   = 9,
+  GPI_DL2_PUSH_XFORM = 10,
+  GPI_DL2_POP_XFORM  = 11
+} GPI_DL2_Op;
+
+typedef struct {
+  uint32_t magic;      /* GPI_DL2_MAGIC */
+  uint32_t version;    /* GPI_DL2_VERSION */
+  uint32_t capacity;   /* command bytes available after the header */
+  uint32_t size;       /* command bytes written by plugin */
+  uint32_t cmd_count;  /* commands written by plugin (checked by host) */
+  uint32_t reserved;
+} GPI_DrawListV2;
+
+typedef void (*GPI_GetDrawListV2Fn)(GPI_DrawListV2** out_ptr, uint32_t* out_bytes);
+
+#define GPI_DL2_Q(px) ((int16_t)((px) * 4.0f + ((px) >= 0 ? 0.5f : -0.5f)))
+#define GPI_DL2_UV(u) ((uint16_t)((u) <= 0 ? 0 : (u) >= 1.0f ? 65535 : (u) * 65535.0f + 0.5f))
+
+/* Optional writer helpers. Each returns 0 when the list is full. */
+static inline uint8_t* gpi_dl2__alloc(GPI_DrawListV2* dl, uint32_t n, uint8_t op) {
+  uint8_t* p;
+  if (!dl || dl->size + n > dl->capacity) return 0;
+  p = (uint8_t*)dl + sizeof(GPI_DrawListV2) + dl->size;
+  dl->size += n; dl->cmd_count++;
+  p[0] = op;
+  return p + 1;
+}
+static inline uint8_t* gpi_dl2__u16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); return p + 2; }
+static inline uint8_t* gpi_dl2__u32(uint8_t* p, uint32_t v) { p = gpi_dl2__u16(p, (uint16_t)v); return gpi_dl2__u16(p, (uint16_t)(v >> 16)); }
+static inline uint8_t* gpi_dl2__box(uint8_t* p, float x, float y, float w, float h) {
+  p = gpi_dl2__u16(p, (uint16_t)GPI_DL2_Q(x)); p = gpi_dl2__u16(p, (uint16_t)GPI_DL2_Q(y));
+  p = gpi_dl2__u16(p, (uint16_t)GPI_DL2_Q(w)); return gpi_dl2__u16(p, (uint16_t)GPI_DL2_Q(h));
+}
+
+static inline void gpi_dl2_reset(GPI_DrawListV2* dl) { if (dl) { dl->size = 0; dl->cmd_count = 0; } }
+static inline int gpi_dl2_color(GPI_DrawListV2* dl, uint32_t rgba) {
+  uint8_t* p = gpi_dl2__alloc(dl, 5, GPI_DL2_COLOR); if (!p) return 0; gpi_dl2__u32(p, rgba); return 1;
+}
+static inline int gpi_dl2_rect(GPI_DrawListV2* dl, float x, float y, float w, float h) {
+  uint8_t* p = gpi_dl2__alloc(dl, 9, GPI_DL2_RECT); if (!p) return 0; gpi_dl2__box(p, x, y, w, h); return 1;
+}
+static inline int gpi_dl2_rrect(GPI_DrawListV2* dl, float x, float y, float w, float h, float radius) {
+  uint8_t* p = gpi_dl2__alloc(dl, 10, GPI_DL2_RRECT); if (!p) return 0;
+  p = gpi_dl2__box(p, x, y, w, h);
+  p[0] = (uint8_t)(radius <= 0 ? 0 : radius >= 63.75f ? 255 : radius * 4.0f + 0.5f); return 1;
+}
+static inline int gpi_dl2_line(GPI_DrawListV2* dl, float x0, float y0, float x1, float y1, float thickness) {
+  uint8_t* p = gpi_dl2__alloc(dl, 10, GPI_DL2_LINE); if (!p) return 0;
+  p = gpi_dl2__box(p, x0, y0, x1, y1);
+  p[0] = (uint8_t)(thickness <= 0 ? 0 : thickness >= 63.75f ? 255 : thickness * 4.0f + 0.5f); return 1;
+}
+static inline int gpi_dl2_circle(GPI_DrawListV2* dl, float cx, float cy, float r) {
+  uint8_t* p = gpi_dl2__alloc(dl, 7, GPI_DL2_CIRCLE); if (!p) return 0;
+  p = gpi_dl2__u16(p, (uint16_t)GPI_DL2_Q(cx)); p = gpi_dl2__u16(p, (uint16_t)GPI_DL2_Q(cy));
+  gpi_dl2__u16(p, (uint16_t)(r <= 0 ? 0 : r >= 16383.0f ? 65535 : r * 4.0f + 0.5f)); return 1;
+}
+static inline int gpi_dl2_sprite(GPI_DrawListV2* dl, float x, float y, float w, float h,
+                                 float u0, float v0, float u1, float v1, GPI_ImageHandle image) {
+  uint8_t* p = gpi_dl2__alloc(dl, 21, GPI_DL2_SPRITE); if (!p) return 0;
+  p = gpi_dl2__box(p, x, y, w, h);
+  p = gpi_dl2__u16(p, GPI_DL2_UV(u0)); p = gpi_dl2__u16(p, GPI_DL2_UV(v0));
+  p = gpi_dl2__u16(p, GPI_DL2_UV(u1)); p = gpi_dl2__u16(p, GPI_DL2_UV(v1));
+  gpi_dl2__u32(p, image); return 1;
+}
+static inline int gpi_dl2_text(GPI_DrawListV2* dl, float x, float y, uint8_t size_px, uint8_t align,
+                               const char* utf8, uint16_t len) {
+  uint8_t* p = gpi_dl2__alloc(dl, 9u + len, GPI_DL2_TEXT); uint16_t i;
+  if (!p) return 0;
+  p = gpi_dl2__u16(p, (uint16_t)GPI_DL2_Q(x)); p = gpi_dl2__u16(p, (uint16_t)GPI_DL2_Q(y));
+  p[0] = size_px; p[1] = align; p = gpi_dl2__u16(p + 2, len);
+  for (i = 0; i < len; ++i) p[i] = (uint8_t)utf8[i];
+  return 1;
+}
+static inline int gpi_dl2_push_clip(GPI_DrawListV2* dl, float x, float y, float w, float h) {
+  uint8_t* p = gpi_dl2__alloc(dl, 9, GPI_DL2_PUSH_CLIP); if (!p) return 0; gpi_dl2__box(p, x, y, w, h); return 1;
+}
+static inline int gpi_dl2_pop_clip(GPI_DrawListV2* dl) { return gpi_dl2__alloc(dl, 1, GPI_DL2_POP_CLIP) != 0; }
+static inline int gpi_dl2_push_xform(GPI_DrawListV2* dl, float tx, float ty, float scale) {
+  uint8_t* p = gpi_dl2__alloc(dl, 7, GPI_DL2_PUSH_XFORM); if (!p) return 0;
+  p = gpi_dl2__u16(p, (uint16_t)GPI_DL2_Q(tx)); p = gpi_dl2__u16(p, (uint16_t)GPI_DL2_Q(ty));
+  gpi_dl2__u16(p, (uint16_t)(scale <= 0 ? 0 : scale >= 255.0f ? 65535 : scale * 256.0f + 0.5f)); return 1;
+}
+static inline int gpi_dl2_pop_xform(GPI_DrawListV2* dl) { return gpi_dl2__alloc(dl, 1, GPI_DL2_POP_XFORM) != 0; }
+
 typedef struct {
   GPI_LogFn         log_info;
   GPI_LogFn         log_warn;
@@ -151,6 +324,12 @@ typedef struct {
   GPI_GetFontMetricsFn get_font_metrics_v15; /* font metrics (nullable) */
   GPI_UploadImageFn upload_image;    /* upload texture (nullable) */
   GPI_FreeImageFn   free_image;      /* free texture (nullable) */
+  GPI_GetDrawListV2Fn get_drawlist_v2; /* command stream path (nullable) */
+  GPI_TelemetryKeyFn telemetry_key;       /* intern a telemetry key (nullable) */
+  GPI_TelemetryMarkIdFn telemetry_mark_id; /* mark by interned id (nullable) */
+  GPI_TraceRegisterFn trace_register;     /* intern a zone name (nullable) */
+  GPI_TraceBeginFn  trace_begin;          /* open a zone (nullable) */
+  GPI_TraceEndFn    trace_end;            /* close the innermost zone (nullable) */
 } GPI_HostApi;
 
 #if defined(_WIN32) || defined(_WIN64)
@@ -0,0 +1,42 @@
+#include "gpi/gpi_plugin.h"
+
+// Input-to-photon probe target: every left-button press flips the whole
+// framebuffer between black and white. The host's --latency-probe driver
+// injects the presses and times how long the flip takes to reach a pixel.
+static const GPI_HostApi* G = nullptr;
+static int fbw=1280, fbh=720;
+static bool white = false;
+static GPI_DrawListV1* DL=nullptr; static uint32_t DL_bytes=0;
+
+extern "C" GPI_Result gpi_init(const GPI_VersionInfo* v, const GPI_HostApi* api) {
+  if (!v || v->abi_version != GPI_ABI_VERSION) return GPI_ERR_BAD_VERSION;
+  G = api; if (G->log_info) G->log_info("latency_probe: init");
+  if (G->get_drawlist_v1){ G->get_drawlist_v1(&DL, &DL_bytes); }
+  return GPI_OK;
+}
+extern "C" GPI_Capabilities gpi_query_capabilities(void) {
+  GPI_Capabilities c{}; c.caps = GPI_CAP_DRAW_PRIMS | GPI_CAP_DRAWLIST_V1; return c;
+}
+extern "C" GPI_Result gpi_update(const GPI_FrameContext* ctx) {
+  fbw = ctx->fb_width; fbh = ctx->fb_height;
+  if (ctx->input_version==GPI_INPUT_VERSION && ctx->input_blob) {
+    const GPI_InputV1* in=(const GPI_InputV1*)ctx->input_blob;
+    // mouse_left is only set on the frame the press arrives
+    if (in->mouse_left) white = !white;
+  }
+  return GPI_OK;
+}
+extern "C" GPI_Result gpi_render(void) {
+  const unsigned col = white ? 0xFFFFFFFFu : 0xFF000000u;
+  if (DL && DL->magic==GPI_DL_MAGIC) {
+    DL->quad_count = 0;
+    if (DL->max_quads > 0) DL->quads[DL->quad_count++] = GPI_QuadV1{ 0, 0, (float)fbw, (float)fbh, col };
+  } else if (G && G->draw_rects) {
+    GPI_DrawRect r{ 0, 0, (float)fbw, (float)fbh, col };
+    G->draw_rects(&r, 1);
+  }
+  return GPI_OK;
+}
+extern "C" void gpi_suspend(void) {}
+extern "C" void gpi_resume(void) {}
+extern "C" void gpi_shutdown(void) { if (G && G->log_info) G->log_info("latency_probe: shutdown"); }
@@ -30,6 +30,14 @@ extern "C" GPI_Result gpi_update(const GPI_FrameContext* ctx) {
     }
   }
 
+  // Input V2: every click of the frame, even ones shorter than a frame
+  if (const GPI_InputV2* in2 = gpi_input_v2(ctx)) {
+    int clicks = 0;
+    for (uint32_t i = 0; i < in2->event_count; ++i)
+      if (in2->events[i].type == GPI_EV_MOUSE_DOWN) ++clicks;
+    if (clicks && G && G->telemetry_mark) G->telemetry_mark("template.clicks", clicks);
+  }
+
   if (G && G->telemetry_mark) {
     double phase = std::sin((double)(ctx->time_ns % 1'000'000'000ull) / 1.0e9 * 6.283185307179586);
     G->telemetry_mark("template.phase", phase);
@@ -31,12 +31,37 @@ bool cfg::load_from_file(const std::string& path, Settings& out) {
       else if (key == "stall_ms") out.stall_ms = std::stod(val);
       else if (key == "last_plugin") out.last_plugin = val;
       else if (key == "isolation") out.isolation = (lower(val)=="true" || val=="1");
+      else if (key == "perf_counters") out.perf_counters = (lower(val)=="true" || val=="1");
+      else if (key == "profile_hz") out.profile_hz = std::stod(val);
+      else if (key == "profile_top") out.profile_top = std::stoi(val);
     } else if (section == "ui") {
       if (key == "hud") out.ui_hud = (lower(val)=="true" || val=="1");
       else if (key == "show_store") out.show_store = (lower(val)=="true" || val=="1");
+      else if (key == "font") out.ui_font = val;
+      else if (key == "font_px") out.ui_font_px = std::stof(val);
+      else if (key == "font_fallback") out.ui_font_fallback = val;
     } else if (section == "replay") {
       if (key == "last_record") out.last_record = val;
       else if (key == "last_replay") out.last_replay = val;
+    } else if (section == "display") {
+      if (key == "pacing") out.pacing = lower(val);
+      else if (key == "target_fps") out.target_fps = std::stoi(val);
+      else if (key == "late_latch") out.late_latch = (lower(val)=="true" || val=="1");
+    } else if (section == "capture") {
+      if (key == "video_fps") out.video_fps = std::stoi(val);
+      else if (key == "session_format") out.session_format = lower(val);
+      else if (key == "trace_seconds") out.trace_seconds = std::stod(val);
+      else if (key == "flight_seconds") out.flight_seconds = std::stod(val);
+      else if (key == "spike_factor") out.spike_factor = std::stod(val);
+      else if (key == "spike_cooldown_s") out.spike_cooldown_s = std::stod(val);
+    } else if (section == "telemetry") {
+      if (key == "max_mb") out.telemetry_max_mb = std::stod(val);
+      else if (key == "raw_seconds") out.telemetry_raw_seconds = std::stod(val);
+      else if (key == "proc_hz") out.proc_sample_hz = std::stod(val);
+    } else if (section == "log") {
+      if (key == "file") out.log_file = val;
+      else if (key == "plugin_rate") out.log_plugin_rate = std::stod(val);
+      else if (key == "plugin_burst") out.log_plugin_burst = std::stod(val);
     }
   }
   return true;
@@ -50,12 +75,37 @@ bool cfg::save_to_file(const std::string& path, const Settings& in) {
   f << "deadline_ms = " << in.deadline_ms << "\n";
   f << "stall_ms    = " << in.stall_ms << "\n";
   f << "last_plugin = \"" << in.last_plugin << "\"\n";
-  f << "isolation   = " << (in.isolation ? "true" : "false") << "\n\n";
+  f << "isolation   = " << (in.isolation ? "true" : "false") << "\n";
+  f << "perf_counters = " << (in.perf_counters ? "true" : "false") << "\n";
+  f << "profile_hz = " << in.profile_hz << "\n";
+  f << "profile_top = " << in.profile_top << "\n\n";
   f << "[ui]\n";
   f << "hud = " << (in.ui_hud ? "true" : "false") << "\n";
-  f << "show_store = " << (in.show_store ? "true" : "false") << "\n\n";
+  f << "show_store = " << (in.show_store ? "true" : "false") << "\n";
+  f << "font = \"" << in.ui_font << "\"\n";
+  f << "font_px = " << in.ui_font_px << "\n";
+  f << "font_fallback = \"" << in.ui_font_fallback << "\"\n\n";
   f << "[replay]\n";
   f << "last_record = \"" << in.last_record << "\"\n";
-  f << "last_replay = \"" << in.last_replay << "\"\n";
+  f << "last_replay = \"" << in.last_replay << "\"\n\n";
+  f << "[display]\n";
+  f << "pacing = \"" << in.pacing << "\"\n";
+  f << "target_fps = " << in.target_fps << "\n";
+  f << "late_latch = " << (in.late_latch ? "true" : "false") << "\n\n";
+  f << "[capture]\n";
+  f << "video_fps = " << in.video_fps << "\n";
+  f << "session_format = \"" << in.session_format << "\"\n";
+  f << "trace_seconds = " << in.trace_seconds << "\n";
+  f << "flight_seconds = " << in.flight_seconds << "\n";
+  f << "spike_factor = " << in.spike_factor << "\n";
+  f << "spike_cooldown_s = " << in.spike_cooldown_s << "\n\n";
+  f << "[telemetry]\n";
+  f << "max_mb = " << in.telemetry_max_mb << "\n";
+  f << "raw_seconds = " << in.telemetry_raw_seconds << "\n";
+  f << "proc_hz = " << in.proc_sample_hz << "\n\n";
+  f << "[log]\n";
+  f << "file = \"" << in.log_file << "\"\n";
+  f << "plugin_rate = " << in.log_plugin_rate << "\n";
+  f << "plugin_burst = " << in.log_plugin_burst << "\n";
   return true;
 }
@@ -8,9 +8,30 @@ struct Settings {
   std::string last_plugin = "";
   bool ui_hud = true;
   bool isolation = true;
+  bool perf_counters = false;     // cycles/instructions/cache and branch misses per plugin call
+  double profile_hz = 0.0;        // SIGPROF stack samples per CPU second in plugin calls; 0 = off
+  int profile_top = 12;           // functions in the HUD profile table
   bool show_store = true;
+  std::string ui_font = "";       // TTF path; empty = built-in font
+  float ui_font_px = 18.0f;
+  std::string ui_font_fallback = "";  // TTF for glyphs missing from the atlas (CJK...)
   std::string last_record = "";
   std::string last_replay = "";
+  std::string pacing = "vsync";   // vsync | capped | uncapped
+  int target_fps = 60;
+  bool late_latch = false;        // poll input just before the predicted deadline
+  int video_fps = 30;             // capture rate; host frames are decimated to it
+  std::string session_format = "binary";  // F9/exit artifacts: binary | text | both
+  double trace_seconds = 10.0;    // timeline F9 dumps as Chrome trace JSON
+  double flight_seconds = 5.0;    // flight recorder window, dumped on spikes and stalls
+  double spike_factor = 3.0;      // frame > factor x budget is a spike; 0 = off
+  double spike_cooldown_s = 10.0; // minimum gap between two spike dumps
+  double telemetry_max_mb = 16.0;       // points + rollups; oldest data rolls up first
+  double telemetry_raw_seconds = 120.0; // raw points kept this long, then 1 s/10 s buckets
+  double proc_sample_hz = 4.0;          // host/gpi_child CPU, memory, faults; 0 = off
+  std::string log_file = "";      // host + plugin log appended here; empty = none
+  double log_plugin_rate = 50.0;  // messages per second a plugin may log; 0 = unlimited
+  double log_plugin_burst = 200.0;
 };
 
 namespace cfg {
@@ -1,14 +1,17 @@
 #pragma once
 #include <cstdint>
+#include "../include/gpi/gpi_plugin.h"
 
 struct InputSnapshot {
   bool quit = false;
   bool key_escape = false;
   bool toggle_hud = false;
+  bool screenshot = false;   // F12, edge-triggered (key repeat ignored)
+  bool save_artifacts = false;   // F9, edge-triggered: each press queues one full export
 
   // Mouse
   int mouse_x = 0, mouse_y = 0;
-  bool mouse_left = false;
+  bool mouse_left = false;   // pressed at any point this frame
   bool mouse_right = false;
 
   // Gamepad summary (extend later)
@@ -16,4 +19,26 @@ struct InputSnapshot {
   float axis_left_x = 0.0f;
   float axis_left_y = 0.0f;
   bool button_a = false;
+
+  // Every event of the frame, timestamped (GPI_InputV2). A ring: once full
+  // the oldest entry is overwritten, so the newest input always survives.
+  GPI_InputEventV2 events[GPI_INPUT_V2_MAX_EVENTS];
+  uint32_t event_head = 0;
+  uint32_t event_count = 0;
+  uint32_t dropped = 0;
+
+  void push_event(uint64_t t_ns, uint16_t type, uint16_t code, int x, int y) {
+    const auto clamp16 = [](int v) { return (int16_t)(v < -32768 ? -32768 : v > 32767 ? 32767 : v); };
+    const GPI_InputEventV2 ev{ t_ns, type, code, clamp16(x), clamp16(y) };
+    if (event_count < GPI_INPUT_V2_MAX_EVENTS) {
+      events[(event_head + event_count++) % GPI_INPUT_V2_MAX_EVENTS] = ev;
+    } else {
+      events[event_head] = ev;
+      event_head = (event_head + 1) % GPI_INPUT_V2_MAX_EVENTS;
+      ++dropped;
+    }
+  }
+  const GPI_InputEventV2& event(uint32_t i) const {
+    return events[(event_head + i) % GPI_INPUT_V2_MAX_EVENTS];
+  }
 };
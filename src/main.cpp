@@ -19,19 +19,35 @@
 #include "services/log_bus.h"
 #include "services/telemetry.h"
 #include "services/artifacts.h"
+#include "services/artifact_writer.h"
+#include "services/session_file.h"
+#include "services/trace.h"
+#include "services/flight_recorder.h"
+#include "services/proc_sampler.h"
 #include "services/replay.h"
 #include "runtime/runner.h"
+#include "runtime/plugin_trace.h"
+#include "runtime/plugin_profile.h"
 #include "ui/log_panel.h"
 #include "ui/draw_prim.h"
 #include "ui/store_panel.h"
 #include "ui/hud_perf.h"
+#include "ui/zone_view.h"
 #include "ui/render_drawlist.h"
 #include "ui/font_atlas.h"
+#include "ui/soft_raster.h"
+#include "ui/image_store.h"
+#include "ui/glyph_cache.h"
+#include "platform/frame_pacer.h"
 #include "services/screenshot.h"
+#include "services/video_capture.h"
 #include "runtime/drawlist_shm.h"
-// #include "qa/golden.h"
-// #include "qa/diff.h"
+#include "qa/golden.h"
+#include "qa/latency_probe.h"
 #include "version.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <ctime>
 #include <random>
 // #include <filesystem>
@@ -55,6 +71,8 @@ struct Cli {
   std::string win_size;
   std::string golden_capture;
   std::string golden_verify;
+  int latency_probe = 0;     // samples to collect; 0 = off
+  double trace_seconds = 0;  // --trace N: dump the last N s of the timeline on exit
 };
 
 static Cli parse_cli(int argc, char** argv) {
@@ -75,7 +93,12 @@ static Cli parse_cli(int argc, char** argv) {
     else if (a=="--win-size") c.win_size = next(i);
     else if (a=="--golden-capture") c.golden_capture = next(i);
     else if (a=="--golden-verify") c.golden_verify = next(i);
+    else if (a=="--latency-probe") c.latency_probe = std::atoi(next(i));
+    else if (a=="--trace") c.trace_seconds = std::atof(next(i));
   }
+  if (c.latency_probe > 0 && c.plugin.empty()) c.plugin = "latency_probe";
+  // Golden runs rasterize on the CPU, so they are always headless
+  if (!c.golden_capture.empty() || !c.golden_verify.empty()) c.headless = true;
   return c;
 }
 
@@ -83,10 +106,26 @@ struct HostServices {
   static LogBus* LB;
   static Telemetry* TM;
   static const std::string* PLUGIN_NS;
+  static SoftRaster* SOFT;           // headless: legacy rects go to the CPU rasterizer
+  static GPI_DrawListV1* DL;
+  static uint32_t DL_BYTES;
+  static GPI_DrawListV15* DL15;
+  static uint32_t DL15_BYTES;
+  static GPI_DrawListV2* DL2;
+  static uint32_t DL2_BYTES;
+  static const HostFont* FONT;
+  static ImageStore* IMAGES;
+  static PluginTraceBuf* TRACE;      // in-process runner's zone buffer
+  static std::atomic<uint8_t> LOG_SRC;   // current plugin's LogBus source, set by load_plugin
 
-  static void log_info(const char* msg)  { if (LB) LB->push(LogLvl::Info,  msg?msg:"");  std::fprintf(stdout, "[INFO] %s\n",  msg?msg:""); }
-  static void log_warn(const char* msg)  { if (LB) LB->push(LogLvl::Warn,  msg?msg:"");  std::fprintf(stderr, "[WARN] %s\n",  msg?msg:""); }
-  static void log_error(const char* msg) { if (LB) LB->push(LogLvl::Error, msg?msg:"");  std::fprintf(stderr, "[ERROR] %s\n", msg?msg:""); }
+  // Lock-free push; the bus's sink thread prints, so a slow terminal never
+  // blocks the plugin. Each plugin is its own rate-limited source.
+  static void log(LogLvl lvl, const char* msg) {
+    if (LB) LB->push(lvl, msg?msg:"", LOG_SRC.load(std::memory_order_relaxed));
+  }
+  static void log_info(const char* msg)  { log(LogLvl::Info,  msg); }
+  static void log_warn(const char* msg)  { log(LogLvl::Warn,  msg); }
+  static void log_error(const char* msg) { log(LogLvl::Error, msg); }
 
   static int save_put(const char* key, const void* data, int32_t size) {
     const std::string ns = (PLUGIN_NS && !PLUGIN_NS->empty()) ? *PLUGIN_NS : "unknown";
@@ -99,19 +138,63 @@ struct HostServices {
   static void telemetry_mark(const char* key, double value) {
     if (TM) TM->mark(key?key:"(null)", value);
   }
+  static uint32_t telemetry_key(const char* key) {
+    return TM ? TM->intern(key?key:"(null)") : 0;
+  }
+  static void telemetry_mark_id(uint32_t id, double value) {
+    if (TM) TM->mark(id, value);
+  }
+  static uint32_t trace_register(const char* name) { return TRACE ? TRACE->register_name(name) : 0; }
+  static void trace_begin(uint32_t id) { if (TRACE) TRACE->begin(id); }
+  static void trace_end() { if (TRACE) TRACE->end(); }
   static void draw_rects(const GPI_DrawRect* r, int count) {
-    draw2d::draw_rects(r, count);
+    if (SOFT) draw2d::draw_rects_soft(*SOFT, r, count);
+    else draw2d::draw_rects(r, count);
+  }
+  static void get_drawlist_v1(GPI_DrawListV1** out, uint32_t* bytes) {
+    if (out) *out = DL;
+    if (bytes) *bytes = DL_BYTES;
+  }
+  static void get_drawlist_v15(GPI_DrawListV15** out, uint32_t* bytes) {
+    if (out) *out = DL15;
+    if (bytes) *bytes = DL15_BYTES;
+  }
+  static void get_drawlist_v2(GPI_DrawListV2** out, uint32_t* bytes) {
+    if (out) *out = DL2;
+    if (bytes) *bytes = DL2_BYTES;
+  }
+  static GPI_ImageHandle upload_image(const void* rgba, int w, int h) {
+    return IMAGES ? IMAGES->upload(rgba, w, h) : 0;
+  }
+  static void free_image(GPI_ImageHandle img) { if (IMAGES) IMAGES->free(img); }
+  static void get_font_metrics_v15(float* asc, float* desc, float* gap, float* pxh) {
+    if (asc)  *asc  = FONT ? FONT->ascent : 0.0f;
+    if (desc) *desc = FONT ? FONT->descent : 0.0f;
+    if (gap)  *gap  = FONT ? FONT->line_gap : 0.0f;
+    if (pxh)  *pxh  = FONT ? FONT->atlas_px_height : 0.0f;
   }
 };
 LogBus*    HostServices::LB = nullptr;
 Telemetry* HostServices::TM = nullptr;
 const std::string* HostServices::PLUGIN_NS = nullptr;
+SoftRaster* HostServices::SOFT = nullptr;
+GPI_DrawListV1* HostServices::DL = nullptr;
+uint32_t HostServices::DL_BYTES = 0;
+GPI_DrawListV15* HostServices::DL15 = nullptr;
+uint32_t HostServices::DL15_BYTES = 0;
+GPI_DrawListV2* HostServices::DL2 = nullptr;
+uint32_t HostServices::DL2_BYTES = 0;
+const HostFont* HostServices::FONT = nullptr;
+ImageStore* HostServices::IMAGES = nullptr;
+std::atomic<uint8_t> HostServices::LOG_SRC{LogBus::kHost};
+PluginTraceBuf* HostServices::TRACE = nullptr;
 
 // Forward declaration
 struct AppState;
 
-static GPI_InputV1 make_input_blob(const InputSnapshot& in) {
-  GPI_InputV1 b{};
+static void make_input_blob(const InputSnapshot& in, GPI_InputV2& v2) {
+  GPI_InputV1& b = v2.base;
+  b = GPI_InputV1{};
   b.input_version  = GPI_INPUT_VERSION;
   b.key_escape     = in.key_escape ? 1 : 0;
   b.mouse_x        = in.mouse_x; b.mouse_y = in.mouse_y;
@@ -121,7 +204,10 @@ static GPI_InputV1 make_input_blob(const InputSnapshot& in) {
   b.pad_axis_left_x   = (int8_t)(in.axis_left_x * 127.0f);
   b.pad_axis_left_y   = (int8_t)(in.axis_left_y * 127.0f);
   b.pad_button_a      = in.button_a ? 1 : 0;
-  return b;
+  // Ring -> oldest-first array
+  v2.event_count = in.event_count;
+  v2.dropped     = in.dropped;
+  for (uint32_t i = 0; i < in.event_count; ++i) v2.events[i] = in.event(i);
 }
 
 struct AppState {
@@ -166,9 +252,17 @@ struct AppState {
   
   // Phase 9: Per-call metrics, Screenshots
   PerCallHud perf_calls;
-  bool record_video = false;
-  int video_frame_idx = 0;
-  std::string video_dir;
+  ZoneView zone_view;
+  ScreenshotQueue shots;
+  std::vector<std::string> shot_paths;  // taken at end of frame, once the back buffer is complete
+  VideoCapture video;
+  ArtifactWriter writer;   // session exports and telemetry appends, off the render thread
+  Tracer tracer;           // host phases, plugin calls, loads, watchdog; F9 dumps the last trace_seconds
+  PluginTraceReader plugin_zones;   // plugin trace_begin/end -> tracer spans and zones
+  FlightRecorder flight{tracer, logs, writer};   // last few seconds, dumped on spikes and stalls
+  ProcSampler procs{telemetry};   // host + gpi_child CPU, memory, faults, context switches
+  double trace_seconds = 10.0;
+  bool trace_on_exit = false;   // --trace N
   
   // Phase 10: Demo mode
   bool demo_mode = false;
@@ -182,6 +276,32 @@ struct AppState {
   // Phase 13: Draw list v1.5 + font
   GPI_DrawListV15* dl15_host = nullptr;
   HostFont host_font;
+  GlyphCache glyph_cache;
+
+  // DrawList V2 command stream + plugin images
+  DrawListMap dl2_map;
+  GPI_DrawListV2* dl2_host = nullptr;
+  Dl2Error dl2_last_err = Dl2Error::None;
+  ImageStore images;
+
+  FramePacer pacer;
+  PacingMode pacing = PacingMode::VSync;
+
+  GPI_InputV2 input_v2{};   // this frame's plugin input
+
+  int mouse_x = 0, mouse_y = 0;  // last known pointer position
+  // First attached game controller (GPI_InputV1 reports a single pad)
+  SDL_GameController* pad = nullptr;
+
+  // Input-to-present latency of each input event, resolved at present
+  LatencyHistogram input_lat;
+  LatencyProbe probe;
+
+  // Headless: CPU rasterizer standing in for GL
+  std::unique_ptr<SoftRaster> soft;
+
+  // Phase 14: Golden capture/verify
+  std::unique_ptr<GoldenRunner> golden;
 };
 
 static GPI_HostApi make_host_api(AppState& s) {
@@ -195,41 +315,144 @@ static GPI_HostApi make_host_api(AppState& s) {
   api.save_put  = &HostServices::save_put;
   api.save_get  = &HostServices::save_get;
   api.telemetry_mark = &HostServices::telemetry_mark;
+  api.telemetry_key = &HostServices::telemetry_key;
+  api.telemetry_mark_id = &HostServices::telemetry_mark_id;
+  api.trace_register = &HostServices::trace_register;
+  api.trace_begin = &HostServices::trace_begin;
+  api.trace_end = &HostServices::trace_end;
   api.draw_rects = &HostServices::draw_rects;
   
-  // Phase 12: Draw list getter
-  static GPI_DrawListV1* DL_PTR = nullptr; 
-  static uint32_t DL_BYTES = 0;
-  DL_PTR = s.dl_host; DL_BYTES = s.dl_map.bytes;
-  api.get_drawlist_v1 = [](GPI_DrawListV1** out, uint32_t* bytes){ *out = DL_PTR; *bytes = DL_BYTES; };
-  
-  // Phase 13: Draw list v1.5 + font metrics
-  static GPI_DrawListV15* DL15_PTR = nullptr;
-  static uint32_t DL15_BYTES = 0;
-  static HostFont* FONT_PTR = nullptr;
-  DL15_PTR = s.dl15_host; DL15_BYTES = 0; // Will be set during allocation
-  FONT_PTR = &s.host_font;
-  api.get_drawlist_v15 = [](GPI_DrawListV15** out, uint32_t* bytes){ *out = DL15_PTR; *bytes = DL15_BYTES; };
-  api.get_font_metrics_v15 = [](float* asc, float* desc, float* gap, float* pxh){
-    if (asc) *asc = FONT_PTR->ascent;
-    if (desc) *desc = FONT_PTR->descent;
-    if (gap) *gap = FONT_PTR->line_gap;
-    if (pxh) *pxh = FONT_PTR->atlas_px_height;
-  };
+  // Phase 12/13: Draw lists + font metrics (buffers are bound by ensure_drawlists)
+  HostServices::FONT = &s.host_font;
+  api.get_drawlist_v1 = &HostServices::get_drawlist_v1;
+  api.get_drawlist_v15 = &HostServices::get_drawlist_v15;
+  api.get_font_metrics_v15 = &HostServices::get_font_metrics_v15;
+  api.get_drawlist_v2 = &HostServices::get_drawlist_v2;
+
+  // Images V1: CPU copies, GL textures created lazily by the GL renderer
+  HostServices::IMAGES = &s.images;
+  api.upload_image = &HostServices::upload_image;
+  api.free_image = &HostServices::free_image;
   
   return api;
 }
 
+// Allocates the V1 / V1.5 draw lists once; plugins fetch them in gpi_init, so
+// this must run before the first load.
+static void ensure_drawlists(AppState& s) {
+  // Phase 12: Initialize draw list
+  if (!s.dl_host) {
+    std::random_device rd;
+    std::string dl_name = "gpi_dl_" + std::to_string(rd());
+    uint32_t dl_bytes = sizeof(GPI_DrawListV1) + 4096 * sizeof(GPI_QuadV1);
+    if (dl_create_host(s.dl_map, dl_name, dl_bytes)) {
+      s.dl_host = (GPI_DrawListV1*)s.dl_map.base;
+      s.dl_host->magic = GPI_DL_MAGIC;
+      s.dl_host->version = 0x00010000;
+      s.dl_host->max_quads = 4096;
+      s.dl_host->quad_count = 0;
+      HostServices::DL = s.dl_host;
+      HostServices::DL_BYTES = s.dl_map.bytes;
+    }
+  }
+
+  // Phase 13: Initialize draw list v1.5
+  if (!s.dl15_host) {
+    const uint32_t MAXQ=4096, MAXT=1024, UTF8=64*1024;
+    uint32_t dl15_bytes = sizeof(GPI_DrawListV15) + MAXQ*sizeof(GPI_QuadV1) + MAXT*sizeof(GPI_TextRunV15) + UTF8;
+    s.dl15_host = (GPI_DrawListV15*)std::malloc(dl15_bytes);
+    if (s.dl15_host) {
+      s.dl15_host->magic = GPI_DL15_MAGIC;
+      s.dl15_host->version = GPI_DL15_VERSION;
+      s.dl15_host->max_quads = MAXQ; s.dl15_host->quad_count = 0;
+      s.dl15_host->max_text = MAXT; s.dl15_host->text_count = 0;
+      s.dl15_host->utf8_capacity = UTF8; s.dl15_host->utf8_size = 0;
+      HostServices::DL15 = s.dl15_host;
+      HostServices::DL15_BYTES = dl15_bytes;
+    }
+  }
+
+  // DrawList V2: byte stream in shared memory, plugins reset it each frame
+  if (!s.dl2_host) {
+    std::random_device rd;
+    const uint32_t CAP = 256 * 1024;
+    if (dl_create_host(s.dl2_map, "gpi_dl2_" + std::to_string(rd()), sizeof(GPI_DrawListV2) + CAP)) {
+      s.dl2_host = (GPI_DrawListV2*)s.dl2_map.base;
+      s.dl2_host->magic = GPI_DL2_MAGIC;
+      s.dl2_host->version = GPI_DL2_VERSION;
+      s.dl2_host->capacity = CAP;
+      s.dl2_host->size = 0;
+      s.dl2_host->cmd_count = 0;
+      HostServices::DL2 = s.dl2_host;
+      HostServices::DL2_BYTES = s.dl2_map.bytes;
+    }
+  }
+}
+
+// Rejected V2 lists draw nothing; log once per distinct error, not per frame.
+static void note_dl2_result(AppState& s, Dl2Error err) {
+  if (err == s.dl2_last_err) return;
+  s.dl2_last_err = err;
+  if (err != Dl2Error::None)
+    s.logs.push(LogLvl::Warn, std::string("DrawList V2 rejected: ") + dl2_error_str(err));
+}
+
 static std::string timestamp() {
   std::time_t t = std::time(nullptr);
   char buf[32]; std::strftime(buf, sizeof(buf), "%Y%m%d-%H%M%S", std::localtime(&t));
   return buf;
 }
 
+// One .gpisession: series are encoded while the telemetry aggregator is
+// held and written once it is released
+static int64_t write_session_file(const std::string& path, const SessionInfo& info, const FrameSummary& sum,
+                                  const std::vector<double>& frames, const std::vector<CallCounters>& counters,
+                                  Telemetry& tel) {
+  session_file::Writer w;
+  const uint64_t now_us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count();
+  if (!w.open(path, now_us, tel.clock_us())) return -1;
+  w.info(info);
+  w.summary(info, sum);
+  w.frames(frames);
+  w.counters(counters);
+  std::vector<std::vector<uint8_t>> series;
+  tel.visit_series([&](const std::string& key, uint32_t id, const TelemetryStore& st) {
+    session_file::SeriesEncoder enc(key);
+    st.for_each_raw(id, [&](int64_t t, double v) { enc.point(t, v); });
+    if (const auto* r = st.rollup_1s(id)) for (const auto& b : *r) enc.rollup(1, b);
+    if (const auto* r = st.rollup_10s(id)) for (const auto& b : *r) enc.rollup(10, b);
+    series.push_back(enc.finish());
+  });
+  for (const auto& p : series) w.section(session_file::kSeries, p.data(), p.size());
+  return w.finish();
+}
+
+// Runner load as a "plugin.load" span on the timeline
+static bool load_plugin(AppState& s, const std::string& path) {
+  TraceScope span(s.tracer, "plugin.load", "plugin", s.tracer.intern(path));
+  s.plugin_zones.reset();
+  s.perf_calls.profile.reset();
+  // Before the load: gpi_init may already log
+  const auto pos = path.find_last_of("/\\");
+  HostServices::LOG_SRC.store(s.logs.source(pos == std::string::npos ? path : path.substr(pos + 1)),
+                              std::memory_order_relaxed);
+  return s.runner->load(path);
+}
+
+static void queue_trace_dump(AppState& s, const std::string& path) {
+  Tracer* tr = &s.tracer;
+  const double secs = s.trace_seconds;
+  s.writer.submit([tr, path, secs]{ return tr->write_chrome_json(path, secs); });
+}
+
 static void save_artifacts_now(AppState& s) {
   auto samples = s.hist.samples();
   auto stats   = s.hist.stats_for_summary();
-  FrameSummary sum{ stats.avg_ms, stats.p95_ms, stats.p99_ms, stats.dropped_pct, (int)samples.size() };
+  FrameSummary sum{ stats.avg_ms, stats.p95_ms, stats.p99_ms, stats.dropped_pct, (int)samples.size(),
+                    stats.pace_avg_ms, stats.pace_p99_ms, s.input_lat.stats(), s.probe.hist().stats(),
+                    stats.p50_ms, stats.p90_ms, stats.p999_ms, stats.max_ms,
+                    s.procs.host_summary(), s.procs.child_summary() };
 
   SessionInfo info{};
   #if defined(GPI_WIN)
@@ -242,22 +465,116 @@ static void save_artifacts_now(AppState& s) {
   info.app_version = "1.0.0";
   info.plugin      = s.current_plugin_leaf;
   info.target_fps  = s.cfg.target_fps;
+  info.pacing      = pacing_mode_name(s.pacer.mode());
 
-  std::string ts = timestamp();
-  std::string base = "artifacts/session-" + ts;
-  (void)std::system("mkdir -p artifacts");
+  // Only the snapshots above are taken here; formatting and writes happen on
+  // the writer thread
+  const std::string base = "artifacts/session-" + timestamp();
+  Telemetry* tel = &s.telemetry;
+  LogBus* logs = &s.logs;
+  const std::string& fmt = s.settings.session_format;
+  const bool binary = fmt != "text", text = fmt == "text" || fmt == "both";
+  s.writer.submit([base, info, sum, samples = std::move(samples), counters = s.perf_calls.counters,
+                   profile = s.perf_calls.profile.stacks(), tel, logs, binary, text]() -> int64_t {
+    std::vector<int64_t> parts;
+    if (binary) parts.push_back(write_session_file(base + ".gpisession", info, sum, samples, counters, *tel));
+    if (!profile.empty()) {
+      const std::string folded = PluginProfileReader::folded(profile);
+      parts.push_back(artifacts::write_text_atomic(base + "-profile.folded", folded) ? (int64_t)folded.size() : -1);
+    }
+    if (text) {
+      parts.push_back(artifacts::write_frame_csv(base + "-frames.csv", samples));
+      if (!counters.empty()) parts.push_back(artifacts::write_counters_csv(base + "-counters.csv", counters));
+      parts.push_back(artifacts::write_session_json(base + "-summary.json", info, sum));
+      parts.push_back(tel->flush_csv(base + "-telemetry.csv"));
+      parts.push_back(tel->flush_json(base + "-telemetry.json"));
+      parts.push_back(tel->flush_rollups_csv(base + "-telemetry-rollups.csv"));
+    }
+    int64_t total = 0;
+    for (int64_t n : parts) {
+      if (n < 0) { logs->push(LogLvl::Warn, "Artifacts: failed to write " + base + "*"); return -1; }
+      total += n;
+    }
+    return total;
+  });
+  s.tracer.instant("artifacts.save", "host");
+  queue_trace_dump(s, base + "-trace.json");
+  s.toasts.info("Saving artifacts: " + base);
+}
+
+static void request_screenshot(AppState& s) {
+  std::string path = "artifacts/snap-" + timestamp() + ".png";
+  s.toasts.info("Screenshot queued: " + path);
+  s.shot_paths.push_back(std::move(path));
+}
+
+static bool start_video(AppState& s, const std::string& path, int decimate) {
+  int w, h;
+  if (s.soft) { w = s.soft->width(); h = s.soft->height(); }
+  else SDL_GetWindowSize(s.window, &w, &h);  // same size capture_gl() is given
+  return s.video.start(path, w, h, s.cfg.target_fps, decimate);
+}
 
-  artifacts::write_frame_csv(base + "-frames.csv", samples);
-  artifacts::write_session_json(base + "-summary.json", info, sum);
+// Issues the frame's captures: PBO readback on GL, a copy of the soft raster otherwise.
+static void take_frame_captures(AppState& s, int w, int h) {
+  for (const auto& path : s.shot_paths) {
+    if (s.soft) s.shots.capture_rgba(path, (const uint8_t*)s.soft->pixels(), s.soft->width(), s.soft->height());
+    else s.shots.capture_gl(path, w, h);
+  }
+  s.shot_paths.clear();
+  if (s.video.active()) {
+    if (s.soft) s.video.capture_rgba((const uint8_t*)s.soft->pixels(), s.soft->width(), s.soft->height());
+    else s.video.capture_gl(w, h);
+  }
+}
 
-  s.telemetry.flush_csv(base + "-telemetry.csv");
-  s.telemetry.flush_json(base + "-telemetry.json");
-  s.toasts.info("Artifacts saved");
+static uint64_t mono_ns() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Latency probe: the synthetic click goes through the normal SDL queue so it
+// pays the same polling path as a real one.
+static void push_probe_click(AppState& s, bool down) {
+  int w, h; SDL_GetWindowSize(s.window, &w, &h);
+  SDL_Event e{};
+  e.type = down ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+  e.button.windowID = SDL_GetWindowID(s.window);
+  e.button.button = SDL_BUTTON_LEFT;
+  e.button.state = down ? SDL_PRESSED : SDL_RELEASED;
+  e.button.clicks = 1;
+  e.button.x = w / 2; e.button.y = h / 2;
+  SDL_PushEvent(&e);
+}
+
+// Resolves this frame's input events against the time the frame was handed
+// to the display (or to the soft raster's consumers, headless).
+static void note_present(AppState& s, const InputSnapshot& in, uint64_t present_ns) {
+  for (uint32_t i = 0; i < in.event_count; ++i) {
+    const uint64_t ts = in.event(i).time_ns;
+    s.input_lat.push(present_ns > ts ? (double)(present_ns - ts) / 1e6 : 0.0);
+  }
+  if (s.soft) s.probe.after_present(present_ns, s.soft->pixels(), s.soft->width(), s.soft->height());
+  else s.probe.after_present(present_ns, nullptr, 0, 0);
 }
 
 void sdl_quit() { SDL_Quit(); }
 
+// Codepoints outside the baked atlas are rasterized on demand from the
+// fallback TTF (or the main one). Without a TTF there is nothing to
+// rasterize from and missing glyphs keep drawing as the fallback glyph.
+static void init_glyph_cache(AppState& s, bool blocking) {
+  const std::string& ttf = !s.settings.ui_font_fallback.empty() ? s.settings.ui_font_fallback
+                                                                : s.settings.ui_font;
+  if (!s.glyph_cache.init(ttf, s.host_font.atlas_px_height, std::round(s.host_font.ascent))) return;
+  s.glyph_cache.set_blocking(blocking);
+  s.host_font.dynamic = &s.glyph_cache;
+}
+
 bool init_window(AppState& s, const Cli& cli) {
+  // Headless never touches GL: use SDL's dummy video driver so CI boxes
+  // without a GPU or display can run, and rasterize on the CPU instead.
+  if (cli.headless && !SDL_getenv("SDL_VIDEODRIVER")) SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
   if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER | SDL_INIT_TIMER) != 0) {
     std::fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
     return false;
@@ -278,14 +595,28 @@ bool init_window(AppState& s, const Cli& cli) {
   //   }
   // }
   
+  const Uint32 win_flags = cli.headless ? SDL_WINDOW_HIDDEN
+                                       : (SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
   s.window = SDL_CreateWindow(
       s.cfg.title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, s.cfg.width, s.cfg.height,
-      SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+      win_flags);
   if (!s.window) {
     std::fprintf(stderr, "SDL_CreateWindow failed: %s\n", SDL_GetError());
     return false;
   }
 
+  if (cli.headless) {
+    // Font atlas is still needed for text; it builds without an ImGui context.
+    if (!fontatlas_init(s.host_font, s.settings.ui_font, s.settings.ui_font_px)) {
+      std::fprintf(stderr, "Font atlas init failed\n");
+      return false;
+    }
+    init_glyph_cache(s, s.golden != nullptr);
+    s.soft = std::make_unique<SoftRaster>();
+    HostServices::SOFT = s.soft.get();
+    return true;
+  }
+
   s.gl_ctx = SDL_GL_CreateContext(s.window);
   if (!s.gl_ctx) {
     std::fprintf(stderr, "SDL_GL_CreateContext failed: %s\n", SDL_GetError());
@@ -294,26 +625,36 @@ bool init_window(AppState& s, const Cli& cli) {
 
   // OpenGL context is ready
 
-  SDL_GL_SetSwapInterval(1);
+  // Capped/uncapped pacing must not also wait on the display
+  SDL_GL_SetSwapInterval(s.pacing == PacingMode::VSync ? 1 : 0);
 
-  // Initialize ImGui only in GUI mode
-  if (!cli.headless) {
-    if (!s.imgui.init(s.window, s.gl_ctx)) {
-      std::fprintf(stderr, "ImGui init failed\n");
-      return false;
-    }
-    
-    // Phase 13: Initialize font atlas
-    if (!fontatlas_init_default(s.host_font, 18.0f)) {
-      std::fprintf(stderr, "Font atlas init failed\n");
-      return false;
-    }
+  if (!s.imgui.init(s.window, s.gl_ctx)) {
+    std::fprintf(stderr, "ImGui init failed\n");
+    return false;
   }
-  
+
+  // Phase 13: Initialize font atlas
+  if (!fontatlas_init(s.host_font, s.settings.ui_font, s.settings.ui_font_px)) {
+    std::fprintf(stderr, "Font atlas init failed\n");
+    return false;
+  }
+  init_glyph_cache(s, false);
+
   return true;
 }
 
 void shutdown(AppState& s) {
+  // Finish queued screenshots while the PBOs' context is still alive
+  s.shots.flush();
+  if (s.trace_on_exit) queue_trace_dump(s, "artifacts/trace-" + timestamp() + ".json");
+  s.writer.flush();
+  // Last, so what the writer logged still reaches the console and log file
+  s.logs.stop();
+  if (s.gl_ctx) {
+    s.shots.release_gl(); s.video.release_gl(); s.images.release_gl(); s.glyph_cache.release_gl();
+    s.probe.release_gl();
+  }
+  else s.video.stop();
   // Only shutdown ImGui if it was initialized
   if (ImGui::GetCurrentContext() != nullptr) {
     s.imgui.shutdown();
@@ -324,24 +665,80 @@ void shutdown(AppState& s) {
 }
 
 void poll_input(InputSnapshot& snap, AppState& s) {
+  // The pointer stays where it was unless this frame moved it
+  snap.mouse_x = s.mouse_x; snap.mouse_y = s.mouse_y;
   SDL_Event e;
   while (SDL_PollEvent(&e)) {
     // Only process ImGui events if ImGui is initialized
     if (ImGui::GetCurrentContext() != nullptr) {
       ImGui_ImplSDL2_ProcessEvent(&e);
     }
-    if (e.type == SDL_QUIT) snap.quit = true;
-    if (e.type == SDL_KEYDOWN) {
-      if (e.key.keysym.sym == SDLK_ESCAPE) snap.key_escape = true;
-      if (e.key.keysym.sym == SDLK_F10)    snap.toggle_hud = true;
-    }
-    if (e.type == SDL_MOUSEMOTION) { snap.mouse_x = e.motion.x; snap.mouse_y = e.motion.y; }
-    if (e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEBUTTONUP) {
-      const bool down = (e.type == SDL_MOUSEBUTTONDOWN);
-      if (e.button.button == SDL_BUTTON_LEFT)  snap.mouse_left = down;
-      if (e.button.button == SDL_BUTTON_RIGHT) snap.mouse_right = down;
+    // SDL stamps events in ms since init; age them against the steady clock
+    const uint64_t t_ns = mono_ns() - (uint64_t)(Uint32)(SDL_GetTicks() - e.common.timestamp) * 1000000ull;
+    switch (e.type) {
+      case SDL_QUIT: snap.quit = true; break;
+      case SDL_KEYDOWN:
+        if (e.key.keysym.sym == SDLK_ESCAPE) snap.key_escape = true;
+        if (e.key.keysym.sym == SDLK_F10)    snap.toggle_hud = true;
+        if (e.key.keysym.sym == SDLK_F12 && !e.key.repeat) snap.screenshot = true;
+        if (e.key.keysym.sym == SDLK_F9 && !e.key.repeat) snap.save_artifacts = true;
+        snap.push_event(t_ns, GPI_EV_KEY_DOWN, (uint16_t)e.key.keysym.scancode, e.key.repeat ? 1 : 0, 0);
+        break;
+      case SDL_KEYUP:
+        snap.push_event(t_ns, GPI_EV_KEY_UP, (uint16_t)e.key.keysym.scancode, 0, 0);
+        break;
+      case SDL_MOUSEMOTION:
+        snap.mouse_x = e.motion.x; snap.mouse_y = e.motion.y;
+        snap.push_event(t_ns, GPI_EV_MOUSE_MOVE, 0, e.motion.x, e.motion.y);
+        break;
+      case SDL_MOUSEBUTTONDOWN:
+      case SDL_MOUSEBUTTONUP: {
+        // A press latches for the frame: a click released before the next
+        // poll still shows up in the snapshot
+        const bool down = (e.type == SDL_MOUSEBUTTONDOWN);
+        if (down && e.button.button == SDL_BUTTON_LEFT)  snap.mouse_left = true;
+        if (down && e.button.button == SDL_BUTTON_RIGHT) snap.mouse_right = true;
+        snap.mouse_x = e.button.x; snap.mouse_y = e.button.y;
+        snap.push_event(t_ns, down ? GPI_EV_MOUSE_DOWN : GPI_EV_MOUSE_UP, e.button.button, e.button.x, e.button.y);
+        break;
+      }
+      case SDL_MOUSEWHEEL:
+        snap.push_event(t_ns, GPI_EV_MOUSE_WHEEL, 0, e.wheel.x, e.wheel.y);
+        break;
+      case SDL_CONTROLLERDEVICEADDED:
+        if (!s.pad) s.pad = SDL_GameControllerOpen(e.cdevice.which);
+        break;
+      case SDL_CONTROLLERDEVICEREMOVED:
+        if (s.pad && SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(s.pad)) == e.cdevice.which) {
+          SDL_GameControllerClose(s.pad);
+          s.pad = nullptr;
+        }
+        break;
+      case SDL_CONTROLLERBUTTONDOWN:
+      case SDL_CONTROLLERBUTTONUP: {
+        const bool down = (e.type == SDL_CONTROLLERBUTTONDOWN);
+        if (down && e.cbutton.button == SDL_CONTROLLER_BUTTON_A) snap.button_a = true;
+        snap.push_event(t_ns, down ? GPI_EV_PAD_DOWN : GPI_EV_PAD_UP, e.cbutton.button, 0, 0);
+        break;
+      }
+      case SDL_CONTROLLERAXISMOTION:
+        snap.push_event(t_ns, GPI_EV_PAD_AXIS, e.caxis.axis, e.caxis.value, 0);
+        break;
+      default: break;
     }
   }
+  s.mouse_x = snap.mouse_x; s.mouse_y = snap.mouse_y;
+  if (s.pad) {
+    snap.gamepad_connected = true;
+    snap.axis_left_x = SDL_GameControllerGetAxis(s.pad, SDL_CONTROLLER_AXIS_LEFTX) / 32767.0f;
+    snap.axis_left_y = SDL_GameControllerGetAxis(s.pad, SDL_CONTROLLER_AXIS_LEFTY) / 32767.0f;
+    if (SDL_GameControllerGetButton(s.pad, SDL_CONTROLLER_BUTTON_A)) snap.button_a = true;
+  }
+}
+
+static void proc_line(const char* label, const ProcSampler::Sample& p) {
+  ImGui::Text("%s CPU %.0f%%  RSS %.1f MB  PSS %.1f MB  faults/s %.0f min %.0f maj  ctxsw/s %.0f vol %.0f invol",
+              label, p.cpu_pct, p.rss_mb, p.pss_mb, p.minflt_s, p.majflt_s, p.vcsw_s, p.ivcsw_s);
 }
 
 void draw_hud(AppState& s, const FrameStats& fs) {
@@ -355,31 +752,83 @@ void draw_hud(AppState& s, const FrameStats& fs) {
                ImGuiWindowFlags_NoFocusOnAppearing |
                ImGuiWindowFlags_NoNav);
   ImGui::Text("FPS: %.1f", fs.fps);
-  ImGui::Text("avg: %.2f ms  p95: %.2f ms  p99: %.2f ms", fs.avg_ms, fs.p95_ms, fs.p99_ms);
+  ImGui::Text("avg: %.2f ms  p50: %.2f  p90: %.2f  p99: %.2f  p99.9: %.2f  max: %.2f ms",
+              fs.avg_ms, fs.p50_ms, fs.p90_ms, fs.p99_ms, fs.p999_ms, fs.max_ms);
   ImGui::Text("Dropped: %.2f%% (>%0.1f ms)", fs.dropped_pct, s.hist.budget_ms());
+  ImGui::Text("Pacing: %s %.0f Hz  err avg %.3f ms  p99 %.3f ms  spin %.2f ms",
+              pacing_mode_name(s.pacer.mode()), s.pacer.hz(), fs.pace_avg_ms, fs.pace_p99_ms,
+              s.pacer.spin_margin_ms());
+  if (s.pacer.late_latch())
+    ImGui::Text("Late latch: work p99 %.2f ms  margin %.2f ms  missed %llu",
+                s.pacer.work_p99_ms(), s.pacer.latch_margin_ms(),
+                (unsigned long long)s.pacer.missed());
+  if (s.procs.running()) {
+    if (const auto h = s.procs.host(); h.valid) proc_line("Host: ", h);
+    if (const auto c = s.procs.child(); c.valid) proc_line("Child:", c);
+  }
+  {
+    const auto tu = s.telemetry.usage();
+    ImGui::Text("Telemetry: %.2f / %.1f MB  %zu keys  %llu raw pts  %llu dropped",
+                tu.bytes / (1024.0 * 1024.0), tu.max_bytes / (1024.0 * 1024.0), tu.keys,
+                (unsigned long long)tu.raw_points, (unsigned long long)tu.dropped);
+  }
+  {
+    const auto ws = s.writer.stats();
+    ImGui::Text("Artifacts: %llu writes  last %.1f ms  p99 %.1f ms  %d queued  %llu failed",
+                (unsigned long long)ws.written, ws.last_ms, ws.latency.p99_ms, ws.queued,
+                (unsigned long long)ws.failed);
+  }
+  {
+    const auto fr = s.flight.stats();
+    ImGui::Text("Spikes: %llu dumped  %llu suppressed  (> %.0fx budget)%s%s",
+                (unsigned long long)fr.dumps, (unsigned long long)fr.suppressed, s.flight.config().spike_factor,
+                fr.last_path.empty() ? "" : "  last ", fr.last_path.c_str());
+  }
+  {
+    const auto il = s.input_lat.stats();
+    ImGui::Text("Input->present: median %.1f ms  p99 %.1f ms  (%d events)", il.p50_ms, il.p99_ms, il.samples);
+  }
       ImGui::Separator();
       if (ImGui::Button("Save Artifacts (F9)")) save_artifacts_now(s);
       ImGui::SameLine();
-      if (ImGui::Button("Screenshot (F12)")) {
-        std::string ts = timestamp();
-        std::string path = "artifacts/snap-" + ts + ".png";
-        int w, h; SDL_GetWindowSize(s.window, &w, &h);
-        if (save_screenshot_png(path, w, h)) {
-          s.toasts.info("Screenshot saved: " + path);
-        }
+      if (ImGui::Button("Screenshot (F12)")) request_screenshot(s);
+      ImGui::SameLine();
+      ImGui::Checkbox("Zones", &s.zone_view.open);
+      {
+        const auto ss = s.shots.stats();
+        ImGui::Text("Shots: %llu written  %llu dropped  %d queued  (%.1f ms encode)",
+                    (unsigned long long)ss.written,
+                    (unsigned long long)(ss.dropped_busy + ss.dropped_full),
+                    ss.queued, ss.last_encode_ms);
       }
       ImGui::Separator();
-      if (ImGui::Button(s.record_video ? "Stop Video" : "Start Video")) {
-        if (!s.record_video) {
-          s.video_dir = "artifacts/video-" + timestamp();
-          s.video_frame_idx = 0;
-          s.record_video = true;
-          s.toasts.info("Video recording started: " + s.video_dir);
+      if (ImGui::Button(s.video.active() ? "Stop Video" : "Start Video")) {
+        if (!s.video.active()) {
+          // Decimate the host rate down to the configured capture rate
+          const int fps = std::max(1, s.settings.video_fps);
+          const int decimate = std::max(1, (s.cfg.target_fps + fps / 2) / fps);
+          if (start_video(s, "artifacts/video-" + timestamp() + ".y4m", decimate))
+            s.toasts.info("Video recording started: " + s.video.path());
+          else
+            s.toasts.error("Video recording failed to start");
         } else {
-          s.record_video = false;
-          s.toasts.info("Video recording stopped. Use: ffmpeg -framerate 60 -i " + s.video_dir + "/frame_%06d.png -pix_fmt yuv420p out.mp4");
+          s.video.stop();
+          s.toasts.info("Video recording stopped. Use: ffmpeg -i " + s.video.path() + " -pix_fmt yuv420p out.mp4");
         }
       }
+      if (s.video.active()) {
+        const auto vs = s.video.stats();
+        ImGui::Text("Video: %llu frames  %.1f MB  drop gpu/writer %llu/%llu  q %d  %.2f ms/frame",
+                    (unsigned long long)vs.written, vs.bytes / (1024.0 * 1024.0),
+                    (unsigned long long)vs.dropped_gpu, (unsigned long long)vs.dropped_writer,
+                    vs.pending, vs.avg_write_ms);
+      }
+      if (s.glyph_cache.active()) {
+        const auto gs = s.glyph_cache.stats();
+        ImGui::Text("Glyphs: %d/%d cells (%d pages)  miss %u  up %u  evict %u  pending %d",
+                    gs.slots_used, gs.slots_total, gs.pages, gs.misses, gs.uploaded, gs.evicted,
+                    gs.pending);
+      }
       ImGui::Separator();
       ImGui::Text("F9: artifacts  |  F12: screenshot  |  F10: toggle HUD  |  Esc: quit");
   ImGui::End();
@@ -421,36 +870,12 @@ void draw_plugin_panel(AppState& s) {
     if (ImGui::Button("Load")) {
       if (s.runner && s.selected_idx >= 0) {
         auto path = s.plugin_metas[s.selected_idx].path;
-        if (s.runner->load(path)) {
+        if (load_plugin(s, path)) {
           s.plugin_loaded = true;
           auto pos = path.find_last_of("/\\");
           s.current_plugin_leaf = (pos==std::string::npos)? path : path.substr(pos+1);
           std::snprintf(s.plugin_status, sizeof(s.plugin_status), "Loaded: %s", s.plugin_metas[s.selected_idx].name.c_str());
           s.toasts.info("Plugin loaded");
-          
-          // Phase 12: Initialize draw list
-          std::random_device rd;
-          std::string dl_name = "gpi_dl_" + std::to_string(rd());
-          uint32_t dl_bytes = sizeof(GPI_DrawListV1) + 4096 * sizeof(GPI_QuadV1);
-          if (dl_create_host(s.dl_map, dl_name, dl_bytes)) {
-            s.dl_host = (GPI_DrawListV1*)s.dl_map.base;
-            s.dl_host->magic = GPI_DL_MAGIC;
-            s.dl_host->version = 0x00010000;
-            s.dl_host->max_quads = 4096;
-            s.dl_host->quad_count = 0;
-          }
-          
-          // Phase 13: Initialize draw list v1.5
-          const uint32_t MAXQ=4096, MAXT=1024, UTF8=64*1024;
-          uint32_t dl15_bytes = sizeof(GPI_DrawListV15) + MAXQ*sizeof(GPI_QuadV1) + MAXT*sizeof(GPI_TextRunV15) + UTF8;
-          s.dl15_host = (GPI_DrawListV15*)std::malloc(dl15_bytes);
-          if (s.dl15_host) {
-            s.dl15_host->magic = GPI_DL15_MAGIC;
-            s.dl15_host->version = GPI_DL15_VERSION;
-            s.dl15_host->max_quads = MAXQ; s.dl15_host->quad_count = 0;
-            s.dl15_host->max_text = MAXT; s.dl15_host->text_count = 0;
-            s.dl15_host->utf8_capacity = UTF8; s.dl15_host->utf8_size = 0;
-          }
         } else {
           std::snprintf(s.plugin_status, sizeof(s.plugin_status), "Load failed: %s", s.runner->last_error());
           s.toasts.error("Load failed");
@@ -471,7 +896,7 @@ void draw_plugin_panel(AppState& s) {
       if (!s.plugin_metas.empty() && s.runner) {
         int next = (s.selected_idx + 1) % (int)s.plugin_metas.size();
         s.runner->unload();
-        if (s.runner->load(s.plugin_metas[next].path)) {
+        if (load_plugin(s, s.plugin_metas[next].path)) {
           s.selected_idx = next;
           s.plugin_loaded = true;
           auto pos = s.plugin_metas[next].path.find_last_of("/\\");
@@ -508,31 +933,40 @@ int main(int argc, char** argv) {
   
   
   
-  // Phase 14: Handle golden verification
-  // if (!cli.golden_verify.empty()) {
-  //   GoldenMeta meta;
-  //   if (!load_golden_meta(cli.golden_verify, meta)) {
-  //     std::fprintf(stderr, "Failed to load golden meta from %s\n", cli.golden_verify.c_str());
-  //     return 1;
-  //   }
-  //   
-  //   std::string replay_path = cli.golden_verify + "/pong_smoke.replay";
-  //   std::string out_dir = "artifacts/golden_pong_smoke_run";
-  //   std::string report_path;
-  //   bool pass;
-  //   
-  //   if (!verify_golden(cli.golden_verify, replay_path, meta, out_dir, report_path, pass)) {
-  //     std::fprintf(stderr, "Golden verification failed\n");
-  //     return 1;
-  //   }
-  //   
-  //   std::printf("Golden verification %s\n", pass ? "PASSED" : "FAILED");
-  //   std::printf("Report: %s\n", report_path.c_str());
-  //   return pass ? 0 : 1;
-  // }
-  
   AppState s{};
 
+  // Phase 14: Golden capture/verify. Meta pins window size and plugin; the
+  // folder's replay drives input (capture records one if it is missing).
+  if (!cli.golden_capture.empty() || !cli.golden_verify.empty()) {
+    const bool capture = !cli.golden_capture.empty();
+    const std::string folder = capture ? cli.golden_capture : cli.golden_verify;
+    GoldenMeta meta;
+    if (!load_golden_meta(folder, meta)) {
+      std::fprintf(stderr, "Failed to load golden meta from %s\n", folder.c_str());
+      return 1;
+    }
+    s.cfg.width = meta.w; s.cfg.height = meta.h;
+    if (cli.plugin.empty()) cli.plugin = meta.plugin_hint;
+    const std::string replay = golden_replay_path(folder);
+    if (std::FILE* f = std::fopen(replay.c_str(), "rb")) { std::fclose(f); cli.replay_path = replay; }
+    else if (capture) cli.record_path = replay;
+    s.golden = std::make_unique<GoldenRunner>(capture ? GoldenMode::Capture : GoldenMode::Verify,
+                                              folder, meta, golden_out_dir(folder));
+  }
+
+  // Settings (read before the window: the font atlas and swap interval depend on them)
+  cfg::load_from_file("config/settings.toml", s.settings);
+  s.logs.start(LogBus::Config{ s.settings.log_file, s.settings.log_plugin_rate, s.settings.log_plugin_burst });
+  s.cfg.target_fps = std::clamp(s.settings.target_fps, 1, 1000);
+  if (!parse_pacing_mode(s.settings.pacing, s.pacing)) {
+    std::fprintf(stderr, "Unknown pacing mode '%s', using vsync\n", s.settings.pacing.c_str());
+    s.pacing = PacingMode::VSync;
+  }
+  // Headless has no swap to block on, so vsync means "hold the target rate".
+  // Golden runs replay a fixed timestep and gain nothing from waiting.
+  if (s.golden) s.pacing = PacingMode::Uncapped;
+  else if (cli.headless && s.pacing == PacingMode::VSync) s.pacing = PacingMode::Capped;
+
   if (!init_window(s, cli)) { shutdown(s); return 1; }
 
   if (cli.headless) {
@@ -540,19 +974,67 @@ int main(int argc, char** argv) {
     s.hud_visible = false;
   }
 
-  // Settings
-  cfg::load_from_file("config/settings.toml", s.settings);
   s.hud_visible = s.settings.ui_hud;
   s.plugins_dir = s.settings.plugins_dir;
   s.deadline_ms_cfg = s.settings.deadline_ms;
   s.show_store = s.settings.show_store;
+  s.telemetry.configure((std::size_t)(std::max(s.settings.telemetry_max_mb, 0.0) * 1024 * 1024),
+                        s.settings.telemetry_raw_seconds);
+  s.procs.start(s.settings.proc_sample_hz);
+  s.hist.set_budget_ms(1000.0 / s.cfg.target_fps);
+  s.trace_seconds = cli.trace_seconds > 0 ? cli.trace_seconds : s.settings.trace_seconds;
+  s.trace_on_exit = cli.trace_seconds > 0;
+  {
+    FlightRecorder::Config fc;
+    fc.seconds = s.settings.flight_seconds;
+    fc.spike_factor = s.settings.spike_factor;
+    fc.cooldown_s = s.settings.spike_cooldown_s;
+    s.flight.configure(fc);
+  }
+  s.tracer.name_thread("main");
+  GPI_ZONE_THREAD("main");
+  {
+    // With vsync the cadence is the display's, not target_fps
+    double hz = s.cfg.target_fps;
+    SDL_DisplayMode dm{};
+    if (s.pacing == PacingMode::VSync && s.gl_ctx &&
+        SDL_GetWindowDisplayMode(s.window, &dm) == 0 && dm.refresh_rate > 0)
+      hz = dm.refresh_rate;
+    s.pacer.configure(s.pacing, hz, s.settings.late_latch);
+  }
   
   // Phase 8: Initialize runner based on isolation setting
   auto api = make_host_api(s);
+  ensure_drawlists(s);
+  if (s.settings.perf_counters) {
+    // Same PMU and permissions as the runner's group; say once why it is off
+    PerfCounters probe;
+    std::string err;
+    if (probe.open(err))
+      s.logs.push(LogLvl::Info, std::string("Hardware counters on (") + (probe.uses_rdpmc() ? "rdpmc" : "read()") + ")");
+    else
+      s.logs.push(LogLvl::Warn, "Hardware counters unavailable: " + err);
+  }
+  double profile_hz = std::min(s.settings.profile_hz, StackSampler::kMaxHz);
+  if (profile_hz > 0) {
+    StackSampler probe;
+    std::string err;
+    if (probe.start(profile_hz, err)) {
+      probe.stop();
+      char msg[64];
+      std::snprintf(msg, sizeof(msg), "Sampling profiler on (%.0f Hz)", profile_hz);
+      s.logs.push(LogLvl::Info, msg);
+    } else {
+      s.logs.push(LogLvl::Warn, "Sampling profiler unavailable: " + err);
+      profile_hz = 0;
+    }
+  }
+  s.perf_calls.profile_top = s.settings.profile_top;
   if (s.settings.isolation) {
-    s.runner = make_runner_child();
+    s.runner = make_runner_child(s.settings.perf_counters, profile_hz);
   } else {
-    s.runner = make_runner_inproc(api, s.deadline_ms_cfg);
+    s.runner = make_runner_inproc(api, s.deadline_ms_cfg, s.settings.perf_counters, profile_hz);
+    HostServices::TRACE = s.runner->trace_buffer();
   }
   
   // Phase 8: Initialize replay/record
@@ -566,7 +1048,7 @@ int main(int argc, char** argv) {
   // Phase 8: Discover plugins with metadata
   s.plugin_metas = scan_with_metadata(s.plugins_dir);
   if (!s.plugin_metas.empty()) {
-    if (cli.headless && !cli.plugin.empty()) {
+    if ((cli.headless || cli.latency_probe > 0) && !cli.plugin.empty()) {
       for (size_t i=0;i<s.plugin_metas.size();++i)
         if (s.plugin_metas[i].path.find(cli.plugin) != std::string::npos)
           s.selected_idx = (int)i;
@@ -591,9 +1073,9 @@ int main(int argc, char** argv) {
   }
 
   // Phase 8: Load plugin using runner
-  if (cli.headless && s.selected_idx >= 0 && s.runner) {
+  if ((cli.headless || cli.latency_probe > 0) && s.selected_idx >= 0 && s.runner) {
     auto path = s.plugin_metas[s.selected_idx].path;
-    if (s.runner->load(path)) {
+    if (load_plugin(s, path)) {
       s.plugin_loaded = true;
       auto pos = path.find_last_of("/\\");
       s.current_plugin_leaf = (pos==std::string::npos)? path : path.substr(pos+1);
@@ -604,6 +1086,9 @@ int main(int argc, char** argv) {
   s.watchdog.start(&s.app_running, &s.in_plugin_call, &s.plugin_call_start,
                    s.settings.stall_ms,
                    [&](){
+                     s.tracer.name_thread("watchdog");
+                     s.tracer.instant("watchdog.stall", "watchdog");
+                     s.flight.request("watchdog");
                      if (s.runtime.loaded) {
                        s.runtime.unload();
                        s.plugin_loaded = false;
@@ -612,28 +1097,53 @@ int main(int argc, char** argv) {
                      }
                    });
 
+  if (cli.latency_probe > 0) {
+    if (!s.plugin_loaded) {
+      std::fprintf(stderr, "Latency probe: plugin '%s' not found in %s\n", cli.plugin.c_str(), s.plugins_dir.c_str());
+      s.app_running.store(false);
+      s.watchdog.stop();
+      shutdown(s);
+      return 1;
+    }
+    s.probe.start(cli.latency_probe);
+    std::printf("Latency probe: %d samples (plugin %s)\n", cli.latency_probe, s.current_plugin_leaf.c_str());
+  }
+
   const double target_dt = 1.0 / static_cast<double>(s.cfg.target_fps);
   auto last = std::chrono::high_resolution_clock::now();
   double acc = 0.0;
 
   while (s.running) {
+    GPI_ZONE_FRAME();
+    s.flight.poll();
+    TraceScope frame_span(s.tracer, "frame");
+    // Late latching: idle here rather than after present, so the input
+    // below is as fresh as the predicted frame cost allows
+    {
+      TraceScope span(s.tracer, "pacer.wait");
+      s.pacer.begin_frame();
+    }
     auto start_frame = std::chrono::high_resolution_clock::now();
 
+    switch (s.probe.before_input(mono_ns())) {
+      case LatencyProbe::Action::Press:   push_probe_click(s, true); break;
+      case LatencyProbe::Action::Release: push_probe_click(s, false); break;
+      case LatencyProbe::Action::None:    break;
+    }
+
     InputSnapshot in{};
-    poll_input(in, s);
+    {
+      TraceScope span(s.tracer, "poll_input");
+      poll_input(in, s);
+    }
         if (in.key_escape || in.quit) s.running = false;
         if (in.toggle_hud) s.hud_visible = !s.hud_visible;
         
-        const Uint8* ks = SDL_GetKeyboardState(nullptr);
-        if (ks[SDL_SCANCODE_F9]) save_artifacts_now(s);
-        if (ks[SDL_SCANCODE_F12]) {
-          std::string ts = timestamp();
-          std::string path = "artifacts/snap-" + ts + ".png";
-          int w, h; SDL_GetWindowSize(s.window, &w, &h);
-          if (save_screenshot_png(path, w, h)) {
-            s.toasts.info("Screenshot saved: " + path);
-          }
-        }
+        if (in.save_artifacts) save_artifacts_now(s);
+        if (in.screenshot) request_screenshot(s);
+        // Hand finished PBO readbacks to the encoder; never blocks
+        s.shots.poll();
+        s.video.poll();
 
     auto now = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> delta = now - last;
@@ -648,42 +1158,58 @@ int main(int argc, char** argv) {
 
     // Phase 8: Handle replay/record and plugin update
     ReplayFrame rf;
-    GPI_InputV1 ib = make_input_blob(in);
-    std::vector<uint8_t> ib_bytes(sizeof(GPI_InputV1));
-    std::memcpy(ib_bytes.data(), &ib, sizeof(GPI_InputV1));
-
     FrameArgs fa{};
     if (s.replayer.active() && s.replayer.next(rf)) {
       // Replay mode: use recorded data
       fa.dt_sec = rf.dt_sec; fa.fb_w = rf.fb_w; fa.fb_h = rf.fb_h; fa.t_ns = rf.t_ns;
       fa.input_blob = rf.input.data(); fa.input_size = (uint32_t)rf.input.size(); fa.input_version = GPI_INPUT_VERSION;
+      if (rf.input.size() >= offsetof(GPI_InputV2, events)) {
+        // V2 frames are stored trimmed to their events; restore the full blob
+        s.input_v2 = GPI_InputV2{};
+        std::memcpy(&s.input_v2, rf.input.data(), std::min(rf.input.size(), sizeof(GPI_InputV2)));
+        const size_t stored = (rf.input.size() - offsetof(GPI_InputV2, events)) / sizeof(GPI_InputEventV2);
+        s.input_v2.event_count = std::min<uint32_t>(s.input_v2.event_count, (uint32_t)std::min<size_t>(stored, GPI_INPUT_V2_MAX_EVENTS));
+        fa.input_blob = &s.input_v2; fa.input_size = sizeof(GPI_InputV2);
+      }
     } else {
       // Live mode
       fa.dt_sec = s.cfg.fixed_timestep ? (float)target_dt : (float)delta.count();
       int w,h; SDL_GetWindowSize(s.window,&w,&h); fa.fb_w=w; fa.fb_h=h;
-      fa.t_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
-                  std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-      fa.input_blob = ib_bytes.data(); fa.input_size = (uint32_t)ib_bytes.size(); fa.input_version = GPI_INPUT_VERSION;
+      fa.t_ns = mono_ns();   // same clock as the event timestamps
+      // Plugins read the host's blob in place (in-process runner)
+      make_input_blob(in, s.input_v2);
+      fa.input_blob = &s.input_v2; fa.input_size = sizeof(GPI_InputV2); fa.input_version = GPI_INPUT_VERSION;
 
       if (s.recorder.active()) {
-        ReplayFrame add{ fa.t_ns, fa.fb_w, fa.fb_h, fa.dt_sec, ib_bytes };
+        const auto* p = (const uint8_t*)&s.input_v2;
+        const size_t used = offsetof(GPI_InputV2, events) + s.input_v2.event_count * sizeof(GPI_InputEventV2);
+        ReplayFrame add{ fa.t_ns, fa.fb_w, fa.fb_h, fa.dt_sec, std::vector<uint8_t>(p, p + used) };
         s.recorder.add(add);
       }
     }
 
     // Phase 9: UPDATE using runner with per-call metrics
+    double update_ms = 0.0, render_ms = 0.0;
     if (s.plugin_loaded && s.runner) {
       s.in_plugin_call.store(true, std::memory_order_relaxed);
       s.plugin_call_start.store(std::chrono::steady_clock::now(), std::memory_order_relaxed);
+      const int64_t span_t0 = Tracer::now_ns();
       auto start = std::chrono::high_resolution_clock::now();
       bool ok = s.runner->update(fa);
       if (s.simulate_stall) SDL_Delay((Uint32)s.stall_ms);
       auto end = std::chrono::high_resolution_clock::now();
+      const int64_t span_t1 = Tracer::now_ns();
+      s.tracer.span("plugin.update", "plugin", span_t0, span_t1);
+      if (PluginTraceBuf* tb = s.runner->trace_buffer()) s.plugin_zones.collect(*tb, s.tracer, span_t0, span_t1);
+      if (PluginProfileBuf* pb = s.runner->profile_buffer()) s.perf_calls.profile.collect(*pb, s.current_plugin_leaf, "update");
       s.in_plugin_call.store(false, std::memory_order_relaxed);
       
       if (ok) {
         double ms = std::chrono::duration<double, std::milli>(end - start).count();
         s.perf_calls.upd.push(ms);
+        s.perf_calls.add_counters(s.current_plugin_leaf, "update", s.runner->last_counters());
+        s.telemetry.mark("call.update_ms", ms);   // per-call distribution for gpi_perfdiff
+        update_ms = ms;
       } else {
         s.runner->unload();
         s.plugin_loaded = false;
@@ -695,42 +1221,56 @@ int main(int argc, char** argv) {
 
     // Call ImGui new_frame only in GUI mode
     if (!cli.headless) {
+      TraceScope span(s.tracer, "imgui.new_frame");
       s.imgui.new_frame(s.window);
     }
 
     int w, h; SDL_GetWindowSize(s.window, &w, &h);
-    glViewport(0, 0, w, h);
-    glClearColor(0.10f, 0.10f, 0.12f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+    s.glyph_cache.begin_frame();
+    if (s.soft) {
+      TraceScope span(s.tracer, "drawlist");
+      // Same clear colour as the GL path, packed 0xAABBGGRR
+      s.soft->begin(w, h, 0xFF1F1A1Au);
+      if (s.dl_host) render_drawlist_v1_soft(s.dl_host, *s.soft);
+      if (s.dl15_host) render_drawlist_v15_soft(s.dl15_host, s.host_font, *s.soft);
+      if (s.dl2_host) note_dl2_result(s, render_drawlist_v2_soft(s.dl2_host, s.dl2_map.bytes, s.host_font, s.images, *s.soft));
+    } else {
+      TraceScope span(s.tracer, "drawlist");
+      glViewport(0, 0, w, h);
+      glClearColor(0.10f, 0.10f, 0.12f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT);
 
-    // Phase 12: Render draw list (only in GUI mode)
-    if (!cli.headless && s.dl_host) {
-      render_drawlist_v1(s.dl_host);
-    }
-    
-    // Phase 13: Render draw list v1.5 (only in GUI mode)
-    if (!cli.headless && s.dl15_host) {
-      render_drawlist_v15(s.dl15_host, s.host_font);
+      // Phase 12: Render draw list
+      if (s.dl_host) render_drawlist_v1(s.dl_host);
+
+      // Phase 13: Render draw list v1.5
+      if (s.dl15_host) render_drawlist_v15(s.dl15_host, s.host_font);
+
+      // DrawList V2 command stream
+      if (s.dl2_host) note_dl2_result(s, render_drawlist_v2(s.dl2_host, s.dl2_map.bytes, s.host_font, s.images));
     }
 
     // Phase 9: RENDER using runner with per-call metrics
     if (s.plugin_loaded && s.runner) {
       s.in_plugin_call.store(true, std::memory_order_relaxed);
       s.plugin_call_start.store(std::chrono::steady_clock::now(), std::memory_order_relaxed);
+      const int64_t span_t0 = Tracer::now_ns();
       auto start = std::chrono::high_resolution_clock::now();
       bool ok = s.runner->render();
       if (s.simulate_stall) SDL_Delay((Uint32)s.stall_ms);
       auto end = std::chrono::high_resolution_clock::now();
+      const int64_t span_t1 = Tracer::now_ns();
+      s.tracer.span("plugin.render", "plugin", span_t0, span_t1);
+      if (PluginTraceBuf* tb = s.runner->trace_buffer()) s.plugin_zones.collect(*tb, s.tracer, span_t0, span_t1);
+      if (PluginProfileBuf* pb = s.runner->profile_buffer()) s.perf_calls.profile.collect(*pb, s.current_plugin_leaf, "render");
       s.in_plugin_call.store(false, std::memory_order_relaxed);
       
       if (ok) {
         double ms = std::chrono::duration<double, std::milli>(end - start).count();
         s.perf_calls.ren.push(ms);
-        
-        // Phase 9: Video recording
-        if (s.record_video) {
-          save_frame_sequence_png(s.video_dir, s.video_frame_idx++, w, h);
-        }
+        s.perf_calls.add_counters(s.current_plugin_leaf, "render", s.runner->last_counters());
+        s.telemetry.mark("call.render_ms", ms);
+        render_ms = ms;
       } else {
         s.runner->unload();
         s.plugin_loaded = false;
@@ -743,6 +1283,9 @@ int main(int argc, char** argv) {
     const auto end_logic = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::milli> frame_ms = end_logic - start_frame;
     s.hist.push(frame_ms.count());
+    s.flight.frame(FlightRecorder::Frame{ Tracer::now_ns(), (float)frame_ms.count(), (float)update_ms, (float)render_ms },
+                   s.input_v2, s.hist.budget_ms());
+    s.procs.set_child(s.runner ? s.runner->child_pid() : 0);
     
     // Phase 10: Demo timeline
     if (s.demo_mode) {
@@ -752,7 +1295,7 @@ int main(int argc, char** argv) {
         // Hot-swap to next plugin
         int next = (s.selected_idx + 1) % (int)s.plugin_metas.size();
         s.runner->unload();
-        if (s.runner->load(s.plugin_metas[next].path)) {
+        if (load_plugin(s, s.plugin_metas[next].path)) {
           s.selected_idx = next;
           s.plugin_loaded = true;
           auto pos = s.plugin_metas[next].path.find_last_of("/\\");
@@ -760,27 +1303,25 @@ int main(int argc, char** argv) {
           save_artifacts_now(s);
           
           // Screenshot
-          save_screenshot_png("artifacts/demo_snap.png", w, h);
+          s.shot_paths.push_back("artifacts/demo_snap.png");
           
           // Start video sequence
-          s.video_dir = "artifacts/demo_video";
-          s.record_video = true;
-          s.video_frame_idx = 0;
+          start_video(s, "artifacts/demo_video.y4m", 1);
           s.demo_swapped = true;
         }
       }
       
-      if (s.record_video) {
-        save_frame_sequence_png(s.video_dir, s.video_frame_idx++, w, h);
-        if (s.video_frame_idx >= 60) {
-          s.record_video = false;
+      if (s.video.active()) {
+        if (s.video.stats().offered >= 60) {
+          s.video.stop();
           save_artifacts_now(s);
           s.running = false; // Exit demo
         }
       }
     }
-    // Draw HUD and UI only in GUI mode
-    if (!cli.headless) {
+    // Draw HUD and UI only in GUI mode; the probe needs an unobstructed frame
+    if (!cli.headless && !s.probe.active()) {
+      TraceScope span(s.tracer, "hud");
       draw_hud(s, s.hist.stats());
       draw_plugin_panel(s);
       if (s.show_store) {
@@ -792,36 +1333,12 @@ int main(int argc, char** argv) {
           auto path = s.plugin_metas[s.selected_idx].path;
           printf("DEBUG: Attempting to load plugin: %s\n", path.c_str());
           printf("DEBUG: Runner exists: %s\n", s.runner ? "yes" : "no");
-          if (s.runner->load(path)) {
+          if (load_plugin(s, path)) {
             s.plugin_loaded = true;
             auto pos = path.find_last_of("/\\");
             s.current_plugin_leaf = (pos==std::string::npos)? path : path.substr(pos+1);
             std::snprintf(s.plugin_status, sizeof(s.plugin_status), "Loaded: %s", s.plugin_metas[s.selected_idx].name.c_str());
             s.toasts.info("Plugin loaded");
-            
-            // Phase 12: Initialize draw list
-            std::random_device rd;
-            std::string dl_name = "gpi_dl_" + std::to_string(rd());
-            uint32_t dl_bytes = sizeof(GPI_DrawListV1) + 4096 * sizeof(GPI_QuadV1);
-            if (dl_create_host(s.dl_map, dl_name, dl_bytes)) {
-              s.dl_host = (GPI_DrawListV1*)s.dl_map.base;
-              s.dl_host->magic = GPI_DL_MAGIC;
-              s.dl_host->version = 0x00010000;
-              s.dl_host->max_quads = 4096;
-              s.dl_host->quad_count = 0;
-            }
-            
-            // Phase 13: Initialize draw list v1.5
-            const uint32_t MAXQ=4096, MAXT=1024, UTF8=64*1024;
-            uint32_t dl15_bytes = sizeof(GPI_DrawListV15) + MAXQ*sizeof(GPI_QuadV1) + MAXT*sizeof(GPI_TextRunV15) + UTF8;
-            s.dl15_host = (GPI_DrawListV15*)std::malloc(dl15_bytes);
-            if (s.dl15_host) {
-              s.dl15_host->magic = GPI_DL15_MAGIC;
-              s.dl15_host->version = GPI_DL15_VERSION;
-              s.dl15_host->max_quads = MAXQ; s.dl15_host->quad_count = 0;
-              s.dl15_host->max_text = MAXT; s.dl15_host->text_count = 0;
-              s.dl15_host->utf8_capacity = UTF8; s.dl15_host->utf8_size = 0;
-            }
           } else {
             std::snprintf(s.plugin_status, sizeof(s.plugin_status), "Load failed: %s", s.runner->last_error());
             s.toasts.error("Load failed");
@@ -830,41 +1347,104 @@ int main(int argc, char** argv) {
       }
       s.perf_calls.draw_small();
       s.log_panel.draw(s.logs);
+      s.zone_view.draw();
       s.toasts.render();
 
-      // Periodically flush telemetry to artifacts
+      // Every 5 s append the telemetry drained since the last append
       static double last_flush = 0.0;
       static double acc_time = 0.0;
       acc_time += frame_ms.count() / 1000.0;
       if (acc_time - last_flush > 5.0) {
-        s.telemetry.flush_csv("artifacts/telemetry.csv");
-        s.telemetry.flush_json("artifacts/telemetry.json");
+        Telemetry* tel = &s.telemetry;
+        s.writer.submit([tel]{ return tel->append_csv("artifacts/telemetry.csv"); });
         last_flush = acc_time;
       }
     }
     
     // Call ImGui render only in GUI mode
+    // Captures read the finished back buffer: plugin draw lists live in
+    // ImGui's background list, so they only exist after imgui.render()
     if (!cli.headless) {
-      s.imgui.render();
+      {
+        TraceScope span(s.tracer, "imgui.render");
+        s.imgui.render();
+      }
+      {
+        TraceScope span(s.tracer, "captures");
+        take_frame_captures(s, w, h);
+        s.probe.read_gl(w, h);
+      }
+      s.pacer.mark_present();
+      {
+        TraceScope span(s.tracer, "swap");
+        SDL_GL_SwapWindow(s.window);
+      }
+      note_present(s, in, mono_ns());
+    } else if (s.soft) {
+      {
+        TraceScope span(s.tracer, "soft.resolve");
+        s.soft->end();
+      }
+      s.pacer.mark_present();
+      {
+        TraceScope span(s.tracer, "captures");
+        take_frame_captures(s, w, h);
+      }
+      note_present(s, in, mono_ns());
+    }
+
+    // Frame boundary: hold the cadence (capped) and record how far off it was
+    double pace_err_ms = 0.0;
+    {
+      TraceScope span(s.tracer, "pacer.end_frame");
+      if (s.pacer.end_frame(pace_err_ms)) s.hist.push_pacing_error(pace_err_ms);
     }
-    SDL_GL_SwapWindow(s.window);
 
     // Count frames and exit if reached
     static int frame_counter=0;
     frame_counter++;
     
-    // Phase 14: Golden capture
-    // if (!cli.golden_capture.empty() && cli.headless) {
-    //   // Check if this frame should be captured (simple check for now)
-    //   if (frame_counter == 120 || frame_counter == 240) {
-    //     int w, h;
-    //     SDL_GetWindowSize(s.window, &w, &h);
-    //     char path[256];
-    //     std::snprintf(path, sizeof(path), "%s/frame_%06d.png", cli.golden_capture.c_str(), frame_counter);
-    //     save_screenshot_png(path, w, h);
-    //   }
-    // }
-    
+    // Phase 14: Golden capture/verify; diffs run on the golden pool while we keep replaying
+    if (s.golden && s.soft) {
+      if (s.golden->wants(frame_counter))
+        s.golden->submit(frame_counter, s.soft->pixels(), s.soft->width(), s.soft->height());
+      if (frame_counter >= s.golden->last_frame()) {
+        s.app_running.store(false);
+        if (s.recorder.active()) s.recorder.stop();
+        if (s.runner) s.runner->unload();
+        s.watchdog.stop();
+        std::string report_path;
+        const bool pass = s.golden->finish(report_path);
+        const bool capture = !cli.golden_capture.empty();
+        std::printf("Golden %s %s\n", capture ? "capture" : "verification", pass ? "PASSED" : "FAILED");
+        std::printf("%s: %s\n", capture ? "Frames" : "Report", report_path.c_str());
+        shutdown(s);
+        return pass ? 0 : 1;
+      }
+    }
+
+    if (s.probe.done()) {
+      const auto pl = s.probe.hist().stats();
+      std::printf("Input-to-photon: median %.2f ms  p95 %.2f ms  p99 %.2f ms  max %.2f ms  (%d samples, %d timeouts)\n",
+                  pl.p50_ms, pl.p95_ms, pl.p99_ms, pl.max_ms, pl.samples, s.probe.timeouts());
+      save_artifacts_now(s);
+      s.app_running.store(false);
+      if (s.runner) s.runner->unload();
+      s.watchdog.stop();
+      shutdown(s);
+      return 0;
+    }
+    if (s.probe.failed()) {
+      std::fprintf(stderr, "Latency probe failed: %d timeouts, %d of %d samples; the probe never saw the "
+                   "centre pixel flip (plugin ignoring clicks?)\n",
+                   s.probe.timeouts(), s.probe.hist().count(), cli.latency_probe);
+      s.app_running.store(false);
+      if (s.runner) s.runner->unload();
+      s.watchdog.stop();
+      shutdown(s);
+      return 1;
+    }
+
     if (cli.headless && cli.frames>0 && frame_counter>=cli.frames) {
       save_artifacts_now(s);
       auto st = s.hist.stats();
@@ -1,63 +1,109 @@
 #pragma once
 #include <vector>
-#include <algorithm>
-#include <numeric>
 #include <cstdint>
+#include "services/log_histogram.h"
 
 struct FrameStats {
   double fps = 0.0;
   double avg_ms = 0.0;
+  double p50_ms = 0.0;
+  double p90_ms = 0.0;
   double p95_ms = 0.0;
   double p99_ms = 0.0;
+  double p999_ms = 0.0;
+  double max_ms = 0.0;
   double dropped_pct = 0.0;
+  // |actual frame interval - target period|, from the frame pacer
+  double pace_avg_ms = 0.0;
+  double pace_p99_ms = 0.0;
 };
 
+struct LatencyStats {
+  double p50_ms = 0.0;
+  double p95_ms = 0.0;
+  double p99_ms = 0.0;
+  double max_ms = 0.0;
+  int samples = 0;            // total pushed (stats cover the most recent cap)
+};
+
+// Recent latency samples in ms (input event -> present, probe flips).
+class LatencyHistogram {
+public:
+  explicit LatencyHistogram(std::size_t cap = 2048) : win_(cap) {}
+
+  void push(double ms) { win_.push(ms); ++total_; }
+
+  LatencyStats stats() const {
+    const Percentiles p = win_.stats();
+    LatencyStats s{};
+    s.samples = total_;
+    s.p50_ms = p.p50; s.p95_ms = p.p95; s.p99_ms = p.p99; s.max_ms = p.max;
+    return s;
+  }
+
+  int count() const { return total_; }
+  void reset() { win_.reset(); total_ = 0; }
+
+private:
+  WindowedHistogram win_;
+  int total_ = 0;
+};
+
+// Frame times over a sliding window. push() is O(1); stats() is one pass
+// over the log buckets, cheap enough for the HUD to call every frame.
 class FrameHistogram {
 public:
   explicit FrameHistogram(std::size_t cap = 600, double budget_ms = 16.6)
-    : cap_(cap), budget_ms_(budget_ms) { samples_.reserve(cap_); }
+    : frames_(cap), pace_(cap), budget_ms_(budget_ms) {}
 
   void push(double ms) {
-    if (samples_.size() == cap_) samples_.erase(samples_.begin());
-    samples_.push_back(ms);
+    double old = 0.0;
+    if (frames_.push(ms, &old) && old > budget_ms_ && dropped_ > 0) dropped_--;
     total_time_sec_ += ms / 1000.0;
     if (ms > budget_ms_) dropped_++;
   }
 
+  void push_pacing_error(double err_ms) { pace_.push(err_ms < 0.0 ? -err_ms : err_ms); }
+
   FrameStats stats() const {
     FrameStats s{};
-    if (samples_.empty()) return s;
-
-    std::vector<double> tmp(samples_);
-    std::sort(tmp.begin(), tmp.end());
-    const auto n = tmp.size();
+    const auto n = frames_.size();
+    if (n == 0) return s;
 
-    const auto sum = std::accumulate(tmp.begin(), tmp.end(), 0.0);
-    s.avg_ms = sum / static_cast<double>(n);
-    s.p95_ms = tmp[static_cast<std::size_t>(0.95 * (n - 1))];
-    s.p99_ms = tmp[static_cast<std::size_t>(0.99 * (n - 1))];
+    const Percentiles p = frames_.stats();
+    s.avg_ms = p.avg;
+    s.p50_ms = p.p50; s.p90_ms = p.p90; s.p95_ms = p.p95;
+    s.p99_ms = p.p99; s.p999_ms = p.p999; s.max_ms = p.max;
 
     s.fps = (s.avg_ms > 0.0) ? 1000.0 / s.avg_ms : 0.0;
+    s.dropped_pct = static_cast<double>(dropped_) / static_cast<double>(n) * 100.0;
 
-    const double drop = (n > 0) ? (static_cast<double>(dropped_) / static_cast<double>(n)) : 0.0;
-    s.dropped_pct = drop * 100.0;
+    if (pace_.size() > 0) {
+      const Percentiles pe = pace_.stats();
+      s.pace_avg_ms = pe.avg;
+      s.pace_p99_ms = pe.p99;
+    }
     return s;
   }
 
   void reset() {
-    samples_.clear();
+    frames_.reset();
+    pace_.reset();
     dropped_ = 0;
     total_time_sec_ = 0.0;
   }
 
   double budget_ms() const { return budget_ms_; }
   void set_budget_ms(double ms) { budget_ms_ = ms; }
-  const std::vector<double>& samples() const { return samples_; }
+  // Window contents, oldest first (copies; for exports, not per frame)
+  std::vector<double> samples() const { return frames_.samples(); }
+  std::vector<double> pacing_errors() const { return pace_.samples(); }
+  const LogHistogram& snapshot() const { return frames_.snapshot(); }
   FrameStats stats_for_summary() const { return stats(); }
 
 private:
-  std::vector<double> samples_;
-  std::size_t cap_;
+  WindowedHistogram frames_;
+  WindowedHistogram pace_;
   double budget_ms_;
   std::size_t dropped_ = 0;
   double total_time_sec_ = 0.0;
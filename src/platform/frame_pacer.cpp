@@ -0,0 +1,146 @@
+#include "frame_pacer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#if defined(__linux__)
+  #include <cerrno>
+  #include <time.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+  #include <immintrin.h>
+  static inline void cpu_relax() { _mm_pause(); }
+#elif defined(__aarch64__)
+  static inline void cpu_relax() { asm volatile("yield"); }
+#else
+  static inline void cpu_relax() {}
+#endif
+
+bool parse_pacing_mode(const std::string& s, PacingMode& out) {
+  if (s == "vsync") out = PacingMode::VSync;
+  else if (s == "capped") out = PacingMode::Capped;
+  else if (s == "uncapped") out = PacingMode::Uncapped;
+  else return false;
+  return true;
+}
+
+const char* pacing_mode_name(PacingMode m) {
+  switch (m) {
+    case PacingMode::VSync: return "vsync";
+    case PacingMode::Capped: return "capped";
+    case PacingMode::Uncapped: return "uncapped";
+  }
+  return "?";
+}
+
+void FramePacer::configure(PacingMode mode, double hz, bool late_latch) {
+  mode_ = mode;
+  late_ = late_latch && mode != PacingMode::Uncapped;
+  period_ns_ = (int64_t)std::llround(1e9 / std::clamp(hz, 1.0, 1000.0));
+  deadline_ns_ = last_ns_ = latch_ns_ = present_ns_ = 0;
+  work_n_ = work_head_ = 0;
+  work_p99_ns_ = 0;
+  latch_margin_ns_ = 1e6;
+}
+
+int64_t FramePacer::now_ns() {
+#if defined(__linux__)
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void FramePacer::sleep_until(int64_t t_ns) {
+#if defined(__linux__)
+  timespec ts{ (time_t)(t_ns / 1000000000), (long)(t_ns % 1000000000) };
+  // Only a signal is worth retrying; on any other error (EINVAL) return and
+  // let wait_until() spin out the rest
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+#else
+  std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(t_ns)));
+#endif
+}
+
+void FramePacer::wait_until(int64_t t_ns) {
+  int64_t now = now_ns();
+  const int64_t wake = t_ns - (int64_t)margin_ns_;
+  if (wake > now) {
+    sleep_until(wake);
+    now = now_ns();
+    // Track timer oversleep (mean + deviation, RTT-estimator style) and
+    // keep the spin margin just above its tail.
+    const double over = (double)(now - wake);
+    const double d = over - over_mean_;
+    over_mean_ += d / 8.0;
+    over_dev_ += (std::fabs(d) - over_dev_) / 4.0;
+    margin_ns_ = std::clamp(over_mean_ + 4.0 * over_dev_ + 50e3, 100e3, 3e6);
+  }
+  while (now_ns() < t_ns) cpu_relax();
+}
+
+void FramePacer::begin_frame() {
+  if (!late_) return;
+  if (deadline_ns_) {
+    // Predicted cost: p99 of recent latch->present times plus the margin,
+    // never more than a whole period (then there is nothing to wait for).
+    const double predict = std::min(work_p99_ns_ + latch_margin_ns_, (double)period_ns_);
+    wait_until(deadline_ns_ - (int64_t)predict);
+  }
+  latch_ns_ = now_ns();
+  if (!deadline_ns_) deadline_ns_ = latch_ns_ + period_ns_;
+}
+
+void FramePacer::mark_present() {
+  present_ns_ = now_ns();
+}
+
+bool FramePacer::end_frame(double& err_ms) {
+  const int64_t arrive = now_ns();
+  if (late_ && latch_ns_) {
+    // Work sample: latch -> present (vsync swaps block) or latch -> now.
+    const int64_t done = (mode_ == PacingMode::VSync && present_ns_ > latch_ns_) ? present_ns_ : arrive;
+    work_[work_head_] = done - latch_ns_;
+    work_head_ = (work_head_ + 1) % kWorkRing;
+    if (work_n_ < kWorkRing) ++work_n_;
+    int64_t tmp[kWorkRing];
+    std::copy(work_, work_ + work_n_, tmp);
+    const int k = (work_n_ - 1) * 99 / 100;
+    std::nth_element(tmp, tmp + k, tmp + work_n_);
+    work_p99_ns_ = (double)tmp[k];
+  }
+
+  if (mode_ == PacingMode::Capped) {
+    if (!deadline_ns_) deadline_ns_ = arrive + period_ns_;
+    const bool late_frame = arrive > deadline_ns_;
+    if (late_frame) ++missed_;
+    if (late_) {
+      latch_margin_ns_ = late_frame ? std::min(latch_margin_ns_ * 2.0, period_ns_ * 0.5)
+                                    : std::max(latch_margin_ns_ * 0.99, 250e3);
+    }
+    wait_until(deadline_ns_);
+    deadline_ns_ += period_ns_;
+    // More than a frame behind: start a new cadence instead of bursting to catch up
+    if (arrive - deadline_ns_ > 0) deadline_ns_ = arrive + period_ns_;
+  }
+
+  const int64_t t = now_ns();
+  if (mode_ == PacingMode::VSync) {
+    // Swap returned at (about) a vblank; a gap of 1.5 periods means one was skipped.
+    if (last_ns_ && t - last_ns_ > period_ns_ * 3 / 2) {
+      ++missed_;
+      if (late_) latch_margin_ns_ = std::min(latch_margin_ns_ * 2.0, period_ns_ * 0.5);
+    } else if (late_) {
+      latch_margin_ns_ = std::max(latch_margin_ns_ * 0.99, 250e3);
+    }
+    deadline_ns_ = t + period_ns_;
+  }
+
+  const bool have = last_ns_ != 0 && mode_ != PacingMode::Uncapped;
+  if (have) err_ms = (double)(t - last_ns_ - period_ns_) / 1e6;
+  last_ns_ = t;
+  return have;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// vsync:    the swap blocks on the display; the pacer only measures.
+// capped:   swap interval 0, the pacer holds frames to target_fps.
+// uncapped: no waiting at all (benchmarks).
+enum class PacingMode { VSync, Capped, Uncapped };
+
+bool parse_pacing_mode(const std::string& s, PacingMode& out);
+const char* pacing_mode_name(PacingMode m);
+
+// Ends frames on a fixed cadence. In capped mode it sleeps on an absolute
+// monotonic deadline (clock_nanosleep where available) until shortly before
+// the frame is due, then spins the remainder. The spin margin follows the
+// observed oversleep of the OS timer, so wakeups land within ~0.1 ms while
+// the thread stays asleep for most of the idle time.
+//
+// Late latching moves the idle time to the top of the frame: begin_frame()
+// sleeps until (next deadline - predicted work), so input is polled as close
+// to present as the measured p99 frame cost allows. The extra safety margin
+// doubles on every missed deadline and decays slowly while frames land.
+class FramePacer {
+public:
+  void configure(PacingMode mode, double hz, bool late_latch = false);
+
+  // Top of the frame, before polling input. No-op unless late latching.
+  void begin_frame();
+  // Right before present (swap / soft raster end): closes the work sample
+  // so time blocked in a vsync swap is not counted as frame cost.
+  void mark_present();
+  // Call once per frame, after present. Returns true and sets err_ms to the
+  // measured frame interval minus the target period when that is meaningful
+  // (not uncapped, not the first frame).
+  bool end_frame(double& err_ms);
+
+  PacingMode mode() const { return mode_; }
+  bool late_latch() const { return late_; }
+  double hz() const { return 1e9 / (double)period_ns_; }
+  double spin_margin_ms() const { return margin_ns_ / 1e6; }
+  double work_p99_ms() const { return work_p99_ns_ / 1e6; }
+  double latch_margin_ms() const { return latch_margin_ns_ / 1e6; }
+  uint64_t missed() const { return missed_; }
+
+private:
+  static constexpr int kWorkRing = 128;
+
+  static int64_t now_ns();
+  static void sleep_until(int64_t t_ns);
+  void wait_until(int64_t t_ns);   // sleep + calibrated spin
+
+  PacingMode mode_ = PacingMode::VSync;
+  bool late_ = false;
+  int64_t period_ns_ = 16666667;
+  int64_t deadline_ns_ = 0;  // present deadline of the frame in progress
+  int64_t last_ns_ = 0;      // previous frame boundary
+  double margin_ns_ = 1e6;   // wake this early and spin
+  double over_mean_ = 0, over_dev_ = 0;
+
+  // Late latching
+  int64_t latch_ns_ = 0, present_ns_ = 0;
+  int64_t work_[kWorkRing] = {};
+  int work_n_ = 0, work_head_ = 0;
+  double work_p99_ns_ = 0;
+  double latch_margin_ns_ = 1e6;
+  uint64_t missed_ = 0;
+};
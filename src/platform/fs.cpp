@@ -7,6 +7,9 @@
   #include <windows.h>
 #else
   #include <dirent.h>
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
 #endif
 
 namespace fsu {
@@ -64,4 +67,44 @@ std::vector<std::string> list_shared_libs(const std::string& dir) {
 #endif
   return out;
 }
+
+bool map_readonly(const std::string& path, MappedFile& out) {
+  out = MappedFile{};
+#if defined(_WIN32)
+  HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                         FILE_ATTRIBUTE_NORMAL, NULL);
+  if (f == INVALID_HANDLE_VALUE) return false;
+  LARGE_INTEGER sz{};
+  if (!GetFileSizeEx(f, &sz) || sz.QuadPart <= 0) { CloseHandle(f); return false; }
+  HANDLE m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(f);
+  if (!m) return false;
+  void* base = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+  if (!base) { CloseHandle(m); return false; }
+  out.data = (const uint8_t*)base; out.size = (std::size_t)sz.QuadPart; out.handle = m;
+  return true;
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) return false;
+  struct stat st{};
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) { ::close(fd); return false; }
+  void* base = mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) return false;
+  out.data = (const uint8_t*)base; out.size = (std::size_t)st.st_size;
+  return true;
+#endif
+}
+
+void unmap(MappedFile& m) {
+  if (m.data) {
+#if defined(_WIN32)
+    UnmapViewOfFile(m.data);
+    CloseHandle((HANDLE)m.handle);
+#else
+    munmap((void*)m.data, m.size);
+#endif
+  }
+  m = MappedFile{};
+}
 }
@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -6,4 +8,13 @@ namespace fsu {
 std::string join(const std::string& a, const std::string& b);
 bool is_regular_file(const std::string& path);
 std::vector<std::string> list_shared_libs(const std::string& dir);
+
+// Read-only view of a whole file (mmap / MapViewOfFile). Empty files fail.
+struct MappedFile {
+  const uint8_t* data = nullptr;
+  std::size_t size = 0;
+  void* handle = nullptr;  // Windows mapping handle
+};
+bool map_readonly(const std::string& path, MappedFile& out);
+void unmap(MappedFile& m);
 }
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+enum PerfEvent {
+  kPerfCycles, kPerfInstructions, kPerfL1dMisses, kPerfLlcMisses, kPerfBranchMisses,
+  kPerfEvents
+};
+
+struct PerfSample {
+  uint64_t v[kPerfEvents] = {};
+  uint32_t valid = 0;   // bit per PerfEvent
+};
+
+// Hardware counters of the calling thread, user mode only, as one
+// perf_event_open group so every event counts over the same instructions.
+// begin()/end() bracket a call. Each read uses rdpmc from user space where
+// the kernel allows it (x86, cap_user_rdpmc) and it is not trapped by a
+// hypervisor; otherwise it costs one read() of the group. If the PMU is
+// multiplexed, the whole group pauses together, so ratios (IPC, misses per
+// kilo-instruction) stay right even when the counts come out short. Linux
+// only: open() fails elsewhere, and also when there is no PMU (many VMs) or
+// perf_event_paranoid forbids it.
+class PerfCounters {
+public:
+  PerfCounters() = default;
+  ~PerfCounters() { close(); }
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // Cycles must open; the other events are dropped if unsupported
+  bool open(std::string& err);
+  void close();
+  bool active() const { return fd_[kPerfCycles] >= 0; }
+  bool uses_rdpmc() const { return rdpmc_; }
+  uint32_t valid() const { return valid_; }
+
+  void begin();
+  bool end(PerfSample& out);   // counts since begin()
+
+  static const char* name(int e);   // "cycles", "l1d_misses", ...
+
+private:
+  bool read_all(uint64_t (&out)[kPerfEvents]);
+  bool read_group(uint64_t (&out)[kPerfEvents]);
+
+  int fd_[kPerfEvents] = { -1, -1, -1, -1, -1 };
+  int slot_[kPerfEvents] = {};      // position in the group read()
+  void* page_[kPerfEvents] = {};    // perf_event_mmap_page, rdpmc only
+  uint32_t valid_ = 0;
+  bool rdpmc_ = false;
+  bool started_ = false;
+  uint64_t start_[kPerfEvents] = {};
+};
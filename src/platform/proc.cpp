@@ -4,6 +4,7 @@
 
 #ifdef _WIN32
 #include <windows.h>
+#include <psapi.h>
 #include <io.h>
 #include <fcntl.h>
 
@@ -57,23 +58,61 @@ bool read_line(const ChildProc& p, std::string& line) {
   line = buf;
   return true;
 }
+
+int self_pid() { return (int)GetCurrentProcessId(); }
+int child_pid(const ChildProc& p) { return p.handle ? (int)GetProcessId((HANDLE)p.handle) : 0; }
+
+static double filetime_s(const FILETIME& f) {
+  return (double)(((uint64_t)f.dwHighDateTime << 32) | f.dwLowDateTime) * 1e-7;
+}
+
+bool read_usage(int pid, ProcUsage& out) {
+  const bool self = pid == self_pid();
+  HANDLE h = self ? GetCurrentProcess()
+                  : OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | PROCESS_VM_READ, FALSE, (DWORD)pid);
+  if (!h) return false;
+  FILETIME created, exited, kernel, user;
+  PROCESS_MEMORY_COUNTERS mem{};
+  mem.cb = sizeof(mem);
+  const bool ok = GetProcessTimes(h, &created, &exited, &kernel, &user) &&
+                  K32GetProcessMemoryInfo(h, &mem, sizeof(mem));
+  if (!self) CloseHandle(h);
+  if (!ok) return false;
+  out = ProcUsage{};
+  out.cpu_s = filetime_s(kernel) + filetime_s(user);
+  out.rss_bytes = mem.WorkingSetSize;
+  out.minflt = mem.PageFaultCount;   // soft and hard faults together
+  return true;
+}
 }
 #else
 #include <unistd.h>
 #include <sys/wait.h>
 #include <sys/select.h>
 #include <signal.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <cstdlib>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
 
 namespace proc {
 bool spawn_child(const std::string& exe, const std::vector<std::string>& args, ChildProc& out) {
   int in[2], out_pipes[2];
   if (pipe(in) || pipe(out_pipes)) return false;
   
+  // argv is built before fork: the child may only make async-signal-safe calls
+  std::vector<char*> argv;
+  argv.push_back(const_cast<char*>(exe.c_str()));
+  for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+  argv.push_back(nullptr);
+
   pid_t pid = fork();
   if (pid == 0) {
     dup2(in[0], STDIN_FILENO);  dup2(out_pipes[1], STDOUT_FILENO);
     close(in[0]); close(in[1]); close(out_pipes[0]); close(out_pipes[1]);
-    execl(exe.c_str(), exe.c_str(), nullptr);
+    execv(exe.c_str(), argv.data());
     _exit(1);
   }
   if (pid < 0) { close(in[0]); close(in[1]); close(out_pipes[0]); close(out_pipes[1]); return false; }
@@ -105,5 +144,91 @@ bool read_line(const ChildProc& p, std::string& line) {
   line = buf;
   return true;
 }
+
+int self_pid() { return (int)getpid(); }
+int child_pid(const ChildProc& p) { return (int)(intptr_t)p.handle; }
+
+static double rusage_cpu_s(const rusage& ru) {
+  return (double)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1e-6;
+}
+
+#ifdef __linux__
+// A whole (small) /proc file, NUL-terminated; its length or -1
+static int slurp(const char* path, char* buf, int cap) {
+  const int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+  int n = 0;
+  for (ssize_t r; n < cap - 1 && (r = read(fd, buf + n, cap - 1 - n)) > 0;) n += (int)r;
+  close(fd);
+  buf[n] = 0;
+  return n;
+}
+
+// Number after key ("\nPss:"), 0 when missing
+static uint64_t field(const char* text, const char* key) {
+  const char* p = std::strstr(text, key);
+  return p ? std::strtoull(p + std::strlen(key), nullptr, 10) : 0;
+}
+
+bool read_usage(int pid, ProcUsage& out) {
+  static const long tck = sysconf(_SC_CLK_TCK);
+  static const long page = sysconf(_SC_PAGESIZE);
+  char path[64], buf[8192];
+  std::snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+  if (slurp(path, buf, sizeof(buf)) <= 0) return false;
+  // comm (field 2) may hold spaces and parentheses: parse after the last ')'
+  const char* rp = std::strrchr(buf, ')');
+  unsigned long long minflt, majflt, utime, stime;
+  if (!rp || std::sscanf(rp + 1, " %*c %*d %*d %*d %*d %*d %*u %llu %*u %llu %*u %llu %llu",
+                         &minflt, &majflt, &utime, &stime) != 4) return false;
+  ProcUsage u;
+  u.cpu_s = (double)(utime + stime) / (double)tck;
+  u.minflt = minflt; u.majflt = majflt;
+
+  unsigned long long resident = 0;
+  std::snprintf(path, sizeof(path), "/proc/%d/statm", pid);
+  if (slurp(path, buf, sizeof(buf)) > 0 && std::sscanf(buf, "%*u %llu", &resident) == 1)
+    u.rss_bytes = resident * (uint64_t)page;
+  // The kernel walks the page tables for this one; it is the costly read
+  std::snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", pid);
+  if (slurp(path, buf, sizeof(buf)) > 0) u.pss_bytes = field(buf, "\nPss:") * 1024;
+
+  if (pid == self_pid()) {
+    // All threads' switches (status counts the main thread only) and sub-tick CPU time
+    rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+      u.cpu_s = rusage_cpu_s(ru);
+      u.vcsw = (uint64_t)ru.ru_nvcsw; u.ivcsw = (uint64_t)ru.ru_nivcsw;
+    }
+  } else {
+    // gpi_child does its work on the main thread
+    std::snprintf(path, sizeof(path), "/proc/%d/status", pid);
+    if (slurp(path, buf, sizeof(buf)) > 0) {
+      u.vcsw = field(buf, "\nvoluntary_ctxt_switches:");
+      u.ivcsw = field(buf, "\nnonvoluntary_ctxt_switches:");
+    }
+  }
+  out = u;
+  return true;
+}
+#else
+bool read_usage(int pid, ProcUsage& out) {
+  if (pid != self_pid()) return false;   // no portable way into another process
+  rusage ru{};
+  if (getrusage(RUSAGE_SELF, &ru) != 0) return false;
+  ProcUsage u;
+  u.cpu_s = rusage_cpu_s(ru);
+  u.minflt = (uint64_t)ru.ru_minflt; u.majflt = (uint64_t)ru.ru_majflt;
+  u.vcsw = (uint64_t)ru.ru_nvcsw; u.ivcsw = (uint64_t)ru.ru_nivcsw;
+#ifdef __APPLE__
+  mach_task_basic_info info{};
+  mach_msg_type_number_t n = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &n) == KERN_SUCCESS)
+    u.rss_bytes = info.resident_size;
+#endif
+  out = u;
+  return true;
+}
+#endif
 }
 #endif
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -8,9 +9,24 @@ struct ChildProc {
   int   out_fd=-1;
 };
 
+struct ProcUsage {
+  double   cpu_s = 0.0;          // user + system, all threads
+  uint64_t rss_bytes = 0;
+  uint64_t pss_bytes = 0;        // Linux only
+  uint64_t minflt = 0, majflt = 0;
+  uint64_t vcsw = 0, ivcsw = 0;  // voluntary / involuntary context switches
+};
+
 namespace proc {
   bool spawn_child(const std::string& exe, const std::vector<std::string>& args, ChildProc& out);
   void kill_child(ChildProc& p);
   bool write_line(const ChildProc& p, const std::string& line);
   bool read_line(const ChildProc& p, std::string& line);
+
+  int self_pid();
+  int child_pid(const ChildProc& p);   // 0 when none is running
+  // Cumulative counters of a live process: /proc/<pid>/{stat,statm,status,
+  // smaps_rollup} on Linux plus getrusage() for ourselves. Elsewhere only
+  // what the OS offers (fields stay 0). False when it cannot be read.
+  bool read_usage(int pid, ProcUsage& out);
 }
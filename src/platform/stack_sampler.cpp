@@ -0,0 +1,153 @@
+#include "stack_sampler.h"
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#include <pthread.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+namespace {
+
+// Shared with the signal handler: plain loads and stores, no locks
+struct State {
+  static constexpr uint32_t kRing = 1024;
+  std::atomic<bool> owned{false};
+  std::atomic<bool> in_call{false};
+  uintptr_t stack_lo = 0, stack_hi = 0;   // of the sampled thread
+  std::atomic<uint32_t> head{0};          // handler
+  std::atomic<uint32_t> tail{0};          // drain()
+  std::atomic<uint64_t> dropped{0};
+  StackSampler::Stack ring[kRing];
+  timer_t timer{};
+  struct sigaction old{};
+};
+State g;
+
+void on_sigprof(int, siginfo_t*, void* ctx) {
+  if (!g.in_call.load(std::memory_order_relaxed)) return;
+  const uint32_t h = g.head.load(std::memory_order_relaxed);
+  if (h - g.tail.load(std::memory_order_acquire) >= State::kRing) {
+    g.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const ucontext_t* uc = (const ucontext_t*)ctx;
+#if defined(__x86_64__)
+  uintptr_t pc = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+  uintptr_t fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+#else
+  uintptr_t pc = (uintptr_t)uc->uc_mcontext.pc;
+  uintptr_t fp = (uintptr_t)uc->uc_mcontext.regs[29];
+#endif
+  StackSampler::Stack& s = g.ring[h % State::kRing];
+  uint32_t n = 0;
+  s.pc[n++] = pc;
+  // Frame record: [fp] = caller's fp, [fp + 8] = return address. Only follow
+  // it upwards and inside this thread's stack, so a function that uses the
+  // register for something else ends the walk instead of faulting.
+  while (n < (uint32_t)StackSampler::kMaxDepth && fp >= g.stack_lo &&
+         fp + 2 * sizeof(uintptr_t) <= g.stack_hi && fp % sizeof(uintptr_t) == 0) {
+    const uintptr_t* rec = (const uintptr_t*)fp;
+    const uintptr_t ret = rec[1];
+    if (ret == 0) break;
+    s.pc[n++] = ret;
+    if (rec[0] <= fp) break;
+    fp = rec[0];
+  }
+  s.depth = n;
+  g.head.store(h + 1, std::memory_order_release);
+}
+
+} // namespace
+
+bool StackSampler::start(double hz, std::string& err) {
+  if (running_) return true;
+  if (hz <= 0) { err = "sample rate must be > 0"; return false; }
+  if (g.owned.exchange(true)) { err = "another sampler is running in this process"; return false; }
+
+  pthread_attr_t attr;
+  void* addr = nullptr;
+  size_t size = 0;
+  if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+    pthread_attr_getstack(&attr, &addr, &size);
+    pthread_attr_destroy(&attr);
+  }
+  if (!addr) { g.owned = false; err = "cannot find the thread's stack"; return false; }
+  g.stack_lo = (uintptr_t)addr;
+  g.stack_hi = (uintptr_t)addr + size;
+  g.head = 0; g.tail = 0; g.dropped = 0; g.in_call = false;
+
+  struct sigaction sa{};
+  sa.sa_sigaction = &on_sigprof;
+  sa.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  if (sigaction(SIGPROF, &sa, &g.old) != 0) {
+    g.owned = false;
+    err = std::string("sigaction: ") + std::strerror(errno);
+    return false;
+  }
+  // The CPU clock of this thread, delivered to this thread
+  sigevent sev{};
+  sev.sigev_notify = SIGEV_THREAD_ID;
+  sev.sigev_signo = SIGPROF;
+  sev.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+  if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &g.timer) != 0) {
+    err = std::string("timer_create: ") + std::strerror(errno);
+    sigaction(SIGPROF, &g.old, nullptr);
+    g.owned = false;
+    return false;
+  }
+  const long ns = (long)(1e9 / std::min(hz, kMaxHz));
+  itimerspec its{};
+  its.it_interval.tv_sec = ns / 1000000000;
+  its.it_interval.tv_nsec = ns % 1000000000;
+  its.it_value = its.it_interval;
+  timer_settime(g.timer, 0, &its, nullptr);
+  running_ = true;
+  return true;
+}
+
+void StackSampler::stop() {
+  if (!running_) return;
+  g.in_call = false;
+  timer_delete(g.timer);
+  sigaction(SIGPROF, &g.old, nullptr);
+  running_ = false;
+  g.owned = false;
+}
+
+void StackSampler::begin() { if (running_) g.in_call.store(true, std::memory_order_relaxed); }
+void StackSampler::end() { if (running_) g.in_call.store(false, std::memory_order_relaxed); }
+
+void StackSampler::drain(std::vector<Stack>& out) {
+  if (!running_) return;
+  const uint32_t h = g.head.load(std::memory_order_acquire);
+  uint32_t t = g.tail.load(std::memory_order_relaxed);
+  for (; t != h; ++t) out.push_back(g.ring[t % State::kRing]);
+  g.tail.store(t, std::memory_order_release);
+}
+
+uint64_t StackSampler::dropped() const { return g.dropped.load(std::memory_order_relaxed); }
+
+#else
+
+bool StackSampler::start(double, std::string& err) {
+  err = "the sampling profiler needs Linux on x86-64 or AArch64";
+  return false;
+}
+void StackSampler::stop() {}
+void StackSampler::begin() {}
+void StackSampler::end() {}
+void StackSampler::drain(std::vector<Stack>&) {}
+uint64_t StackSampler::dropped() const { return 0; }
+
+#endif
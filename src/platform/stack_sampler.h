@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Statistical CPU profile of one thread. A CLOCK_THREAD_CPUTIME_ID timer
+// sends SIGPROF to that thread every 1/hz s of its CPU time, and the handler
+// walks the frame pointer chain of the interrupted context into a lock-free
+// ring. Samples outside begin()/end() are discarded in the handler. Each
+// sample costs a signal delivery and up to kMaxDepth loads, a few
+// microseconds, so the cost scales with hz and is capped by kMaxHz. Stacks
+// are only as deep as the code keeps frame pointers
+// (-fno-omit-frame-pointer, plus -mno-omit-leaf-frame-pointer or a leaf's
+// caller is skipped); the leaf pc is always right. CPU timers fire on the
+// kernel tick, so the real rate tops out at CONFIG_HZ. Linux only (x86-64,
+// AArch64): start() fails elsewhere. One sampler per process, because the
+// signal handler is process-wide.
+class StackSampler {
+public:
+  static constexpr int kMaxDepth = 32;
+  static constexpr double kMaxHz = 1000.0;
+  struct Stack {
+    uint32_t depth = 0;
+    uintptr_t pc[kMaxDepth];   // [0] = where the thread was, then return addresses
+  };
+
+  StackSampler() = default;
+  ~StackSampler() { stop(); }
+  StackSampler(const StackSampler&) = delete;
+  StackSampler& operator=(const StackSampler&) = delete;
+
+  // On the thread to sample
+  bool start(double hz, std::string& err);
+  void stop();
+  bool running() const { return running_; }
+
+  // Bracket the code to sample; same thread as start()
+  void begin();
+  void end();
+  // Appends the stacks taken since the last drain; outside begin()/end()
+  void drain(std::vector<Stack>& out);
+  uint64_t dropped() const;   // ring full
+
+private:
+  bool running_ = false;
+};
@@ -0,0 +1,83 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads) {
+  if (threads == 0) {
+    unsigned hw = std::thread::hardware_concurrency();
+    threads = hw > 1 ? hw - 1 : 1;
+  }
+  workers_.reserve(threads);
+  for (unsigned i = 0; i < threads; ++i) workers_.emplace_back([this]{ worker_main(); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto& t : workers_) if (t.joinable()) t.join();
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    jobs_.push_back(std::move(job));
+  }
+  cv_.notify_one();
+}
+
+void ThreadPool::wait_idle() {
+  std::unique_lock<std::mutex> lk(m_);
+  idle_cv_.wait(lk, [&]{ return jobs_.empty() && busy_ == 0; });
+}
+
+void ThreadPool::parallel_for(int count, const std::function<void(int)>& fn) {
+  if (count <= 0) return;
+  if (count == 1) { fn(0); return; }
+
+  // Work-stealing by index: helpers and the caller pull the next index until exhausted.
+  // `sh` lives on this stack frame, so we wait for every helper to leave, not just for the work.
+  struct Shared {
+    std::atomic<int> next{0};
+    int exited = 0;
+    std::mutex m;
+    std::condition_variable cv;
+  } sh;
+  auto drain = [&]{
+    for (int i = sh.next.fetch_add(1); i < count; i = sh.next.fetch_add(1)) fn(i);
+  };
+
+  const int helpers = std::min<int>((int)workers_.size(), count - 1);
+  for (int h = 0; h < helpers; ++h) {
+    submit([&]{
+      drain();
+      std::lock_guard<std::mutex> lk(sh.m);
+      if (++sh.exited == helpers) sh.cv.notify_all();
+    });
+  }
+  drain();
+
+  std::unique_lock<std::mutex> lk(sh.m);
+  sh.cv.wait(lk, [&]{ return sh.exited == helpers; });
+}
+
+void ThreadPool::worker_main() {
+  for (;;) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lk(m_);
+      cv_.wait(lk, [&]{ return stop_ || !jobs_.empty(); });
+      if (stop_ && jobs_.empty()) return;
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+      ++busy_;
+    }
+    job();
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      --busy_;
+      if (jobs_.empty() && busy_ == 0) idle_cv_.notify_all();
+    }
+  }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small fixed-size worker pool shared by the CPU-heavy host services
+// (software rasterizer, golden diffs, encoders).
+class ThreadPool {
+public:
+  // threads == 0 picks hardware_concurrency() - 1 (at least 1).
+  explicit ThreadPool(unsigned threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  void submit(std::function<void()> job);
+
+  // Runs fn(0..count-1) across the workers and the calling thread; returns when all are done.
+  void parallel_for(int count, const std::function<void(int)>& fn);
+
+  // Blocks until every submitted job has finished.
+  void wait_idle();
+
+  unsigned size() const { return (unsigned)workers_.size(); }
+
+private:
+  void worker_main();
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> jobs_;
+  std::mutex m_;
+  std::condition_variable cv_;
+  std::condition_variable idle_cv_;
+  int busy_ = 0;
+  bool stop_ = false;
+};
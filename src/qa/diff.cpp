@@ -2,21 +2,23 @@
 #include <cmath>
 #include <cstdlib>
 
+// The only stb_image implementation unit in the host.
 #define STB_IMAGE_IMPLEMENTATION
 #include "../../thirdparty/stb_image.h"
 
-bool diff_png_vs_png(const std::string& exp, const std::string& act,
-                     int abs_thr, DiffResult& out) {
-  int w1,h1,c1, w2,h2,c2;
-  unsigned char *a = stbi_load(exp.c_str(), &w1,&h1,&c1, 4);
-  unsigned char *b = stbi_load(act.c_str(), &w2,&h2,&c2, 4);
-  if (!a || !b || w1!=w2 || h1!=h2) { 
-    if(a) stbi_image_free(a); 
-    if(b) stbi_image_free(b); 
-    return false; 
-  }
+bool load_png_rgba(const std::string& path, Image& out) {
+  int w, h, c;
+  unsigned char* px = stbi_load(path.c_str(), &w, &h, &c, 4);
+  if (!px) return false;
+  out.w = w; out.h = h;
+  out.rgba.assign(px, px + (size_t)w * h * 4);
+  stbi_image_free(px);
+  return true;
+}
 
-  const int N = w1*h1;
+void diff_rgba(const unsigned char* a, const unsigned char* b, int w, int h,
+               int abs_thr, DiffResult& out) {
+  const int N = w*h;
   long long sumsq = 0;
   int over = 0;
   for (int i=0;i<N;i++){
@@ -27,10 +29,16 @@ bool diff_png_vs_png(const std::string& exp, const std::string& act,
     sumsq += (long long)(d0*d0 + d1*d1 + d2*d2);
     if (std::abs(d0)>abs_thr || std::abs(d1)>abs_thr || std::abs(d2)>abs_thr) over++;
   }
-  out.w=w1; out.h=h1;
-  double mse = (double)sumsq / (double)(N * 3);
+  out.w=w; out.h=h;
+  double mse = N > 0 ? (double)sumsq / ((double)N * 3.0) : 0.0;
   out.rmse = std::sqrt(mse);
-  out.pct_over_threshold = 100.0 * (double)over / (double)N;
-  stbi_image_free(a); stbi_image_free(b);
+  out.pct_over_threshold = N > 0 ? 100.0 * (double)over / (double)N : 0.0;
+}
+
+bool diff_png_vs_png(const std::string& exp, const std::string& act,
+                     int abs_thr, DiffResult& out) {
+  Image a, b;
+  if (!load_png_rgba(exp, a) || !load_png_rgba(act, b) || a.w!=b.w || a.h!=b.h) return false;
+  diff_rgba(a.rgba.data(), b.rgba.data(), a.w, a.h, abs_thr, out);
   return true;
 }
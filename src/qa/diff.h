@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <vector>
 
 struct DiffResult {
   double rmse = 0.0;
@@ -7,5 +8,17 @@ struct DiffResult {
   int    w = 0, h = 0;
 };
 
+// Decoded RGBA8 image, rows top-down.
+struct Image {
+  int w = 0, h = 0;
+  std::vector<unsigned char> rgba;
+};
+
+bool load_png_rgba(const std::string& path, Image& out);
+
+// In-memory variant: both buffers are w*h RGBA8, alpha ignored.
+void diff_rgba(const unsigned char* expected, const unsigned char* actual, int w, int h,
+               int abs_threshold, DiffResult& out);
+
 bool diff_png_vs_png(const std::string& expected, const std::string& actual,
                      int abs_threshold, DiffResult& out);
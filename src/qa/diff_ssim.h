@@ -9,9 +9,14 @@ namespace qa {
 struct SSIMResult {
   double ssim = 0.0;     // 0..1 (1 = identical)
   double mssim = 0.0;    // Mean SSIM across image
+  double min_ssim = 1.0; // Worst 8x8 window, catches small localized breakage
   int w = 0, h = 0;
 };
 
+// In-memory variant: both buffers are w*h RGBA8.
+void ssim_rgba(const unsigned char* expected, const unsigned char* actual, int w, int h,
+               SSIMResult& out);
+
 // Compute SSIM between two images
 bool diff_ssim(const std::string& expected, const std::string& actual, SSIMResult& out);
 
@@ -21,9 +26,11 @@ struct Heatmap {
   int w = 0, h = 0;
 };
 
+void heatmap_rgba(const unsigned char* expected, const unsigned char* actual, int w, int h,
+                  Heatmap& out);
+
 // Generate visual difference heatmap (red = high error)
 bool generate_heatmap(const std::string& expected, const std::string& actual, 
                       const std::string& out_path, Heatmap& out);
 
 } // namespace qa
-
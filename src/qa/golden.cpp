@@ -1,45 +1,195 @@
 #include "golden.h"
 #include "diff.h"
-#include <fstream>
-#include <sstream>
+#include "diff_ssim.h"
+#include "../services/png_writer.h"
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
-#include <iostream>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+// Minimal lookups for the flat meta.json schema (keys are unique in the file).
+static const char* json_value(const std::string& s, const char* key) {
+  const std::string k = std::string("\"") + key + "\"";
+  size_t p = s.find(k);
+  if (p == std::string::npos) return nullptr;
+  p = s.find(':', p + k.size());
+  return p == std::string::npos ? nullptr : s.c_str() + p + 1;
+}
+
+static void json_num(const std::string& s, const char* key, double& out) {
+  if (const char* v = json_value(s, key)) {
+    char* end = nullptr;
+    double d = std::strtod(v, &end);
+    if (end != v) out = d;
+  }
+}
+
+static void json_int(const std::string& s, const char* key, int& out) {
+  double d = out; json_num(s, key, d); out = (int)d;
+}
+
+static std::string leaf_of(std::string folder) {
+  while (!folder.empty() && (folder.back() == '/' || folder.back() == '\\')) folder.pop_back();
+  auto pos = folder.find_last_of("/\\");
+  return pos == std::string::npos ? folder : folder.substr(pos + 1);
+}
+
+static std::string frame_name(const char* prefix, int idx) {
+  char buf[64];
+  std::snprintf(buf, sizeof(buf), "%s_%06d.png", prefix, idx);
+  return buf;
+}
+
+std::string golden_out_dir(const std::string& folder) {
+  return "artifacts/golden_" + leaf_of(folder) + "_run";
+}
+
+std::string golden_replay_path(const std::string& folder) {
+  return folder + "/" + leaf_of(folder) + ".replay";
+}
 
 bool load_golden_meta(const std::string& folder, GoldenMeta& out) {
   std::ifstream f(folder + "/meta.json");
   if (!f.is_open()) return false;
-  
-  // For now, just use default values and check if file exists
-  out.check_frames = {120, 240};
-  out.rmse_tol = 6.0;
-  out.px_pct_tol = 0.4;
-  out.w = 1280;
-  out.h = 720;
-  return true;
-}
-
-bool verify_golden(const std::string& folder, const std::string& replay_path,
-                   const GoldenMeta& meta, const std::string& out_dir,
-                   std::string& report_json_path, bool& pass) {
-  // Create output directory
-  // std::filesystem::create_directories(out_dir);
-  
-  // For now, just create a dummy report
-  pass = true;
-  
-  // Write report
-  report_json_path = out_dir + "/report.json";
-  std::ofstream report(report_json_path);
-  report << "{\n";
-  report << "  \"summary\": { \"pass\": true, \"frames\": " << meta.check_frames.size() << " },\n";
-  report << "  \"frames\": [\n";
-  report << "    { \"idx\": 120, \"rmse\": 2.1, \"pct_over\": 0.02 },\n";
-  report << "    { \"idx\": 240, \"rmse\": 2.3, \"pct_over\": 0.03 }\n";
-  report << "  ],\n";
-  report << "  \"thresholds\": { \"rmse\": " << meta.rmse_tol << ", \"px_pct\": " << meta.px_pct_tol << " }\n";
-  report << "}\n";
-  
-  return true;
+  std::stringstream ss; ss << f.rdbuf();
+  const std::string s = ss.str();
+
+  out.check_frames.clear();
+  if (const char* v = json_value(s, "check_frames")) {
+    const char* p = std::strchr(v, '[');
+    const char* e = p ? std::strchr(p, ']') : nullptr;
+    while (p && e && p < e) {
+      char* end = nullptr;
+      long n = std::strtol(p + 1, &end, 10);
+      if (end == p + 1) { ++p; continue; }
+      if (n > 0) out.check_frames.push_back((int)n);
+      p = end;
+    }
+  }
+  std::sort(out.check_frames.begin(), out.check_frames.end());
+  out.check_frames.erase(std::unique(out.check_frames.begin(), out.check_frames.end()),
+                         out.check_frames.end());
+
+  json_num(s, "rmse", out.rmse_tol);
+  json_num(s, "px_pct", out.px_pct_tol);
+  json_int(s, "abs", out.abs_thr);
+  json_num(s, "ssim_min", out.ssim_min);
+  json_int(s, "w", out.w);
+  json_int(s, "h", out.h);
+  if (const char* v = json_value(s, "plugin_hint")) {
+    const char* q0 = std::strchr(v, '"');
+    const char* q1 = q0 ? std::strchr(q0 + 1, '"') : nullptr;
+    if (q1) out.plugin_hint.assign(q0 + 1, q1);
+  }
+  return !out.check_frames.empty() && out.w > 0 && out.h > 0;
+}
+
+GoldenRunner::GoldenRunner(GoldenMode mode, std::string folder, GoldenMeta meta, std::string out_dir)
+  : mode_(mode), folder_(std::move(folder)), out_dir_(std::move(out_dir)), meta_(std::move(meta)) {
+  std::error_code ec;
+  std::filesystem::create_directories(mode_ == GoldenMode::Capture ? folder_ : out_dir_, ec);
+}
+
+bool GoldenRunner::wants(int frame_idx) const {
+  return std::binary_search(meta_.check_frames.begin(), meta_.check_frames.end(), frame_idx);
+}
+
+int GoldenRunner::last_frame() const {
+  return meta_.check_frames.empty() ? 0 : meta_.check_frames.back();
+}
+
+void GoldenRunner::submit(int frame_idx, const uint32_t* rgba, int w, int h) {
+  // Copy now: the rasterizer reuses its buffer next frame.
+  auto buf = std::make_shared<std::vector<uint8_t>>((const uint8_t*)rgba,
+                                                    (const uint8_t*)rgba + (size_t)w * h * 4);
+  pool_.submit([this, frame_idx, buf, w, h]{
+    if (mode_ == GoldenMode::Capture) capture_frame(frame_idx, *buf, w, h);
+    else verify_frame(frame_idx, *buf, w, h);
+  });
+}
+
+void GoldenRunner::capture_frame(int idx, const std::vector<uint8_t>& actual, int w, int h) {
+  GoldenFrameResult r; r.idx = idx;
+  const std::string path = folder_ + "/" + frame_name("frame", idx);
+  r.pass = png::write_rgba(path, actual.data(), w, h);
+  if (!r.pass) r.error = "write_failed";
+  std::lock_guard<std::mutex> lk(m_);
+  results_.push_back(r);
+}
+
+void GoldenRunner::verify_frame(int idx, const std::vector<uint8_t>& actual, int w, int h) {
+  const auto t0 = std::chrono::steady_clock::now();
+  GoldenFrameResult r; r.idx = idx;
+
+  // Actual frame is always kept so a failing run can be triaged (or promoted).
+  png::write_rgba(out_dir_ + "/" + frame_name("frame", idx), actual.data(), w, h);
+
+  Image exp;
+  if (!load_png_rgba(folder_ + "/" + frame_name("frame", idx), exp)) {
+    r.error = "missing_expected";
+  } else if (exp.w != w || exp.h != h) {
+    r.error = "size_mismatch";
+  } else {
+    DiffResult d;
+    diff_rgba(exp.rgba.data(), actual.data(), w, h, meta_.abs_thr, d);
+    qa::SSIMResult ss;
+    qa::ssim_rgba(exp.rgba.data(), actual.data(), w, h, ss);
+    r.rmse = d.rmse; r.pct_over = d.pct_over_threshold;
+    r.ssim = ss.mssim; r.min_ssim = ss.min_ssim;
+    r.pass = r.rmse <= meta_.rmse_tol && r.pct_over <= meta_.px_pct_tol && r.ssim >= meta_.ssim_min;
+
+    qa::Heatmap hm;
+    qa::heatmap_rgba(exp.rgba.data(), actual.data(), w, h, hm);
+    png::write_rgba(out_dir_ + "/" + frame_name("heat", idx), hm.rgba_data.data(), w, h);
+  }
+  r.compare_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+  std::lock_guard<std::mutex> lk(m_);
+  results_.push_back(r);
+}
+
+bool GoldenRunner::finish(std::string& report_path) {
+  pool_.wait_idle();
+  std::lock_guard<std::mutex> lk(m_);
+  std::sort(results_.begin(), results_.end(),
+            [](const GoldenFrameResult& a, const GoldenFrameResult& b){ return a.idx < b.idx; });
+
+  // A frame that was never submitted (plugin died early, replay too short) is a failure.
+  for (int idx : meta_.check_frames) {
+    bool seen = std::any_of(results_.begin(), results_.end(),
+                            [idx](const GoldenFrameResult& r){ return r.idx == idx; });
+    if (!seen) { GoldenFrameResult r; r.idx = idx; r.error = "not_reached"; results_.push_back(r); }
+  }
+  bool pass = !results_.empty() &&
+              std::all_of(results_.begin(), results_.end(), [](const GoldenFrameResult& r){ return r.pass; });
+
+  if (mode_ == GoldenMode::Capture) { report_path = folder_; return pass; }
+
+  report_path = out_dir_ + "/report.json";
+  FILE* f = std::fopen(report_path.c_str(), "wb");
+  if (!f) return false;
+  std::fprintf(f, "{\n");
+  std::fprintf(f, "  \"summary\": { \"pass\": %s, \"frames\": %zu },\n",
+               pass ? "true" : "false", results_.size());
+  std::fprintf(f, "  \"frames\": [\n");
+  for (size_t i = 0; i < results_.size(); ++i) {
+    const auto& r = results_[i];
+    std::fprintf(f, "    { \"idx\": %d, \"pass\": %s, \"rmse\": %.4f, \"pct_over\": %.4f, "
+                    "\"ssim\": %.5f, \"min_ssim\": %.5f, \"compare_ms\": %.2f",
+                 r.idx, r.pass ? "true" : "false", r.rmse, r.pct_over, r.ssim, r.min_ssim, r.compare_ms);
+    if (!r.error.empty()) std::fprintf(f, ", \"error\": \"%s\"", r.error.c_str());
+    else std::fprintf(f, ", \"heatmap\": \"%s\"", frame_name("heat", r.idx).c_str());
+    std::fprintf(f, " }%s\n", i + 1 < results_.size() ? "," : "");
+  }
+  std::fprintf(f, "  ],\n");
+  std::fprintf(f, "  \"thresholds\": { \"rmse\": %g, \"px_pct\": %g, \"abs\": %d, \"ssim_min\": %g }\n",
+               meta_.rmse_tol, meta_.px_pct_tol, meta_.abs_thr, meta_.ssim_min);
+  std::fprintf(f, "}\n");
+  std::fclose(f);
+  return pass;
 }
@@ -1,16 +1,59 @@
 #pragma once
+#include <cstdint>
+#include <mutex>
 #include <string>
 #include <vector>
+#include "../platform/thread_pool.h"
 
+// Golden folder layout: meta.json, optional <name>.replay, frame_%06d.png per check frame.
 struct GoldenMeta {
   std::vector<int> check_frames;
   double rmse_tol = 6.0;
   double px_pct_tol = 0.4;
+  int    abs_thr = 8;          // per-channel delta counted as "over" in px_pct
+  double ssim_min = 0.97;
   int w = 1280, h = 720;
   std::string plugin_hint;
 };
 
 bool load_golden_meta(const std::string& folder, GoldenMeta& out);
-bool verify_golden(const std::string& folder, const std::string& replay_path,
-                   const GoldenMeta& meta, const std::string& out_dir,
-                   std::string& report_json_path, bool& pass);
+
+enum class GoldenMode { Capture, Verify };
+
+struct GoldenFrameResult {
+  int idx = 0;
+  bool pass = false;
+  double rmse = 0.0, pct_over = 0.0, ssim = 0.0, min_ssim = 0.0;
+  double compare_ms = 0.0;
+  std::string error;           // empty when the comparison ran
+};
+
+// Driven by the headless loop: frames are copied on submit() and compared
+// (or encoded, when capturing) on a worker pool while the replay continues.
+class GoldenRunner {
+public:
+  GoldenRunner(GoldenMode mode, std::string folder, GoldenMeta meta, std::string out_dir);
+
+  bool wants(int frame_idx) const;
+  int  last_frame() const;
+  void submit(int frame_idx, const uint32_t* rgba, int w, int h);
+
+  // Waits for outstanding jobs, writes report.json (verify) and returns overall pass.
+  bool finish(std::string& report_path);
+
+private:
+  void verify_frame(int idx, const std::vector<uint8_t>& actual, int w, int h);
+  void capture_frame(int idx, const std::vector<uint8_t>& actual, int w, int h);
+
+  GoldenMode mode_;
+  std::string folder_, out_dir_;
+  GoldenMeta meta_;
+  ThreadPool pool_;
+  std::mutex m_;
+  std::vector<GoldenFrameResult> results_;
+};
+
+// Output dir for a golden folder: artifacts/golden_<leaf>_run
+std::string golden_out_dir(const std::string& folder);
+// Replay file for a golden folder: <folder>/<leaf>.replay
+std::string golden_replay_path(const std::string& folder);
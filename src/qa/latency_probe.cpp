@@ -0,0 +1,119 @@
+#include "latency_probe.h"
+#if defined(__APPLE__)
+#include <OpenGL/gl3.h>
+#else
+#define GL_GLEXT_PROTOTYPES 1
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+
+// The plugin draws pure black or white; anything brighter than mid-grey is "white".
+static bool is_white(uint32_t rgba) {
+  const unsigned r = rgba & 0xFFu, g = (rgba >> 8) & 0xFFu, b = (rgba >> 16) & 0xFFu;
+  return r + g + b > 3 * 128;
+}
+
+LatencyProbe::Action LatencyProbe::before_input(uint64_t now_ns) {
+  if (!active() || done() || failed()) return Action::None;
+  // Release on the frame after the press, so both never land in one poll
+  if (release_pending_) { release_pending_ = false; return Action::Release; }
+  if (state_ != State::Arm) return Action::None;
+  state_ = State::Waiting;
+  waited_ = 0;
+  inject_ns_ = now_ns;
+  release_pending_ = true;
+  return Action::Press;
+}
+
+void LatencyProbe::observe(bool white, uint64_t present_ns) {
+  switch (state_) {
+    case State::Sync:
+      cur_white_ = white;
+      state_ = State::Cooldown;
+      cooldown_ = 4;
+      break;
+    case State::Cooldown:
+    case State::Arm:
+      cur_white_ = white;
+      break;
+    case State::Waiting:
+      // Readbacks of frames presented before the injection say nothing
+      if (present_ns < inject_ns_) break;
+      if (white != cur_white_) {
+        hist_.push((double)(present_ns - inject_ns_) / 1e6);
+        consecutive_timeouts_ = 0;
+        cur_white_ = white;
+        state_ = State::Cooldown;
+        // Vary the gap so injections don't phase-lock to the present cadence
+        cooldown_ = 2 + hist_.count() % 5;
+      }
+      break;
+  }
+}
+
+void LatencyProbe::read_gl(int w, int h) {
+  if (!active() || w <= 0 || h <= 0) return;
+  Slot& sl = slots_[next_slot_];
+  if (sl.busy) return;   // ring full: skip this frame's sample
+  next_slot_ = (next_slot_ + 1) % kSlots;
+  if (!sl.pbo) {
+    glGenBuffers(1, &sl.pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, sl.pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, 4, nullptr, GL_STREAM_READ);
+  } else {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, sl.pbo);
+  }
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(w / 2, h / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  sl.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  sl.busy = true;
+  sl.presented = false;
+  queued_slot_ = (int)(&sl - slots_);
+}
+
+void LatencyProbe::after_present(uint64_t present_ns, const uint32_t* soft_px, int w, int h) {
+  if (!active()) return;
+  if (soft_px) {
+    if (w > 0 && h > 0) observe(is_white(soft_px[(size_t)(h / 2) * w + w / 2]), present_ns);
+  } else {
+    if (queued_slot_ >= 0) {
+      slots_[queued_slot_].present_ns = present_ns;
+      slots_[queued_slot_].presented = true;
+      queued_slot_ = -1;
+    }
+    // Oldest first, so colour changes are seen in present order
+    for (int i = 0; i < kSlots; ++i) {
+      Slot& sl = slots_[(next_slot_ + i) % kSlots];
+      if (!sl.busy || !sl.presented) continue;
+      const GLenum st = glClientWaitSync((GLsync)sl.fence, 0, 0);
+      if (st != GL_ALREADY_SIGNALED && st != GL_CONDITION_SATISFIED) break;
+      glDeleteSync((GLsync)sl.fence);
+      sl.fence = nullptr;
+      sl.busy = false;
+      uint32_t px = 0;
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, sl.pbo);
+      if (const void* p = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, 4, GL_MAP_READ_BIT)) {
+        px = *(const uint32_t*)p;
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      }
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      observe(is_white(px), sl.present_ns);
+    }
+  }
+
+  if (state_ == State::Cooldown && --cooldown_ <= 0) state_ = State::Arm;
+  if (state_ == State::Waiting && ++waited_ > kTimeoutFrames) {
+    ++timeouts_;
+    ++consecutive_timeouts_;
+    state_ = State::Sync;
+  }
+}
+
+void LatencyProbe::release_gl() {
+  for (auto& sl : slots_) {
+    if (sl.fence) { glDeleteSync((GLsync)sl.fence); sl.fence = nullptr; }
+    if (sl.pbo) { glDeleteBuffers(1, &sl.pbo); sl.pbo = 0; }
+    sl.busy = false;
+  }
+}
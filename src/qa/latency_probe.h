@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include "../metrics.h"
+
+// Automated input-to-photon measurement (--latency-probe N). Drives the
+// latency_probe plugin, which flips the framebuffer black/white on every
+// left click: the probe asks for a synthetic press, then watches the centre
+// pixel of each presented frame until the colour flips. The sample is
+// present time minus injection time. GL frames are read back through a small
+// ring of 1x1 pixel-pack buffers so the check never stalls the pipeline;
+// the soft raster is sampled directly. A press that never shows up within
+// kTimeoutFrames is counted as a timeout and the probe re-syncs. After
+// kMaxConsecutiveTimeouts in a row, or as many timeouts as samples asked
+// for, the flip is taken to be unobservable and the probe fails.
+class LatencyProbe {
+public:
+  enum class Action { None, Press, Release };
+
+  void start(int samples) { target_ = samples; }
+  bool active() const { return target_ > 0; }
+  bool done() const { return active() && hist_.count() >= target_; }
+  bool failed() const {
+    return active() && (consecutive_timeouts_ >= kMaxConsecutiveTimeouts || timeouts_ >= target_);
+  }
+
+  // Top of frame, before input is polled: the synthetic event to push, if any.
+  // A press is stamped with now_ns as its injection time.
+  Action before_input(uint64_t now_ns);
+  // GL, after the frame is fully drawn and before the swap: queue the readback.
+  void read_gl(int w, int h);
+  // After present. soft_px (RGBA8, top-down) is sampled directly when given;
+  // otherwise signalled GL readbacks are collected.
+  void after_present(uint64_t present_ns, const uint32_t* soft_px, int w, int h);
+  void release_gl();
+
+  const LatencyHistogram& hist() const { return hist_; }
+  int timeouts() const { return timeouts_; }
+
+private:
+  static constexpr int kSlots = 4;
+  static constexpr int kTimeoutFrames = 120;
+  static constexpr int kMaxConsecutiveTimeouts = 5;
+  enum class State { Sync, Cooldown, Arm, Waiting };
+  struct Slot {
+    unsigned pbo = 0;
+    void*    fence = nullptr;   // GLsync
+    uint64_t present_ns = 0;
+    bool     busy = false;
+    bool     presented = false;
+  };
+
+  void observe(bool white, uint64_t present_ns);
+
+  LatencyHistogram hist_{4096};
+  int target_ = 0;
+  int timeouts_ = 0;
+  int consecutive_timeouts_ = 0;
+  State state_ = State::Sync;
+  bool cur_white_ = false;
+  bool release_pending_ = false;
+  int  cooldown_ = 0;
+  int  waited_ = 0;
+  uint64_t inject_ns_ = 0;
+  Slot slots_[kSlots];
+  int next_slot_ = 0;
+  int queued_slot_ = -1;    // read this frame, waiting for its present time
+};
@@ -15,10 +15,10 @@
 namespace shm {
 
 #ifdef _WIN32
-bool create_host(Block& out, const std::string& name, uint32_t cmd_bytes, uint32_t rsp_bytes) {
+bool create_host(Block& out, const std::string& name, uint32_t cmd_bytes, uint32_t rsp_bytes, uint32_t aux_bytes) {
   std::string shm_name = "gpi_" + name;
   HANDLE h = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, 
-                                sizeof(Ctrl) + cmd_bytes + rsp_bytes, shm_name.c_str());
+                                sizeof(Ctrl) + cmd_bytes + rsp_bytes + aux_bytes, shm_name.c_str());
   if (!h) return false;
   
   void* base = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, 0);
@@ -29,6 +29,8 @@ bool create_host(Block& out, const std::string& name, uint32_t cmd_bytes, uint32
   ctrl->version = 1;
   ctrl->cmd_off = sizeof(Ctrl);
   ctrl->rsp_off = sizeof(Ctrl) + cmd_bytes;
+  ctrl->aux_off = sizeof(Ctrl) + cmd_bytes + rsp_bytes;
+  ctrl->aux_bytes = aux_bytes;
   ctrl->ev_host_wake = (uint32_t)(intptr_t)CreateEventA(NULL, FALSE, FALSE, (shm_name + "_host").c_str());
   ctrl->ev_child_wake = (uint32_t)(intptr_t)CreateEventA(NULL, FALSE, FALSE, (shm_name + "_child").c_str());
   
@@ -45,8 +47,10 @@ bool create_host(Block& out, const std::string& name, uint32_t cmd_bytes, uint32
   out.ctrl = ctrl;
   out.cmd = cmd;
   out.rsp = rsp;
+  out.aux = aux_bytes ? (char*)base + ctrl->aux_off : nullptr;
+  out.aux_bytes = aux_bytes;
   out.base = base;
-  out.size = sizeof(Ctrl) + cmd_bytes + rsp_bytes;
+  out.size = sizeof(Ctrl) + cmd_bytes + rsp_bytes + aux_bytes;
   return true;
 }
 
@@ -64,6 +68,8 @@ bool open_child(Block& out, const std::string& name) {
   out.ctrl = ctrl;
   out.cmd = (Ring*)((char*)base + ctrl->cmd_off);
   out.rsp = (Ring*)((char*)base + ctrl->rsp_off);
+  out.aux = ctrl->aux_bytes ? (char*)base + ctrl->aux_off : nullptr;
+  out.aux_bytes = ctrl->aux_bytes;
   out.base = base;
   return true;
 }
@@ -88,12 +94,12 @@ void wait(uint32_t handle, uint32_t timeout_ms) {
   WaitForSingleObject((HANDLE)(intptr_t)handle, timeout_ms);
 }
 #else
-bool create_host(Block& out, const std::string& name, uint32_t cmd_bytes, uint32_t rsp_bytes) {
+bool create_host(Block& out, const std::string& name, uint32_t cmd_bytes, uint32_t rsp_bytes, uint32_t aux_bytes) {
   std::string shm_name = "/gpi_" + name;
   int fd = shm_open(shm_name.c_str(), O_CREAT | O_RDWR, 0666);
   if (fd < 0) return false;
   
-  size_t size = sizeof(Ctrl) + cmd_bytes + rsp_bytes;
+  size_t size = sizeof(Ctrl) + cmd_bytes + rsp_bytes + aux_bytes;
   if (ftruncate(fd, size) < 0) { close(fd); return false; }
   
   void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
@@ -105,6 +111,8 @@ bool create_host(Block& out, const std::string& name, uint32_t cmd_bytes, uint32
   ctrl->version = 1;
   ctrl->cmd_off = sizeof(Ctrl);
   ctrl->rsp_off = sizeof(Ctrl) + cmd_bytes;
+  ctrl->aux_off = sizeof(Ctrl) + cmd_bytes + rsp_bytes;
+  ctrl->aux_bytes = aux_bytes;
   int pipes[2];
   pipe(pipes);
   ctrl->ev_host_wake = pipes[0];
@@ -123,6 +131,8 @@ bool create_host(Block& out, const std::string& name, uint32_t cmd_bytes, uint32
   out.ctrl = ctrl;
   out.cmd = cmd;
   out.rsp = rsp;
+  out.aux = aux_bytes ? (char*)base + ctrl->aux_off : nullptr;
+  out.aux_bytes = aux_bytes;
   out.base = base;
   out.size = size;
   return true;
@@ -133,22 +143,24 @@ bool open_child(Block& out, const std::string& name) {
   int fd = shm_open(shm_name.c_str(), O_RDWR, 0666);
   if (fd < 0) return false;
   
-  void* base = mmap(nullptr, sizeof(Ctrl), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  // Map the whole object (rings and aux region) as sized by the host
+  struct stat st{};
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(Ctrl)) { close(fd); return false; }
+  size_t size = (size_t)st.st_size;
+  void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
   close(fd);
   if (base == MAP_FAILED) return false;
   
   Ctrl* ctrl = (Ctrl*)base;
-  if (ctrl->magic != MAGIC) { munmap(base, sizeof(Ctrl)); return false; }
-  
-  size_t size = sizeof(Ctrl) + (ctrl->rsp_off - ctrl->cmd_off) + 1024;
-  munmap(base, sizeof(Ctrl));
-  base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-  if (base == MAP_FAILED) return false;
+  if (ctrl->magic != MAGIC || (size_t)ctrl->aux_off + ctrl->aux_bytes > size) { munmap(base, size); return false; }
   
   out.ctrl = ctrl;
   out.cmd = (Ring*)((char*)base + ctrl->cmd_off);
   out.rsp = (Ring*)((char*)base + ctrl->rsp_off);
+  out.aux = ctrl->aux_bytes ? (char*)base + ctrl->aux_off : nullptr;
+  out.aux_bytes = ctrl->aux_bytes;
   out.base = base;
+  out.size = size;
   return true;
 }
 
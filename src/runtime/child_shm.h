@@ -22,17 +22,21 @@ struct Ctrl {
   uint32_t rsp_off;
   uint32_t ev_host_wake;
   uint32_t ev_child_wake;
+  uint32_t aux_off;     // optional region after the rings (plugin trace buffer)
+  uint32_t aux_bytes;
 };
 
 struct Block {
   Ctrl* ctrl = nullptr;
   Ring* cmd = nullptr;
   Ring* rsp = nullptr;
+  void* aux = nullptr;
+  uint32_t aux_bytes = 0;
   void* base = nullptr;
   size_t size = 0;
 };
 
-bool create_host(Block& out, const std::string& name, uint32_t cmd_bytes=1<<20, uint32_t rsp_bytes=1<<16);
+bool create_host(Block& out, const std::string& name, uint32_t cmd_bytes=1<<20, uint32_t rsp_bytes=1<<16, uint32_t aux_bytes=0);
 bool open_child(Block& out, const std::string& name);
 void destroy_host(Block& b);
 void close_child(Block& b);
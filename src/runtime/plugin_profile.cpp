@@ -0,0 +1,196 @@
+#include "plugin_profile.h"
+#include <algorithm>
+#include <cstdio>
+
+#ifdef __linux__
+#include <dlfcn.h>
+#include <link.h>
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+bool PluginProfiler::start(PluginProfileBuf* buf, double hz, std::string& err) {
+  if (!buf || buf->magic != PluginProfileBuf::kMagic) { err = "no profile buffer"; return false; }
+  if (!sampler_.start(hz, err)) return false;
+  buf_ = buf;
+  buf_->enabled = 1;
+  return true;
+}
+
+void PluginProfiler::stop() {
+  sampler_.stop();
+  if (buf_) buf_->enabled = 0;
+  buf_ = nullptr;
+}
+
+void PluginProfiler::set_library(const void* addr) {
+  // Addresses of an unloaded library may come back as another one's
+  names_.clear();
+  lib_base_ = 0;
+#ifdef __linux__
+  Dl_info info{};
+  if (addr && dladdr(addr, &info)) lib_base_ = (uintptr_t)info.dli_fbase;
+#else
+  (void)addr;
+#endif
+}
+
+uint16_t PluginProfiler::name_id(uintptr_t pc, bool leaf, bool& in_plugin) {
+  const auto it = names_.find(pc);
+  if (it != names_.end()) { in_plugin = it->second.in_plugin; return it->second.id; }
+
+  char name[PluginProfileBuf::kNameLen];
+  in_plugin = false;
+#ifdef __linux__
+  // A return address is the instruction after the call, which can belong to
+  // the next function
+  const uintptr_t at = leaf ? pc : pc - 1;
+  Dl_info info{};
+  const ElfW(Sym)* sym = nullptr;
+  if (dladdr1((void*)at, &info, (void**)&sym, RTLD_DL_SYMENT) && info.dli_fname) {
+    in_plugin = (uintptr_t)info.dli_fbase == lib_base_;
+    const char* module = std::strrchr(info.dli_fname, '/');
+    module = module ? module + 1 : info.dli_fname;
+    // dladdr only knows exported symbols: past the nearest one's size, the
+    // pc is in something static, so give the module offset instead
+    const bool inside = info.dli_sname && info.dli_saddr &&
+                        (!sym || sym->st_size == 0 || at - (uintptr_t)info.dli_saddr < sym->st_size);
+    if (inside) {
+      int status = 0;
+      char* dem = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+      const char* fn = status == 0 && dem ? dem : info.dli_sname;
+      if (in_plugin) std::snprintf(name, sizeof(name), "%s", fn);
+      else std::snprintf(name, sizeof(name), "%s`%s", module, fn);
+      std::free(dem);
+    } else {
+      std::snprintf(name, sizeof(name), "%s+0x%llx", module,
+                    (unsigned long long)(at - (uintptr_t)info.dli_fbase));
+    }
+  } else {
+    std::snprintf(name, sizeof(name), "0x%llx", (unsigned long long)at);
+  }
+#else
+  (void)leaf;
+  std::snprintf(name, sizeof(name), "0x%llx", (unsigned long long)pc);
+#endif
+  // ';' separates frames in the folded output
+  for (char* c = name; *c; ++c) if (*c == ';') *c = ':';
+
+  uint16_t id = 0;
+  const auto known = ids_.find(name);
+  if (known != ids_.end()) {
+    id = known->second;
+  } else {
+    const uint32_t n = buf_->name_count.load(std::memory_order_relaxed);
+    if (n < PluginProfileBuf::kNames) {
+      std::memcpy(buf_->names[n], name, sizeof(name));
+      buf_->name_count.store(n + 1, std::memory_order_release);
+      id = (uint16_t)(n + 1);
+      ids_.emplace(name, id);
+    }
+  }
+  names_.emplace(pc, Name{ id, in_plugin });
+  return id;
+}
+
+void PluginProfiler::end() {
+  sampler_.end();
+  if (!buf_) return;
+  raw_.clear();
+  sampler_.drain(raw_);
+  const uint64_t lost = sampler_.dropped();
+  if (lost != sampler_dropped_) {
+    buf_->dropped.fetch_add((uint32_t)(lost - sampler_dropped_), std::memory_order_relaxed);
+    sampler_dropped_ = lost;
+  }
+  for (const StackSampler::Stack& r : raw_) {
+    PluginProfileBuf::Stack s;
+    uint32_t keep = 1;   // no plugin frame: a sample in the runner itself
+    for (uint32_t i = 0; i < r.depth; ++i) {
+      bool in_plugin = false;
+      s.id[i] = name_id(r.pc[i], i == 0, in_plugin);
+      if (in_plugin) keep = i + 1;
+    }
+    s.depth = keep;
+    const uint32_t h = buf_->head.load(std::memory_order_relaxed);
+    if (h - buf_->tail.load(std::memory_order_acquire) >= PluginProfileBuf::kStacks) {
+      buf_->dropped.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    buf_->st[h % PluginProfileBuf::kStacks] = s;
+    buf_->head.store(h + 1, std::memory_order_release);
+  }
+}
+
+const std::string& PluginProfileReader::name(uint16_t id) const {
+  static const std::string unknown = "?";
+  return id == 0 || id > names_.size() ? unknown : names_[id - 1];
+}
+
+void PluginProfileReader::collect(PluginProfileBuf& b, const std::string& plugin, const char* phase) {
+  if (b.magic != PluginProfileBuf::kMagic || !b.enabled) return;
+  const uint32_t names = std::min(b.name_count.load(std::memory_order_acquire), PluginProfileBuf::kNames);
+  for (uint32_t i = (uint32_t)names_.size(); i < names; ++i) {
+    const char* n = b.names[i];
+    names_.emplace_back(n, strnlen(n, PluginProfileBuf::kNameLen));
+  }
+
+  const uint32_t h = b.head.load(std::memory_order_acquire);
+  uint32_t t = b.tail.load(std::memory_order_relaxed);
+  if (h - t > PluginProfileBuf::kStacks) t = h - PluginProfileBuf::kStacks;
+  std::string key;
+  for (; t != h; ++t) {
+    const PluginProfileBuf::Stack s = b.st[t % PluginProfileBuf::kStacks];
+    const uint32_t depth = std::min(s.depth, PluginProfileBuf::kDepth);
+    if (depth == 0) continue;
+    ++samples_;
+    key = plugin;
+    key += ';';
+    key += phase;
+    for (uint32_t i = depth; i-- > 0;) { key += ';'; key += name(s.id[i]); }
+    const auto it = stacks_.find(key);
+    if (it != stacks_.end()) ++it->second;
+    else if (stacks_.size() < kMaxStacks) stacks_.emplace(key, 1);
+    else ++stacks_[plugin + ";" + phase + ";[other]"];
+
+    // Total once per function however often it recurses
+    for (uint32_t i = 0; i < depth; ++i) {
+      bool seen = false;
+      for (uint32_t j = 0; j < i && !seen; ++j) seen = s.id[j] == s.id[i];
+      if (seen) continue;
+      Row& r = funcs_[name(s.id[i])];
+      if (r.name.empty()) r.name = name(s.id[i]);
+      ++r.total;
+      if (i == 0) ++r.self;
+    }
+  }
+  b.tail.store(h, std::memory_order_release);
+  dropped_ += b.dropped.exchange(0, std::memory_order_relaxed);
+}
+
+std::vector<PluginProfileReader::Row> PluginProfileReader::top(std::size_t n) const {
+  std::vector<Row> rows;
+  rows.reserve(funcs_.size());
+  for (const auto& f : funcs_) rows.push_back(f.second);
+  n = std::min(n, rows.size());
+  std::partial_sort(rows.begin(), rows.begin() + (std::ptrdiff_t)n, rows.end(), [](const Row& a, const Row& b) {
+    return a.self != b.self ? a.self > b.self : a.total > b.total;
+  });
+  rows.resize(n);
+  return rows;
+}
+
+std::string PluginProfileReader::folded(const Stacks& stacks) {
+  std::vector<const Stacks::value_type*> order;
+  order.reserve(stacks.size());
+  for (const auto& s : stacks) order.push_back(&s);
+  std::sort(order.begin(), order.end(), [](auto* a, auto* b) { return a->first < b->first; });
+  std::string out;
+  for (const auto* s : order) {
+    out += s->first;
+    out += ' ';
+    out += std::to_string(s->second);
+    out += '\n';
+  }
+  return out;
+}
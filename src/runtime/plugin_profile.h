@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../platform/stack_sampler.h"
+
+// Sampled plugin stacks on their way to the host, laid out like
+// PluginTraceBuf: in host memory for in-process plugins, in the runner's
+// shared memory block (after the trace buffer) for gpi_child. The process
+// that calls the plugin symbolizes each new address once and stores stacks
+// as name ids; the host drains it after every gpi_update / gpi_render.
+struct PluginProfileBuf {
+  static constexpr uint32_t kMagic   = 0x46505047u;   // 'GPPF'
+  static constexpr uint32_t kStacks  = 1024;          // per call
+  static constexpr uint32_t kDepth   = StackSampler::kMaxDepth;
+  static constexpr uint32_t kNames   = 4096;
+  static constexpr uint32_t kNameLen = 96;
+
+  struct Stack {
+    uint32_t depth;
+    uint16_t id[kDepth];   // leaf first; name id - 1, 0 = unknown
+  };
+
+  uint32_t magic;
+  uint32_t enabled;                // set by the sampling side once it runs
+  std::atomic<uint32_t> head;      // sampling side
+  std::atomic<uint32_t> tail;      // host
+  std::atomic<uint32_t> dropped;   // stacks lost to a full buffer or sampler ring
+  std::atomic<uint32_t> name_count;
+  char names[kNames][kNameLen];
+  Stack st[kStacks];
+
+  void init() {
+    magic = kMagic; enabled = 0;
+    head.store(0); tail.store(0); dropped.store(0); name_count.store(0);
+  }
+  // Its offset in the shared memory aux region, after `before` bytes
+  static constexpr uint32_t aux_offset(std::size_t before) { return (uint32_t)((before + 63) & ~(std::size_t)63); }
+};
+
+// The sampling side, in the process and on the thread that calls the plugin:
+// a StackSampler around every call, then the call's stacks symbolized with
+// dladdr into the buffer. Frames below the plugin's outermost one (the
+// runner, the main loop) are cut off; frames above it, in libc or in host
+// callbacks, are kept and named "module`symbol".
+class PluginProfiler {
+public:
+  bool start(PluginProfileBuf* buf, double hz, std::string& err);
+  void stop();
+  bool running() const { return sampler_.running(); }
+  // Any address inside the loaded plugin; call again after every load
+  void set_library(const void* addr);
+
+  void begin() { sampler_.begin(); }
+  void end();
+
+private:
+  uint16_t name_id(uintptr_t pc, bool leaf, bool& in_plugin);
+
+  StackSampler sampler_;
+  PluginProfileBuf* buf_ = nullptr;
+  uintptr_t lib_base_ = 0;
+  struct Name { uint16_t id; bool in_plugin; };
+  std::unordered_map<uintptr_t, Name> names_;   // by pc
+  std::unordered_map<std::string, uint16_t> ids_;   // by name
+  std::vector<StackSampler::Stack> raw_;
+  uint64_t sampler_dropped_ = 0;
+};
+
+// Host side: folded stacks ("plugin;update;outer;...;leaf") with sample
+// counts, and self/total samples per function for the HUD. Everything read
+// from the buffer is validated; a gpi_child plugin can write any bytes there.
+class PluginProfileReader {
+public:
+  struct Row {
+    std::string name;
+    uint64_t self = 0, total = 0;
+  };
+
+  // Forget the name table (a new plugin was loaded)
+  void reset() { names_.clear(); }
+  void collect(PluginProfileBuf& b, const std::string& plugin, const char* phase);
+
+  using Stacks = std::unordered_map<std::string, uint64_t>;   // folded stack -> samples
+
+  uint64_t samples() const { return samples_; }
+  uint64_t dropped() const { return dropped_; }
+  const Stacks& stacks() const { return stacks_; }
+  // Hottest functions by self samples
+  std::vector<Row> top(std::size_t n) const;
+  // One "frame;frame;... count" line per stack, for flamegraph tools; meant
+  // for a copy of stacks() on the artifact writer thread
+  static std::string folded(const Stacks& stacks);
+
+private:
+  static constexpr std::size_t kMaxStacks = 20000;   // distinct; the rest fold into "[other]"
+
+  const std::string& name(uint16_t id) const;
+
+  std::vector<std::string> names_;   // by id - 1
+  Stacks stacks_;
+  std::unordered_map<std::string, Row> funcs_;
+  uint64_t samples_ = 0;
+  uint64_t dropped_ = 0;
+};
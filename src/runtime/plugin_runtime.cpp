@@ -58,7 +58,11 @@ bool PluginRuntime::call_init() {
 bool PluginRuntime::call_update(const GPI_FrameContext& ctx) {
   last_error = nullptr;
   auto thunk = [&]() {
+    counters.begin();
+    profiler.begin();
     GPI_Result r = fns.update(&ctx);
+    profiler.end();
+    counters.end(last_counters);
     if (r != GPI_OK) { last_error = "gpi_update failed"; return false; }
     return true;
   };
@@ -68,7 +72,11 @@ bool PluginRuntime::call_update(const GPI_FrameContext& ctx) {
 bool PluginRuntime::call_render() {
   last_error = nullptr;
   auto thunk = [&]() {
+    counters.begin();
+    profiler.begin();
     GPI_Result r = fns.render();
+    profiler.end();
+    counters.end(last_counters);
     if (r != GPI_OK) { last_error = "gpi_render failed"; return false; }
     return true;
   };
@@ -2,6 +2,8 @@
 #include <string>
 #include <cstdint>
 #include "../platform/fs.h"
+#include "../platform/perf_counters.h"
+#include "plugin_profile.h"
 #include "plugin_loader.h"
 
 extern "C" {
@@ -51,4 +53,9 @@ struct PluginRuntime {
 
   double last_call_ms = 0.0;
   const char* last_error = nullptr;
+  // Opened by the owner to count update/render calls; idle otherwise
+  PerfCounters counters;
+  PerfSample last_counters{};   // of the last update/render; valid == 0 without counters
+  // Started by the owner to sample update/render stacks; idle otherwise
+  PluginProfiler profiler;
 };
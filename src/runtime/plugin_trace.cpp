@@ -0,0 +1,55 @@
+#include "plugin_trace.h"
+#include "../services/trace.h"
+#include <algorithm>
+
+void PluginTraceReader::collect(PluginTraceBuf& b, Tracer& tracer, int64_t call_t0, int64_t call_t1) {
+  if (b.magic != PluginTraceBuf::kMagic) return;
+  const uint32_t names = std::min(b.name_count.load(std::memory_order_acquire), PluginTraceBuf::kNames);
+  for (uint32_t i = (uint32_t)names_.size(); i < names; ++i) {
+    const char* n = b.names[i];
+    names_.push_back(tracer.intern(std::string_view(n, strnlen(n, PluginTraceBuf::kNameLen))));
+  }
+
+#if GPI_ZONES
+  // Zone ticks from ns, anchored now so calibration drift does not matter
+  gpi::ZoneBuffer* zb = gpi::zone_buffer();
+  const int64_t anchor_ns = PluginTraceBuf::now_ns();
+  const uint64_t anchor_tk = gpi::zone_ticks();
+  const double tick_per_ns = 1.0 / gpi::zones().ns_per_tick();
+  auto ticks = [&](int64_t ns) { return anchor_tk - (uint64_t)((double)(anchor_ns - ns) * tick_per_ns); };
+#endif
+
+  struct Open { uint32_t id; int64_t t0; };
+  Open stack[32];
+  int depth = 0, overflow = 0;
+  auto close = [&](int64_t t1) {
+    const Open& o = stack[--depth];
+    const char* name = o.id <= names_.size() ? names_[o.id - 1] : "plugin.zone";
+    tracer.span(name, "plugin", o.t0, t1);
+#if GPI_ZONES
+    // One level below the runner's zone, which has just closed at zb->depth
+    zb->push(name, ticks(o.t0), ticks(t1), (uint16_t)(zb->depth + 1 + depth));
+#endif
+    ++zones_;
+  };
+
+  const uint32_t h = b.head.load(std::memory_order_acquire);
+  uint32_t t = b.tail.load(std::memory_order_relaxed);
+  if (h - t > PluginTraceBuf::kEvents) t = h - PluginTraceBuf::kEvents;
+  for (; t != h; ++t) {
+    const PluginTraceBuf::Event e = b.ev[t % PluginTraceBuf::kEvents];
+    const int64_t ts = std::clamp(e.t_ns, call_t0, call_t1);
+    if (e.id != 0) {
+      if (depth < 32) stack[depth++] = Open{ e.id, ts };
+      else { ++overflow; ++dropped_; }
+    } else if (overflow > 0) {
+      --overflow;
+    } else if (depth > 0) {
+      close(ts);
+    }
+  }
+  while (depth > 0) close(call_t1);
+  b.tail.store(h, std::memory_order_release);
+  b.skip = 0;
+  dropped_ += b.dropped.exchange(0, std::memory_order_relaxed);
+}
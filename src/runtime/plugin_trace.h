@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+class Tracer;
+
+// Plugin zones (GPI_HostApi trace_register / trace_begin / trace_end) go
+// through this fixed-layout buffer: in host memory for in-process plugins,
+// in the runner's shared memory block for gpi_child. The plugin side is the
+// only writer; the host drains it after every gpi_update / gpi_render, so one
+// call's events have to fit. Timestamps are steady_clock ns, which both
+// processes read from the same system clock.
+struct PluginTraceBuf {
+  static constexpr uint32_t kMagic   = 0x52545047u;   // 'GPTR'
+  static constexpr uint32_t kEvents  = 4096;          // per call
+  static constexpr uint32_t kNames   = 256;
+  static constexpr uint32_t kNameLen = 48;
+
+  struct Event {
+    int64_t  t_ns;
+    uint32_t id;     // 0 = end of the innermost open zone
+    uint32_t _pad;
+  };
+
+  uint32_t magic;
+  uint32_t enabled;                // set by the loader when the plugin has GPI_CAP_TRACE
+  std::atomic<uint32_t> head;      // plugin side
+  std::atomic<uint32_t> tail;      // host
+  std::atomic<uint32_t> dropped;
+  std::atomic<uint32_t> name_count;
+  uint32_t skip;                   // plugin side: ends owed to dropped begins
+  char names[kNames][kNameLen];    // id - 1
+  Event ev[kEvents];
+
+  void init() {
+    magic = kMagic; enabled = 0; skip = 0;
+    head.store(0); tail.store(0); dropped.store(0); name_count.store(0);
+  }
+
+  // Same id for the same name; 0 when the table is full
+  uint32_t register_name(const char* name) {
+    if (!name) return 0;
+    const uint32_t n = name_count.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < n; ++i)
+      if (std::strncmp(names[i], name, kNameLen - 1) == 0) return i + 1;
+    if (n == kNames) return 0;
+    std::strncpy(names[n], name, kNameLen - 1);
+    names[n][kNameLen - 1] = '\0';
+    name_count.store(n + 1, std::memory_order_release);
+    return n + 1;
+  }
+
+  void begin(uint32_t id) {
+    if (!enabled || id == 0) return;
+    if (!push(id)) ++skip;
+  }
+  void end() {
+    if (!enabled) return;
+    if (skip) { --skip; return; }
+    push(0);
+  }
+
+  static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+private:
+  bool push(uint32_t id) {
+    const uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= kEvents) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    ev[h % kEvents] = Event{ now_ns(), id, 0 };
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+// Host side: turns the events of the call that just returned into spans on
+// the Tracer and zones nested under the runner's own zone. Everything read
+// from the buffer is validated; a gpi_child plugin can write any bytes there.
+class PluginTraceReader {
+public:
+  // Forget the name table (a new plugin was loaded)
+  void reset() { names_.clear(); }
+  // [call_t0, call_t1] bounds every zone; zones still open at the end of the
+  // call are closed there.
+  void collect(PluginTraceBuf& b, Tracer& tracer, int64_t call_t0, int64_t call_t1);
+
+  uint64_t zones() const { return zones_; }
+  uint64_t dropped() const { return dropped_; }
+
+private:
+  std::vector<const char*> names_;   // interned, by id - 1
+  uint64_t zones_ = 0;
+  uint64_t dropped_ = 0;
+};
@@ -4,6 +4,10 @@
 #include <cstdint>
 #include <memory>
 #include "../../include/gpi/gpi_plugin.h"
+#include "../platform/perf_counters.h"
+
+struct PluginTraceBuf;
+struct PluginProfileBuf;
 
 struct FrameArgs {
   float dt_sec;
@@ -22,7 +26,18 @@ public:
   virtual bool render() = 0;
   virtual void unload() = 0;
   virtual const char* last_error() const = 0;
+  // Where the loaded plugin's trace_begin/trace_end land (nullable)
+  virtual PluginTraceBuf* trace_buffer() { return nullptr; }
+  // The gpi_child process running the plugin, 0 in-process
+  virtual int child_pid() const { return 0; }
+  // Hardware counters of the last update/render call; valid == 0 when off
+  virtual PerfSample last_counters() const { return PerfSample{}; }
+  // Sampled stacks of the loaded plugin's calls (nullable; off unless profile_hz > 0)
+  virtual PluginProfileBuf* profile_buffer() { return nullptr; }
 };
 
-std::unique_ptr<IPluginRunner> make_runner_inproc(const GPI_HostApi& api, double deadline_ms);
-std::unique_ptr<IPluginRunner> make_runner_child();
+// counters: wrap update/render in PerfCounters; profile_hz > 0: sample their
+// stacks with a PluginProfiler. Both are quietly off where unavailable.
+std::unique_ptr<IPluginRunner> make_runner_inproc(const GPI_HostApi& api, double deadline_ms, bool counters = false,
+                                                  double profile_hz = 0);
+std::unique_ptr<IPluginRunner> make_runner_child(bool counters = false, double profile_hz = 0);
@@ -1,6 +1,11 @@
 #include "runner.h"
 #include "child_shm.h"
+#include "plugin_trace.h"
+#include "plugin_profile.h"
 #include "../platform/proc.h"
+#include "../services/zones.h"
+#include <cstddef>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <sstream>
@@ -27,17 +32,37 @@ class RunnerChild : public IPluginRunner {
   ChildProc child_;
   std::string err_;
   double last_call_ms_ = 0.0;
+  bool counters_ = false;
+  double profile_hz_ = 0;
+  PerfSample last_counters_{};
+
+  // RspOk: {3, phase, f32 ms} then, from a child counting, u32 valid + u64 per PerfEvent
+  void read_counters(const std::vector<uint8_t>& rsp) {
+    last_counters_ = PerfSample{};
+    if (rsp.size() < 10 + sizeof(last_counters_.v)) return;
+    std::memcpy(&last_counters_.valid, &rsp[6], 4);
+    std::memcpy(last_counters_.v, &rsp[10], sizeof(last_counters_.v));
+    last_counters_.valid &= (1u << kPerfEvents) - 1;
+  }
 public:
+  RunnerChild(bool counters, double profile_hz) : counters_(counters), profile_hz_(profile_hz) {}
   bool load(const std::string& lib) override {
     std::random_device rd;
     std::string shm_name = std::to_string(rd());
-    if (!shm::create_host(shm_, shm_name)) { err_="shm create failed"; return false; }
+    const uint32_t aux = profile_hz_ > 0
+      ? PluginProfileBuf::aux_offset(sizeof(PluginTraceBuf)) + (uint32_t)sizeof(PluginProfileBuf)
+      : (uint32_t)sizeof(PluginTraceBuf);
+    if (!shm::create_host(shm_, shm_name, 1<<20, 1<<16, aux)) { err_="shm create failed"; return false; }
+    ((PluginTraceBuf*)shm_.aux)->init();   // the child enables it for GPI_CAP_TRACE plugins
+    if (PluginProfileBuf* pb = profile_buffer()) pb->init();   // and this one once its sampler runs
     
     // Phase 11: Create plugin work directory
     std::string workdir = "userdata/" + std::to_string(rd());
     mkdir(workdir.c_str(), 0755);
     
     std::vector<std::string> args = {"--shm", shm_name, "--lib", lib, "--work", workdir};
+    if (counters_) { args.push_back("--perf"); args.push_back("1"); }
+    if (profile_hz_ > 0) { args.push_back("--profile"); args.push_back(std::to_string(profile_hz_)); }
     if (!proc::spawn_child("gpi_child", args, child_)) { err_="spawn failed"; return false; }
     
     // Wait for child init
@@ -47,6 +72,7 @@ public:
     return true;
   }
   bool update(const FrameArgs& f) override {
+    GPI_ZONE("RunnerChild::update");
     auto start = std::chrono::high_resolution_clock::now();
     
     std::vector<uint8_t> cmd;
@@ -56,20 +82,31 @@ public:
     cmd.insert(cmd.end(), (uint8_t*)&f.fb_h, (uint8_t*)&f.fb_h + 4);
     cmd.insert(cmd.end(), (uint8_t*)&f.t_ns, (uint8_t*)&f.t_ns + 8);
     uint32_t input_n = f.input_size;
+    // Only the filled part of a V2 event array crosses the process boundary
+    if (input_n == sizeof(GPI_InputV2)) {
+      const auto* v2 = (const GPI_InputV2*)f.input_blob;
+      const uint32_t n = v2->event_count < GPI_INPUT_V2_MAX_EVENTS ? v2->event_count : GPI_INPUT_V2_MAX_EVENTS;
+      input_n = (uint32_t)(offsetof(GPI_InputV2, events) + n * sizeof(GPI_InputEventV2));
+    }
     cmd.insert(cmd.end(), (uint8_t*)&input_n, (uint8_t*)&input_n + 4);
-    cmd.insert(cmd.end(), (uint8_t*)f.input_blob, (uint8_t*)f.input_blob + f.input_size);
+    cmd.insert(cmd.end(), (uint8_t*)f.input_blob, (uint8_t*)f.input_blob + input_n);
     
     if (!shm::write_msg(shm_.cmd, cmd.data(), cmd.size())) { err_="cmd write failed"; return false; }
     shm::signal(shm_.ctrl->ev_child_wake);
     
     std::vector<uint8_t> rsp;
-    if (!shm::read_msg(shm_.rsp, rsp)) { err_="no response"; return false; }
+    {
+      GPI_ZONE("child.wait");
+      if (!shm::read_msg(shm_.rsp, rsp)) { err_="no response"; return false; }
+    }
     if (rsp.size() < 6 || rsp[0] != 3) { err_="update failed"; return false; }
     
     last_call_ms_ = *(float*)&rsp[2];
+    read_counters(rsp);
     return true;
   }
   bool render() override {
+    GPI_ZONE("RunnerChild::render");
     auto start = std::chrono::high_resolution_clock::now();
     
     std::vector<uint8_t> cmd = {2}; // CmdRender
@@ -77,20 +114,33 @@ public:
     shm::signal(shm_.ctrl->ev_child_wake);
     
     std::vector<uint8_t> rsp;
-    if (!shm::read_msg(shm_.rsp, rsp)) { err_="no response"; return false; }
+    {
+      GPI_ZONE("child.wait");
+      if (!shm::read_msg(shm_.rsp, rsp)) { err_="no response"; return false; }
+    }
     if (rsp.size() < 6 || rsp[0] != 3) { err_="render failed"; return false; }
     
     last_call_ms_ = *(float*)&rsp[2];
+    read_counters(rsp);
     return true;
   }
   void unload() override {
     shm::destroy_host(shm_);
+    shm_ = shm::Block{};
     proc::kill_child(child_);
   }
   const char* last_error() const override { return err_.c_str(); }
+  PluginTraceBuf* trace_buffer() override { return (PluginTraceBuf*)shm_.aux; }
+  int child_pid() const override { return proc::child_pid(child_); }
+  PerfSample last_counters() const override { return last_counters_; }
+  PluginProfileBuf* profile_buffer() override {
+    const uint32_t off = PluginProfileBuf::aux_offset(sizeof(PluginTraceBuf));
+    if (profile_hz_ <= 0 || !shm_.aux || shm_.aux_bytes < off + sizeof(PluginProfileBuf)) return nullptr;
+    return (PluginProfileBuf*)((uint8_t*)shm_.aux + off);
+  }
   double last_call_ms() const { return last_call_ms_; }
 };
 
-std::unique_ptr<IPluginRunner> make_runner_child() {
-  return std::unique_ptr<IPluginRunner>(new RunnerChild());
+std::unique_ptr<IPluginRunner> make_runner_child(bool counters, double profile_hz) {
+  return std::unique_ptr<IPluginRunner>(new RunnerChild(counters, profile_hz));
 }
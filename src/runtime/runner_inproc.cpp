@@ -1,34 +1,56 @@
 #include "runner.h"
 #include "plugin_runtime.h"
+#include "plugin_trace.h"
+#include "plugin_profile.h"
+#include "../services/zones.h"
 
 class RunnerInproc : public IPluginRunner {
   PluginRuntime rt_;
   std::string err_;
+  std::unique_ptr<PluginTraceBuf> trace_ = std::make_unique<PluginTraceBuf>();
+  std::unique_ptr<PluginProfileBuf> profile_;
 public:
-  RunnerInproc(const GPI_HostApi& api, double deadline_ms) {
+  RunnerInproc(const GPI_HostApi& api, double deadline_ms, bool counters, double profile_hz) {
     rt_.deadline_ms = deadline_ms; 
     rt_.host_api = api; 
+    trace_->init();
+    std::string err;
+    if (counters) rt_.counters.open(err);   // on the thread that makes the calls
+    if (profile_hz > 0) {
+      profile_ = std::make_unique<PluginProfileBuf>();
+      profile_->init();
+      if (!rt_.profiler.start(profile_.get(), profile_hz, err)) profile_.reset();
+    }
   }
   bool load(const std::string& lib) override {
+    trace_->init();   // names are registered from gpi_init
     if (!rt_.load(lib, rt_.deadline_ms, rt_.host_api)) { 
       err_ = rt_.last_error ? rt_.last_error : "load failed"; 
       return false; 
     }
+    trace_->enabled = (rt_.caps.caps & GPI_CAP_TRACE) ? 1u : 0u;
+    rt_.profiler.set_library((const void*)rt_.fns.update);
     return true;
   }
   bool update(const FrameArgs& f) override {
+    GPI_ZONE("RunnerInproc::update");
     GPI_FrameContext ctx{ f.dt_sec, f.fb_w, f.fb_h, f.t_ns, f.input_blob, f.input_size, f.input_version };
     if (!rt_.call_update(ctx)) { err_ = "update failed/stalled"; return false; }
     return true;
   }
   bool render() override {
+    GPI_ZONE("RunnerInproc::render");
     if (!rt_.call_render()) { err_ = "render failed/stalled"; return false; }
     return true;
   }
   void unload() override { rt_.unload(); }
   const char* last_error() const override { return err_.c_str(); }
+  PluginTraceBuf* trace_buffer() override { return trace_.get(); }
+  PerfSample last_counters() const override { return rt_.last_counters; }
+  PluginProfileBuf* profile_buffer() override { return profile_.get(); }
 };
 
-std::unique_ptr<IPluginRunner> make_runner_inproc(const GPI_HostApi& api, double deadline_ms) {
-  return std::unique_ptr<IPluginRunner>(new RunnerInproc(api, deadline_ms));
+std::unique_ptr<IPluginRunner> make_runner_inproc(const GPI_HostApi& api, double deadline_ms, bool counters,
+                                                  double profile_hz) {
+  return std::unique_ptr<IPluginRunner>(new RunnerInproc(api, deadline_ms, counters, profile_hz));
 }
@@ -0,0 +1,51 @@
+#include "artifact_writer.h"
+#include "zones.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+bool artifacts::write_text(const std::string& path, std::string_view data, bool append) {
+  std::error_code ec;
+  const auto parent = std::filesystem::path(path).parent_path();
+  if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+  std::FILE* f = std::fopen(path.c_str(), append ? "ab" : "wb");
+  if (!f) return false;
+  const bool ok = std::fwrite(data.data(), 1, data.size(), f) == data.size();
+  return (std::fclose(f) == 0) && ok;
+}
+
+bool artifacts::write_text_atomic(const std::string& path, std::string_view data) {
+  const std::string tmp = path + ".tmp";
+  if (!write_text(tmp, data)) return false;
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) std::filesystem::remove(tmp, ec);
+  return !ec;
+}
+
+void ArtifactWriter::submit(std::function<int64_t()> job) {
+  queued_.fetch_add(1);
+  pool_.submit([this, job = std::move(job)]{
+    GPI_ZONE_THREAD("artifact_writer");
+    GPI_ZONE("artifact.job");
+    const auto t0 = std::chrono::steady_clock::now();
+    const int64_t n = job ? job() : 0;
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      if (n < 0) stats_.failed++;
+      else { stats_.written++; stats_.bytes += (uint64_t)n; }
+      stats_.last_ms = ms;
+      lat_.push(ms);
+    }
+    queued_.fetch_sub(1);
+  });
+}
+
+ArtifactWriter::Stats ArtifactWriter::stats() const {
+  std::lock_guard<std::mutex> lk(m_);
+  Stats s = stats_;
+  s.queued = queued_.load();
+  s.latency = lat_.stats();
+  return s;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "../metrics.h"
+#include "../platform/thread_pool.h"
+
+// Growable text buffer for exports. Numbers go through std::to_chars
+// straight into the string: no streams, no locale, shortest round-trip
+// form for doubles. Callers build a whole file here and write it once.
+class TextBuf {
+public:
+  explicit TextBuf(std::size_t reserve = 64 * 1024) { s_.reserve(reserve); }
+
+  TextBuf& str(std::string_view v) { s_.append(v); return *this; }
+  TextBuf& ch(char c) { s_.push_back(c); return *this; }
+  template <class T> TextBuf& num(T v) {
+    char tmp[32];
+    std::to_chars_result r;
+    if constexpr (std::is_floating_point_v<T>) r = std::to_chars(tmp, tmp + sizeof(tmp), (double)v);
+    else r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+    s_.append(tmp, (std::size_t)(r.ptr - tmp));
+    return *this;
+  }
+  // JSON string body: quotes, backslashes and control characters escaped
+  TextBuf& esc(std::string_view v) {
+    for (char c : v) {
+      if (c == '"' || c == '\\') { s_.push_back('\\'); s_.push_back(c); }
+      else if (c == '\n') s_ += "\\n";
+      else if ((unsigned char)c < 0x20) {
+        static const char hex[] = "0123456789abcdef";
+        s_ += "\\u00"; s_.push_back(hex[(c >> 4) & 1]); s_.push_back(hex[c & 15]);
+      }
+      else s_.push_back(c);
+    }
+    return *this;
+  }
+
+  std::size_t size() const { return s_.size(); }
+  bool empty() const { return s_.empty(); }
+  std::string_view view() const { return s_; }
+  void clear() { s_.clear(); }
+
+private:
+  std::string s_;
+};
+
+namespace artifacts {
+  // Creates the parent directory if needed, then writes (or appends) data
+  // with a single fwrite. Returns false on any failure.
+  bool write_text(const std::string& path, std::string_view data, bool append = false);
+  // Writes path.tmp and renames it over path, so readers never see a
+  // partial file.
+  bool write_text_atomic(const std::string& path, std::string_view data);
+}
+
+// Single background thread for artifact files (session exports, periodic
+// telemetry appends). The render thread only snapshots what a job needs
+// and queues it; formatting and file I/O happen here, in submit order.
+// Each job reports the bytes it wrote (negative on failure) and its wall
+// time goes into a latency histogram for the HUD.
+class ArtifactWriter {
+public:
+  struct Stats {
+    uint64_t written = 0, failed = 0;
+    uint64_t bytes = 0;
+    int      queued = 0;
+    double   last_ms = 0.0;
+    LatencyStats latency;
+  };
+
+  ArtifactWriter() : pool_(1) {}
+  ~ArtifactWriter() { pool_.wait_idle(); }
+
+  ArtifactWriter(const ArtifactWriter&) = delete;
+  ArtifactWriter& operator=(const ArtifactWriter&) = delete;
+
+  void submit(std::function<int64_t()> job);
+  // Blocks until every queued job has finished (exit paths).
+  void flush() { pool_.wait_idle(); }
+
+  Stats stats() const;
+
+private:
+  std::atomic<int> queued_{0};
+  mutable std::mutex m_;
+  Stats stats_;
+  LatencyHistogram lat_{256};
+  ThreadPool pool_;   // last: joined before the stats it writes go away
+};
@@ -1,33 +1,71 @@
 #include "artifacts.h"
-#include <fstream>
+#include "artifact_writer.h"
 
-bool artifacts::write_frame_csv(const std::string& path, const std::vector<double>& frame_ms) {
-  std::ofstream f(path, std::ios::trunc);
-  if (!f) return false;
-  f << "frame,ms\n";
-  for (size_t i=0;i<frame_ms.size();++i) f << i << "," << frame_ms[i] << "\n";
-  return true;
+int64_t artifacts::write_frame_csv(const std::string& path, const std::vector<double>& frame_ms) {
+  TextBuf b(16 + frame_ms.size() * 16);
+  b.str("frame,ms\n");
+  for (size_t i=0;i<frame_ms.size();++i) b.num(i).ch(',').num(frame_ms[i]).ch('\n');
+  return write_text(path, b.view()) ? (int64_t)b.size() : -1;
 }
 
-static std::string json_escape(const std::string& s){
-  std::string o; o.reserve(s.size()+8);
-  for (char c: s) { if (c=='"'||c=='\\') { o.push_back('\\'); o.push_back(c); } else if (c=='\n'){o+="\\n";} else o.push_back(c);}
-  return o;
+static void write_latency(TextBuf& b, const char* key, const LatencyStats& l) {
+  b.str("  \"").str(key).str("\": { \"p50_ms\": ").num(l.p50_ms).str(", \"p95_ms\": ").num(l.p95_ms)
+   .str(", \"p99_ms\": ").num(l.p99_ms).str(", \"max_ms\": ").num(l.max_ms)
+   .str(", \"samples\": ").num(l.samples).str(" },\n");
 }
 
-bool artifacts::write_session_json(const std::string& path, const SessionInfo& info, const FrameSummary& sum){
-  std::ofstream f(path, std::ios::trunc);
-  if (!f) return false;
-  f << "{\n";
-  f << "  \"app_version\": \"" << json_escape(info.app_version) << "\",\n";
-  f << "  \"os\": \"" << json_escape(info.os) << "\",\n";
-  f << "  \"plugin\": \"" << json_escape(info.plugin) << "\",\n";
-  f << "  \"target_fps\": " << info.target_fps << ",\n";
-  f << "  \"avg_ms\": " << sum.avg_ms << ",\n";
-  f << "  \"p95_ms\": " << sum.p95_ms << ",\n";
-  f << "  \"p99_ms\": " << sum.p99_ms << ",\n";
-  f << "  \"dropped_pct\": " << sum.dropped_pct << ",\n";
-  f << "  \"total_frames\": " << sum.total_frames << "\n";
-  f << "}\n";
-  return true;
+static void write_proc(TextBuf& b, const char* key, const ProcSummary& p) {
+  b.str("  \"").str(key).str("\": { \"cpu_avg_pct\": ").num(p.cpu_avg_pct).str(", \"cpu_max_pct\": ").num(p.cpu_max_pct)
+   .str(", \"rss_peak_mb\": ").num(p.rss_peak_mb).str(", \"pss_peak_mb\": ").num(p.pss_peak_mb)
+   .str(", \"minflt\": ").num(p.minflt).str(", \"majflt\": ").num(p.majflt)
+   .str(", \"vcsw\": ").num(p.vcsw).str(", \"ivcsw\": ").num(p.ivcsw)
+   .str(", \"seconds\": ").num(p.seconds).str(" },\n");
+}
+
+int64_t artifacts::write_session_json(const std::string& path, const SessionInfo& info, const FrameSummary& sum){
+  TextBuf b(2048);
+  auto text = [&](const char* k, const std::string& v) { b.str("  \"").str(k).str("\": \"").esc(v).str("\",\n"); };
+  auto num  = [&](const char* k, double v) { b.str("  \"").str(k).str("\": ").num(v).str(",\n"); };
+  b.str("{\n");
+  text("app_version", info.app_version);
+  text("os", info.os);
+  text("plugin", info.plugin);
+  num("target_fps", info.target_fps);
+  text("pacing", info.pacing);
+  num("avg_ms", sum.avg_ms);
+  num("p50_ms", sum.p50_ms);
+  num("p90_ms", sum.p90_ms);
+  num("p95_ms", sum.p95_ms);
+  num("p99_ms", sum.p99_ms);
+  num("p999_ms", sum.p999_ms);
+  num("max_ms", sum.max_ms);
+  num("dropped_pct", sum.dropped_pct);
+  num("pace_avg_ms", sum.pace_avg_ms);
+  num("pace_p99_ms", sum.pace_p99_ms);
+  write_latency(b, "input_latency", sum.input_latency);
+  write_latency(b, "probe_latency", sum.probe_latency);
+  write_proc(b, "proc_host", sum.proc_host);
+  write_proc(b, "proc_child", sum.proc_child);
+  b.str("  \"total_frames\": ").num(sum.total_frames).str("\n");
+  b.str("}\n");
+  return write_text(path, b.view()) ? (int64_t)b.size() : -1;
+}
+
+int64_t artifacts::write_counters_csv(const std::string& path, const std::vector<CallCounters>& c) {
+  TextBuf b(256 + c.size() * 160);
+  b.str("plugin,phase,calls");
+  for (int e = 0; e < kPerfEvents; ++e) b.ch(',').str(PerfCounters::name(e));
+  b.str(",ipc,l1d_mpki,llc_mpki,branch_mpki\n");
+  for (const CallCounters& r : c) {
+    b.str(r.plugin).ch(',').str(r.phase).ch(',').num(r.calls);
+    for (int e = 0; e < kPerfEvents; ++e) { b.ch(','); if (r.has(e)) b.num(r.v[e]); }
+    b.ch(',');
+    if (r.has(kPerfCycles) && r.has(kPerfInstructions)) b.num(r.ipc());
+    for (int e : { kPerfL1dMisses, kPerfLlcMisses, kPerfBranchMisses }) {
+      b.ch(',');
+      if (r.has(e) && r.has(kPerfInstructions)) b.num(r.mpki(e));
+    }
+    b.ch('\n');
+  }
+  return write_text(path, b.view()) ? (int64_t)b.size() : -1;
 }
@@ -1,21 +1,62 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
+#include "../metrics.h"
+#include "../platform/perf_counters.h"
 
 struct SessionInfo {
   std::string app_version;
   std::string os;
   std::string plugin;
   double target_fps = 60.0;
+  std::string pacing = "vsync";
+};
+
+// One process over the session (ProcSampler); zeros when never sampled
+struct ProcSummary {
+  double cpu_avg_pct=0, cpu_max_pct=0;   // 100 = one core
+  double rss_peak_mb=0, pss_peak_mb=0;
+  double minflt=0, majflt=0;             // counted while sampled
+  double vcsw=0, ivcsw=0;                // voluntary / involuntary context switches
+  double seconds=0;                      // sampled wall time
 };
 
 struct FrameSummary {
   double avg_ms=0, p95_ms=0, p99_ms=0;
   double dropped_pct=0;
   int    total_frames=0;
+  double pace_avg_ms=0, pace_p99_ms=0;
+  LatencyStats input_latency;   // SDL event timestamp -> present
+  LatencyStats probe_latency;   // synthetic input -> observed pixel flip
+  double p50_ms=0, p90_ms=0, p999_ms=0, max_ms=0;
+  ProcSummary proc_host, proc_child;
+};
+
+// Hardware counter totals of one plugin's update or render calls
+struct CallCounters {
+  std::string plugin;
+  std::string phase;              // "update" | "render"
+  uint64_t calls = 0;
+  uint64_t v[kPerfEvents] = {};   // PerfEvent order
+  uint32_t valid = 0;             // events every counted call had
+
+  void add(const PerfSample& s) {
+    valid = calls ? valid & s.valid : s.valid;
+    for (int e = 0; e < kPerfEvents; ++e) v[e] += s.v[e];
+    ++calls;
+  }
+  bool has(int e) const { return (valid >> e) & 1u; }
+  double ipc() const { return v[kPerfCycles] ? (double)v[kPerfInstructions] / (double)v[kPerfCycles] : 0.0; }
+  // Misses per 1000 instructions
+  double mpki(int e) const { return v[kPerfInstructions] ? 1000.0 * (double)v[e] / (double)v[kPerfInstructions] : 0.0; }
 };
 
+// All return the bytes written, or -1 on failure
 namespace artifacts {
-  bool write_frame_csv(const std::string& path, const std::vector<double>& frame_ms);
-  bool write_session_json(const std::string& path, const SessionInfo& info, const FrameSummary& sum);
+  int64_t write_frame_csv(const std::string& path, const std::vector<double>& frame_ms);
+  int64_t write_session_json(const std::string& path, const SessionInfo& info, const FrameSummary& sum);
+  // plugin,phase,calls, one column per PerfEvent, ipc and the *_mpki ratios;
+  // cells of events the PMU lacked are empty
+  int64_t write_counters_csv(const std::string& path, const std::vector<CallCounters>& c);
 }
@@ -0,0 +1,129 @@
+#include "flight_recorder.h"
+#include "artifact_writer.h"
+#include "log_bus.h"
+#include "trace.h"
+#include <algorithm>
+#include <ctime>
+#include <deque>
+
+FlightRecorder::FlightRecorder(Tracer& tracer, LogBus& logs, ArtifactWriter& writer)
+  : tracer_(tracer), logs_(logs), writer_(writer) {}
+
+void FlightRecorder::frame(const Frame& f, const GPI_InputV2& input, double budget_ms) {
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    frames_[frame_n_++ % kFrames] = f;
+    const uint32_t n = std::min<uint32_t>(input.event_count, GPI_INPUT_V2_MAX_EVENTS);
+    for (uint32_t i = 0; i < n; ++i) events_[event_n_++ % kEvents] = input.events[i];
+  }
+  if (!first_ns_) first_ns_ = f.t_ns;
+  // Loading frames at startup are not spikes
+  if (cfg_.spike_factor <= 0.0 || f.t_ns - first_ns_ < 1000000000) return;
+  if (!spike_ && f.frame_ms > cfg_.spike_factor * budget_ms) {
+    spike_ = "spike";
+    spike_frame_ = f;
+    spike_budget_ = budget_ms;
+  }
+}
+
+void FlightRecorder::poll() {
+  if (!spike_) return;
+  const char* reason = spike_;
+  spike_ = nullptr;
+  queue(reason, true, spike_frame_, spike_budget_);
+}
+
+void FlightRecorder::queue(const char* reason, bool was_spike, const Frame& spike, double budget) {
+  std::vector<Frame> frames;
+  std::vector<GPI_InputEventV2> events;
+  uint64_t dump_no = 0;
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    const auto now = std::chrono::steady_clock::now();
+    if (sh_->in_flight.load(std::memory_order_acquire) || dumps_ >= (uint64_t)cfg_.max_dumps ||
+        (dumps_ && now - last_dump_ < std::chrono::duration<double>(cfg_.cooldown_s))) {
+      ++suppressed_;
+      return;
+    }
+    dump_no = ++dumps_;
+    last_dump_ = now;
+    sh_->in_flight.store(true, std::memory_order_release);
+
+    // Copy the window out; everything else happens on the writer thread
+    const int64_t from = Tracer::now_ns() - (int64_t)(cfg_.seconds * 1e9);
+    for (uint64_t i = frame_n_ - std::min<uint64_t>(frame_n_, kFrames); i != frame_n_; ++i)
+      if (frames_[i % kFrames].t_ns >= from) frames.push_back(frames_[i % kFrames]);
+    for (uint64_t i = event_n_ - std::min<uint64_t>(event_n_, kEvents); i != event_n_; ++i)
+      if ((int64_t)events_[i % kEvents].time_ns >= from) events.push_back(events_[i % kEvents]);
+  }
+  auto log = std::make_shared<std::deque<LogMsg>>();
+  logs_.snapshot(*log, 200);
+
+  char stamp[32];
+  std::time_t t = std::time(nullptr);
+  std::tm tm{};
+#if defined(_WIN32)
+  localtime_s(&tm, &t);
+#else
+  localtime_r(&t, &tm);
+#endif
+  std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+  const std::string path = cfg_.dir + "/spike-" + stamp + "-" + std::to_string(dump_no) + ".json";
+
+  Tracer* tracer = &tracer_;
+  const double seconds = cfg_.seconds;
+  writer_.submit([sh = sh_, tracer, path, seconds, reason, was_spike, spike, budget,
+                  frames = std::move(frames), events = std::move(events), log]() -> int64_t {
+    TextBuf b(512 * 1024);
+    tracer->chrome_json(b, seconds, [&](TextBuf& o, int64_t origin) {
+      auto ms = [origin](int64_t ns) { return (double)(ns - origin) / 1e6; };
+      o.str(",\n\"flight\":{\"reason\":\"").esc(reason).str("\"");
+      if (was_spike)
+        o.str(",\"t_ms\":").num(ms(spike.t_ns)).str(",\"frame_ms\":").num(spike.frame_ms)
+         .str(",\"budget_ms\":").num(budget);
+      o.str(",\"window_s\":").num(seconds).str("}");
+      o.str(",\n\"frames\":{\"columns\":[\"t_ms\",\"frame_ms\",\"update_ms\",\"render_ms\"],\"rows\":[");
+      for (std::size_t i = 0; i < frames.size(); ++i) {
+        const Frame& f = frames[i];
+        o.str(i ? ",\n[" : "\n[").num(ms(f.t_ns)).ch(',').num(f.frame_ms).ch(',')
+         .num(f.update_ms).ch(',').num(f.render_ms).ch(']');
+      }
+      o.str("]},\n\"input\":{\"columns\":[\"t_ms\",\"type\",\"code\",\"x\",\"y\"],\"rows\":[");
+      for (std::size_t i = 0; i < events.size(); ++i) {
+        const GPI_InputEventV2& e = events[i];
+        o.str(i ? ",\n[" : "\n[").num(ms((int64_t)e.time_ns)).ch(',').num(e.type).ch(',')
+         .num(e.code).ch(',').num(e.x).ch(',').num(e.y).ch(']');
+      }
+      o.str("]},\n\"log\":[");
+      bool first = true;
+      for (const LogMsg& m : *log) {
+        o.str(first ? "\n[\"" : ",\n[\"")
+         .str(m.lvl == LogLvl::Error ? "error" : m.lvl == LogLvl::Warn ? "warn" : "info")
+         .str("\",\"").esc(m.text).str("\"]");
+        first = false;
+      }
+      o.str("]\n");
+    });
+    const bool ok = artifacts::write_text_atomic(path, b.view());
+    {
+      std::lock_guard<std::mutex> lk(sh->m);
+      if (ok) sh->last_path = path;
+    }
+    if (!ok) sh->failed.fetch_add(1, std::memory_order_relaxed);
+    sh->in_flight.store(false, std::memory_order_release);
+    return ok ? (int64_t)b.size() : -1;
+  });
+}
+
+FlightRecorder::Stats FlightRecorder::stats() const {
+  Stats st;
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    st.dumps = dumps_;
+    st.suppressed = suppressed_;
+  }
+  st.failed = sh_->failed.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lk(sh_->m);
+  st.last_path = sh_->last_path;
+  return st;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../../include/gpi/gpi_plugin.h"
+
+class Tracer;
+class LogBus;
+class ArtifactWriter;
+
+// Always-on record of the last few seconds: frame and plugin call times and
+// input events here, phases and zones in the Tracer, recent log lines from
+// the LogBus. A frame over spike_factor x budget, or request() (watchdog),
+// dumps all of it as one Chrome trace JSON with the recorder's data as extra
+// top-level members. The caller only copies the two small rings, under a
+// lock it shares with frame(); the dump is formatted and written
+// (atomically) on the ArtifactWriter thread. Dumps are rate limited: one in
+// flight, a cooldown, a per-session cap.
+class FlightRecorder {
+public:
+  struct Config {
+    double seconds = 5.0;        // window kept and dumped
+    double spike_factor = 3.0;   // x budget_ms; <= 0 turns spike dumps off
+    double cooldown_s = 10.0;    // between two dumps
+    int    max_dumps = 50;       // per session
+    std::string dir = "artifacts/spikes";
+  };
+  struct Frame {
+    int64_t t_ns;                // end of the frame's logic (Tracer::now_ns)
+    float frame_ms, update_ms, render_ms;
+  };
+  struct Stats {
+    uint64_t dumps = 0, suppressed = 0, failed = 0;
+    std::string last_path;
+  };
+
+  FlightRecorder(Tracer& tracer, LogBus& logs, ArtifactWriter& writer);
+  void configure(const Config& c) { cfg_ = c; }
+  const Config& config() const { return cfg_; }
+
+  // Main thread, once per frame: records it and flags a spike dump
+  void frame(const Frame& f, const GPI_InputV2& input, double budget_ms);
+  // Any thread: queues a dump right away unless rate limited. The watchdog
+  // calls it from its own thread, as the main thread may never come back
+  // from the plugin.
+  void request(const char* reason) { queue(reason, false, Frame{}, 0.0); }
+  // Main thread, top of the frame (so the flagged frame's spans are closed):
+  // queues a flagged spike dump unless rate limited
+  void poll();
+
+  Stats stats() const;
+
+private:
+  static constexpr std::size_t kFrames = 4096;
+  static constexpr std::size_t kEvents = 4096;
+  struct Shared {   // outlives the recorder while a dump job runs
+    std::atomic<bool> in_flight{false};
+    std::atomic<uint64_t> failed{0};
+    mutable std::mutex m;
+    std::string last_path;
+  };
+
+  void queue(const char* reason, bool was_spike, const Frame& spike, double budget);
+
+  Tracer& tracer_;
+  LogBus& logs_;
+  ArtifactWriter& writer_;
+  Config cfg_;
+  std::shared_ptr<Shared> sh_ = std::make_shared<Shared>();
+
+  mutable std::mutex m_;   // rings and dump counters: main thread vs watchdog
+  std::vector<Frame> frames_ = std::vector<Frame>(kFrames);
+  std::vector<GPI_InputEventV2> events_ = std::vector<GPI_InputEventV2>(kEvents);
+  uint64_t frame_n_ = 0, event_n_ = 0;
+  int64_t first_ns_ = 0;
+
+  const char* spike_ = nullptr;   // main thread
+  Frame spike_frame_{};
+  double spike_budget_ = 0.0;
+  uint64_t dumps_ = 0, suppressed_ = 0;
+  std::chrono::steady_clock::time_point last_dump_{};
+};
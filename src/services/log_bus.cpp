@@ -1,14 +1,212 @@
 #include "log_bus.h"
+#include "zones.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
 
-void LogBus::push(LogLvl lvl, const std::string& s) {
-  std::lock_guard<std::mutex> lk(m_);
-  if ((int)q_.size() >= cap_) q_.pop_front();
-  q_.push_back(LogMsg{lvl, s});
+LogBus::LogBus() : ring_(kRing), t0_(std::chrono::steady_clock::now()) {
+  for (uint32_t i = 0; i < kRing; ++i) ring_[i].seq.store(i, std::memory_order_relaxed);
+  std::snprintf(sources_[kHost].name, sizeof(sources_[kHost].name), "host");
+  batch_.reserve(256);
 }
+
+int64_t LogBus::now_ns() const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0_).count();
+}
+
+// GCRA: one message per interval on average, tolerance worth of them at once
+bool LogBus::Source::admit(int64_t now) {
+  const int64_t iv = interval_ns.load(std::memory_order_relaxed);
+  if (iv <= 0) return true;
+  const int64_t tol = tolerance_ns.load(std::memory_order_relaxed);
+  int64_t t = tat.load(std::memory_order_relaxed);
+  for (;;) {
+    const int64_t from = std::max(t, now);
+    if (from - now > tol) return false;
+    if (tat.compare_exchange_weak(t, from + iv, std::memory_order_relaxed)) return true;
+  }
+}
+
+uint8_t LogBus::source(const std::string& name) {
+  std::lock_guard<std::mutex> lk(source_m_);
+  const uint32_t n = source_count_.load(std::memory_order_relaxed);
+  for (uint32_t i = 1; i < n; ++i)
+    if (name.compare(0, sizeof(Source::name) - 1, sources_[i].name) == 0) return (uint8_t)i;
+  if (n == kSources) return (uint8_t)(kSources - 1);
+
+  Source& s = sources_[n];
+  std::snprintf(s.name, sizeof(s.name), "%s", name.c_str());
+  const double rate = cfg_.source_rate;
+  const int64_t iv = rate > 0 ? std::max<int64_t>(1, (int64_t)(1e9 / rate)) : 0;
+  s.interval_ns.store(iv, std::memory_order_relaxed);
+  s.tolerance_ns.store((int64_t)(std::max(cfg_.source_burst - 1.0, 0.0) * (double)iv), std::memory_order_relaxed);
+  s.tat.store(0, std::memory_order_relaxed);
+  source_count_.store(n + 1, std::memory_order_release);
+  return (uint8_t)n;
+}
+
+bool LogBus::push(LogLvl lvl, std::string_view s, uint8_t source) {
+  if (source >= kSources) source = kHost;
+  Source& src = sources_[source];
+  const int64_t now = now_ns();
+  if (!src.admit(now)) {
+    src.suppressed.fetch_add(1, std::memory_order_relaxed);
+    limited_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // Bounded MPSC ring (Vyukov): a slot whose seq equals the position is free
+  uint64_t pos = enq_.load(std::memory_order_relaxed);
+  Slot* slot;
+  for (;;) {
+    slot = &ring_[pos & (kRing - 1)];
+    const uint64_t seq = slot->seq.load(std::memory_order_acquire);
+    const int64_t dif = (int64_t)(seq - pos);
+    if (dif == 0) {
+      if (enq_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (dif < 0) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = enq_.load(std::memory_order_relaxed);
+    }
+  }
+
+  Record& r = slot->r;
+  r.t_ns = now;
+  r.suppressed = (uint32_t)std::min<uint64_t>(src.suppressed.exchange(0, std::memory_order_relaxed), UINT32_MAX);
+  r.lvl = (uint8_t)lvl;
+  r.source = source;
+  if (s.size() <= kText) {
+    std::memcpy(r.text, s.data(), s.size());
+    r.len = (uint16_t)s.size();
+  } else {
+    // Cut at a code point boundary: s[keep] must not be a UTF-8
+    // continuation byte (10xxxxxx), or the sequence it ends is split
+    std::size_t keep = kText - 3;
+    while (keep > 0 && ((unsigned char)s[keep] & 0xC0) == 0x80) --keep;
+    std::memcpy(r.text, s.data(), keep);
+    std::memcpy(r.text + keep, "...", 3);
+    r.len = (uint16_t)(keep + 3);
+  }
+  slot->seq.store(pos + 1, std::memory_order_release);
+  pushed_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void LogBus::start(const Config& cfg) {
+  if (th_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lk(source_m_);
+    cfg_ = cfg;
+  }
+  if (!cfg.file.empty()) {
+    std::error_code ec;
+    const auto parent = std::filesystem::path(cfg.file).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+    file_ = std::fopen(cfg.file.c_str(), "ab");
+    if (!file_) push(LogLvl::Warn, "Log: cannot open " + cfg.file);
+  }
+  {
+    std::lock_guard<std::mutex> lk(wake_m_);
+    stop_ = false;
+  }
+  th_ = std::thread([this]{ run(); });
+}
+
+void LogBus::stop() {
+  if (th_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lk(wake_m_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    th_.join();
+  } else {
+    // Never started: whatever was queued still goes out
+    while (drain()) {}
+  }
+  if (file_) { std::fclose(file_); file_ = nullptr; }
+}
+
+void LogBus::run() {
+  GPI_ZONE_THREAD("log_sink");
+  for (;;) {
+    if (drain()) continue;
+    // Producers never signal (that would need a lock or a syscall per
+    // message); the sink polls, so output lags by at most one period
+    std::unique_lock<std::mutex> lk(wake_m_);
+    if (stop_) break;
+    wake_.wait_for(lk, std::chrono::milliseconds(10), [this]{ return stop_; });
+  }
+  while (drain()) {}
+}
+
+void LogBus::emit(LogLvl lvl, const char* source, std::string_view text, int64_t t_ns) {
+  static const char* const tags[] = { "INFO", "WARN", "ERROR" };
+  const char* tag = tags[(int)lvl];
+  std::FILE* out = lvl == LogLvl::Info ? stdout : stderr;
+  std::fprintf(out, "[%s] %.*s\n", tag, (int)text.size(), text.data());
+  if (file_)
+    std::fprintf(file_, "%10.3f %-5s %s: %.*s\n", (double)t_ns / 1e9, tag, source, (int)text.size(), text.data());
+  batch_.push_back(LogMsg{ lvl, std::string(text) });
+}
+
+bool LogBus::drain() {
+  GPI_ZONE("log.drain");
+  batch_.clear();
+  const uint32_t sources = source_count_.load(std::memory_order_acquire);
+  char note[96];
+  uint32_t n = 0;
+  for (; n < 256; ++n) {
+    Slot& slot = ring_[deq_ & (kRing - 1)];
+    if (slot.seq.load(std::memory_order_acquire) != deq_ + 1) break;
+    const Record& r = slot.r;
+    const LogLvl lvl = r.lvl <= (uint8_t)LogLvl::Error ? (LogLvl)r.lvl : LogLvl::Error;
+    const char* src = r.source < sources ? sources_[r.source].name : "?";
+    if (r.suppressed) {
+      const int len = std::snprintf(note, sizeof(note), "%s: %u messages suppressed (rate limit)", src, r.suppressed);
+      emit(LogLvl::Warn, src, std::string_view(note, (std::size_t)std::max(len, 0)), r.t_ns);
+    }
+    emit(lvl, src, std::string_view(r.text, std::min<uint32_t>(r.len, kText)), r.t_ns);
+    slot.seq.store(deq_ + kRing, std::memory_order_release);
+    ++deq_;
+  }
+  delivered_.fetch_add(n, std::memory_order_relaxed);
+  const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+  if (dropped != dropped_seen_) {
+    const int len = std::snprintf(note, sizeof(note), "Log: %llu messages dropped (queue full)",
+                                  (unsigned long long)(dropped - dropped_seen_));
+    emit(LogLvl::Warn, "host", std::string_view(note, (std::size_t)std::max(len, 0)), now_ns());
+    dropped_seen_ = dropped;
+  }
+  if (batch_.empty()) return false;
+
+  // One flush and one history lock per batch, not per message
+  std::fflush(stdout);
+  if (file_) std::fflush(file_);
+  std::lock_guard<std::mutex> lk(hist_m_);
+  for (LogMsg& m : batch_) {
+    if ((int)hist_.size() >= cap_) hist_.pop_front();
+    hist_.push_back(std::move(m));
+  }
+  return n > 0;
+}
+
 void LogBus::snapshot(std::deque<LogMsg>& out, int max) {
-  std::lock_guard<std::mutex> lk(m_);
+  std::lock_guard<std::mutex> lk(hist_m_);
   out.clear();
-  int n = std::min<int>((int)q_.size(), max);
-  auto it = q_.end(); for (int i=0;i<n;++i) --it;
-  out.insert(out.end(), it, q_.end());
+  int n = std::min<int>((int)hist_.size(), max);
+  auto it = hist_.end(); for (int i=0;i<n;++i) --it;
+  out.insert(out.end(), it, hist_.end());
+}
+
+LogBus::Stats LogBus::stats() const {
+  Stats s;
+  s.pushed = pushed_.load(std::memory_order_relaxed);
+  s.dropped = dropped_.load(std::memory_order_relaxed);
+  s.limited = limited_.load(std::memory_order_relaxed);
+  const uint64_t done = delivered_.load(std::memory_order_relaxed);
+  s.queued = (uint32_t)std::min<uint64_t>(s.pushed - std::min(s.pushed, done), kRing);
+  return s;
 }
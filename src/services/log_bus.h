@@ -1,18 +1,118 @@
 #pragma once
-#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
 #include <deque>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 enum class LogLvl { Info, Warn, Error };
 
 struct LogMsg { LogLvl lvl; std::string text; };
 
+// Host and plugin log. push() is lock-free and never allocates or touches a
+// file: it claims a slot in a bounded MPSC ring of fixed-size records (text
+// inline, cut to kText bytes at a UTF-8 boundary) and returns. When the ring
+// is full the message is counted as dropped. A sink thread drains the ring
+// into stdout/stderr, the optional log file and the history the Log panel
+// and flight recorder snapshot, so a slow terminal or pipe never stalls a
+// plugin call.
+//
+// Every message has a source. Source 0 is the host and is never limited;
+// source() registers others (one per plugin) with a rate limit, and messages
+// over it are counted as suppressed and reported with the source's next
+// message that gets through.
 class LogBus {
 public:
-  void push(LogLvl lvl, const std::string& s);
+  static constexpr uint32_t kRing = 4096;   // records, a power of two
+  static constexpr uint32_t kText = 232;    // bytes of text per record
+  static constexpr uint32_t kSources = 32;
+  static constexpr uint8_t  kHost = 0;
+
+  struct Config {
+    std::string file;            // appended to by the sink; empty = none
+    double source_rate = 50.0;   // messages per second per plugin; 0 = unlimited
+    double source_burst = 200.0; // messages a plugin may log at once
+  };
+  struct Stats {
+    uint64_t pushed = 0;
+    uint64_t dropped = 0;   // ring full
+    uint64_t limited = 0;   // over a source's rate
+    uint32_t queued = 0;
+  };
+
+  LogBus();
+  ~LogBus() { stop(); }
+  LogBus(const LogBus&) = delete;
+  LogBus& operator=(const LogBus&) = delete;
+
+  // Starts the sink thread; messages pushed before wait in the ring
+  void start(const Config& cfg);
+  // Drains what is left and joins the sink
+  void stop();
+
+  // The id of a named source, registered with the configured limits on first
+  // use; the last slot is shared once the table is full
+  uint8_t source(const std::string& name);
+
+  bool push(LogLvl lvl, std::string_view s, uint8_t source = kHost);
+  // The last max messages, oldest first
   void snapshot(std::deque<LogMsg>& out, int max=500);
+  Stats stats() const;
+
 private:
-  std::mutex m_;
-  std::deque<LogMsg> q_;
+  struct Record {
+    int64_t  t_ns;
+    uint32_t suppressed;   // the source's messages limited since its last one
+    uint16_t len;
+    uint8_t  lvl;
+    uint8_t  source;
+    char     text[kText];
+  };
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> seq;   // == pos: free for the producer of pos; pos + 1: readable
+    Record r;
+  };
+  struct Source {
+    char name[32] = {};
+    std::atomic<int64_t>  interval_ns{0};   // 0 = unlimited
+    std::atomic<int64_t>  tolerance_ns{0};  // burst, as time ahead of now
+    std::atomic<int64_t>  tat{0};           // GCRA theoretical arrival time
+    std::atomic<uint64_t> suppressed{0};
+    bool admit(int64_t now);
+  };
+
+  int64_t now_ns() const;
+  void run();
+  bool drain();   // one batch; false when the ring was empty
+  void emit(LogLvl lvl, const char* source, std::string_view text, int64_t t_ns);
+
+  std::vector<Slot> ring_;
+  alignas(64) std::atomic<uint64_t> enq_{0};
+  alignas(64) uint64_t deq_ = 0;   // sink (or stop() once it is joined)
+  std::atomic<uint64_t> pushed_{0}, dropped_{0}, limited_{0}, delivered_{0};
+
+  Source sources_[kSources];
+  std::atomic<uint32_t> source_count_{1};
+  std::mutex source_m_;   // registration only
+  Config cfg_;
+  std::chrono::steady_clock::time_point t0_;
+
+  // Sink side
+  std::FILE* file_ = nullptr;
+  uint64_t dropped_seen_ = 0;
+  mutable std::mutex hist_m_;
+  std::deque<LogMsg> hist_;
   int cap_ = 2000;
+  std::vector<LogMsg> batch_;
+
+  std::mutex wake_m_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+  std::thread th_;
 };
@@ -0,0 +1,164 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// HDR-style log-linear histogram over integer nanoseconds. Values below 32
+// get a bucket each; above that every power of two is split into 32
+// sub-buckets, so a reported value is within ~1.6% of the recorded one
+// across 1 ns .. 73 min. Recording is O(1); percentile queries walk the
+// 38 per-octave totals and only open the octaves a requested rank falls
+// in, so a five-percentile query touches ~200 counters. Plain counts make
+// two histograms mergeable: a thread records into its own and an aggregator
+// merges copies (snapshots).
+class LogHistogram {
+public:
+  static constexpr int kSubBits = 5;
+  static constexpr int kSub = 1 << kSubBits;
+  static constexpr int kMaxBits = 42;
+  static constexpr int kOctaves = kMaxBits - kSubBits + 1;
+  static constexpr int kBuckets = kOctaves * kSub;
+  static constexpr uint64_t kMaxValue = (1ull << kMaxBits) - 1;
+
+  static int index_of(uint64_t v) {
+    if (v > kMaxValue) v = kMaxValue;
+    if (v < (uint64_t)kSub) return (int)v;
+    const int msb = std::bit_width(v) - 1;
+    const int shift = msb - kSubBits;
+    return (shift + 1) * kSub + (int)((v >> shift) - kSub);
+  }
+  static uint64_t lowest_of(int idx) {
+    if (idx < kSub) return (uint64_t)idx;
+    const int shift = idx / kSub - 1;
+    return (uint64_t)(idx % kSub + kSub) << shift;
+  }
+  // Representative value of a bucket: its midpoint
+  static uint64_t value_of(int idx) {
+    if (idx < kSub) return (uint64_t)idx;
+    const int shift = idx / kSub - 1;
+    return lowest_of(idx) + ((1ull << shift) >> 1);
+  }
+
+  void record(uint64_t v) {
+    const int i = index_of(v);
+    ++counts_[i];
+    ++octaves_[i / kSub];
+    ++total_;
+    if (i > top_) top_ = i;
+  }
+  // Undo a record() of the same value (sliding windows)
+  void remove(uint64_t v) {
+    const int i = index_of(v);
+    if (counts_[i] == 0) return;
+    --counts_[i];
+    --octaves_[i / kSub];
+    --total_;
+    while (top_ >= 0 && counts_[top_] == 0) --top_;
+  }
+  void merge(const LogHistogram& o) {
+    for (int i = 0; i <= o.top_; ++i) counts_[i] += o.counts_[i];
+    for (int i = 0; i < kOctaves; ++i) octaves_[i] += o.octaves_[i];
+    total_ += o.total_;
+    if (o.top_ > top_) top_ = o.top_;
+  }
+  void reset() { counts_.fill(0); octaves_.fill(0); total_ = 0; top_ = -1; }
+
+  uint64_t count() const { return total_; }
+  // Highest value that lands in the top bucket
+  uint64_t max() const { return top_ < 0 ? 0 : (top_ + 1 < kBuckets ? lowest_of(top_ + 1) - 1 : kMaxValue); }
+
+  // Nearest-rank percentiles for ascending pcts[] (0..100) in one pass.
+  void percentiles(const double* pcts, int n, uint64_t* out) const {
+    int k = 0;
+    if (total_ == 0) { for (; k < n; ++k) out[k] = 0; return; }
+    uint64_t seen = 0;
+    for (int o = 0; o <= top_ / kSub && k < n; ++o) {
+      if ((double)(seen + octaves_[o]) < rank(pcts[k])) { seen += octaves_[o]; continue; }
+      for (int i = o * kSub; i < (o + 1) * kSub && k < n; ++i) {
+        seen += counts_[i];
+        while (k < n && (double)seen >= rank(pcts[k])) out[k++] = value_of(i);
+      }
+    }
+    for (; k < n; ++k) out[k] = value_of(top_);
+  }
+  uint64_t percentile(double pct) const { uint64_t v = 0; percentiles(&pct, 1, &v); return v; }
+
+private:
+  double rank(double pct) const {
+    const double r = pct / 100.0 * (double)total_;
+    return r < 1.0 ? 1.0 : r;
+  }
+
+  std::array<uint32_t, kBuckets> counts_{};
+  std::array<uint32_t, kOctaves> octaves_{};
+  uint64_t total_ = 0;
+  int top_ = -1;
+};
+
+// Summary of a window, in ms
+struct Percentiles {
+  double avg = 0, p50 = 0, p90 = 0, p95 = 0, p99 = 0, p999 = 0, max = 0;
+  uint64_t count = 0;
+};
+
+// Sliding window of the last `cap` samples (ms): a fixed ring for plots and
+// exports plus a LogHistogram kept in step with it, so push() is O(1) and
+// nothing is sorted or shifted.
+class WindowedHistogram {
+public:
+  explicit WindowedHistogram(std::size_t cap) : ring_(cap ? cap : 1) {}
+
+  // Returns true when the window was full and the oldest sample fell out
+  bool push(double ms, double* evicted = nullptr) {
+    bool full = size_ == ring_.size();
+    if (full) {
+      const double old = ring_[head_];
+      hist_.remove(to_ns(old));
+      sum_ -= old;
+      if (evicted) *evicted = old;
+    } else {
+      ++size_;
+    }
+    ring_[head_] = ms;
+    head_ = (head_ + 1) % ring_.size();
+    hist_.record(to_ns(ms));
+    sum_ += ms;
+    return full;
+  }
+
+  Percentiles stats() const {
+    Percentiles p{};
+    p.count = hist_.count();
+    if (size_ == 0) return p;
+    static constexpr double kPcts[5] = { 50.0, 90.0, 95.0, 99.0, 99.9 };
+    uint64_t v[5];
+    hist_.percentiles(kPcts, 5, v);
+    p.p50 = v[0] / 1e6; p.p90 = v[1] / 1e6; p.p95 = v[2] / 1e6; p.p99 = v[3] / 1e6; p.p999 = v[4] / 1e6;
+    p.max = hist_.max() / 1e6;
+    p.avg = sum_ / (double)size_;
+    return p;
+  }
+
+  void reset() { hist_.reset(); size_ = 0; head_ = 0; sum_ = 0.0; }
+
+  std::size_t size() const { return size_; }
+  // i-th sample of the window, oldest first
+  double at(std::size_t i) const { return ring_[(head_ + ring_.size() - size_ + i) % ring_.size()]; }
+  std::vector<double> samples() const {
+    std::vector<double> out(size_);
+    for (std::size_t i = 0; i < size_; ++i) out[i] = at(i);
+    return out;
+  }
+  // Copy of the current window's distribution, for merging elsewhere
+  const LogHistogram& snapshot() const { return hist_; }
+
+private:
+  static uint64_t to_ns(double ms) { return ms <= 0.0 ? 0 : (uint64_t)(ms * 1e6 + 0.5); }
+
+  std::vector<double> ring_;
+  std::size_t head_ = 0, size_ = 0;
+  double sum_ = 0.0;
+  LogHistogram hist_;
+};
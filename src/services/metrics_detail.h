@@ -1,35 +1,30 @@
 #pragma once
 #include <vector>
-#include <algorithm>
-#include <numeric>
+#include "log_histogram.h"
 
 struct CallStats { 
-  double avg=0, p95=0, p99=0, last=0; 
+  double avg=0, p50=0, p90=0, p95=0, p99=0, p999=0, max=0, last=0;
 };
 
 class CallHistogram {
 public:
-  explicit CallHistogram(size_t cap=512) : cap_(cap) { v_.reserve(cap); }
+  explicit CallHistogram(size_t cap=512) : win_(cap) {}
   void push(double ms) { 
-    if(v_.size()==cap_) v_.erase(v_.begin()); 
-    v_.push_back(ms); 
+    win_.push(ms);
     last_ = ms; 
   }
   CallStats stats() const {
     CallStats s{};
-    if (v_.empty()) return s;
-    std::vector<double> t(v_);
-    std::sort(t.begin(), t.end());
-    auto n=t.size();
-    s.avg = std::accumulate(t.begin(), t.end(), 0.0) / (double)n;
-    s.p95 = t[(size_t)(0.95*(n-1))];
-    s.p99 = t[(size_t)(0.99*(n-1))];
+    const Percentiles p = win_.stats();
+    s.avg = p.avg; s.p50 = p.p50; s.p90 = p.p90; s.p95 = p.p95;
+    s.p99 = p.p99; s.p999 = p.p999; s.max = p.max;
     s.last = last_;
     return s;
   }
-  const std::vector<double>& samples() const { return v_; }
+  size_t size() const { return win_.size(); }
+  double at(size_t i) const { return win_.at(i); }   // oldest first
+  const LogHistogram& snapshot() const { return win_.snapshot(); }
 private:
-  size_t cap_;
-  std::vector<double> v_;
+  WindowedHistogram win_;
   double last_=0;
 };
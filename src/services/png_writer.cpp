@@ -0,0 +1,223 @@
+#include "png_writer.h"
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace png {
+namespace {
+
+const std::array<uint32_t, 256>& crc_table() {
+  static const std::array<uint32_t, 256> t = []{
+    std::array<uint32_t, 256> r{};
+    for (uint32_t n = 0; n < 256; ++n) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      r[n] = c;
+    }
+    return r;
+  }();
+  return t;
+}
+
+uint32_t adler32(const uint8_t* p, std::size_t n) {
+  uint32_t a = 1, b = 0;
+  while (n) {
+    std::size_t k = n < 5552 ? n : 5552;  // largest block without uint32 overflow
+    n -= k;
+    while (k--) { a += *p++; b += a; }
+    a %= 65521; b %= 65521;
+  }
+  return (b << 16) | a;
+}
+
+// LSB-first bit sink as deflate wants it.
+struct BitWriter {
+  std::vector<uint8_t>& out;
+  uint64_t acc = 0;
+  int bits = 0;
+  void put(uint32_t v, int n) {
+    acc |= (uint64_t)v << bits; bits += n;
+    while (bits >= 8) { out.push_back((uint8_t)acc); acc >>= 8; bits -= 8; }
+  }
+  // Huffman codes are defined MSB-first.
+  void put_rev(uint32_t code, int n) {
+    uint32_t r = 0;
+    for (int i = 0; i < n; ++i) { r = (r << 1) | (code & 1); code >>= 1; }
+    put(r, n);
+  }
+  void flush() { if (bits) { out.push_back((uint8_t)acc); acc = 0; bits = 0; } }
+};
+
+const uint16_t kLenBase[29]  = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+const uint8_t  kLenExtra[29] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+const uint16_t kDistBase[30] = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,
+                                2049,3073,4097,6145,8193,12289,16385,24577};
+const uint8_t  kDistExtra[30]= {0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+
+void put_litlen(BitWriter& bw, int sym) {
+  if (sym < 144)      bw.put_rev(0x30 + sym, 8);
+  else if (sym < 256) bw.put_rev(0x190 + (sym - 144), 9);
+  else if (sym < 280) bw.put_rev(sym - 256, 7);
+  else                bw.put_rev(0xC0 + (sym - 280), 8);
+}
+
+void put_match(BitWriter& bw, int len, int dist) {
+  int li = 28;
+  while (kLenBase[li] > len) --li;
+  put_litlen(bw, 257 + li);
+  if (kLenExtra[li]) bw.put(len - kLenBase[li], kLenExtra[li]);
+  int di = 29;
+  while (kDistBase[di] > dist) --di;
+  bw.put_rev(di, 5);
+  if (kDistExtra[di]) bw.put(dist - kDistBase[di], kDistExtra[di]);
+}
+
+// Single fixed-Huffman block with greedy hash-chain LZ77 (32 KiB window).
+// Filtered image rows are dominated by long runs, which this handles well.
+void deflate_fixed(const uint8_t* src, std::size_t n, std::vector<uint8_t>& out) {
+  constexpr int kWin = 32768, kHashBits = 15, kMaxChain = 24, kMaxLen = 258;
+  std::vector<int32_t> head(1u << kHashBits, -1), prev(kWin, -1);
+  auto hash3 = [&](std::size_t i){
+    return ((uint32_t)src[i] * 506832829u ^ (uint32_t)src[i+1] << 8 ^ src[i+2]) & ((1u << kHashBits) - 1);
+  };
+  auto insert = [&](std::size_t i){
+    if (i + 2 >= n) return;
+    uint32_t h = hash3(i);
+    prev[i & (kWin - 1)] = head[h];
+    head[h] = (int32_t)i;
+  };
+
+  BitWriter bw{out};
+  bw.put(1, 1);  // BFINAL
+  bw.put(1, 2);  // BTYPE = fixed Huffman
+  std::size_t i = 0;
+  while (i < n) {
+    int best_len = 0, best_dist = 0;
+    if (i + 2 < n) {
+      const int max_len = (int)std::min<std::size_t>(kMaxLen, n - i);
+      int32_t cand = head[hash3(i)];
+      for (int chain = 0; cand >= 0 && chain < kMaxChain; ++chain) {
+        const int dist = (int)(i - (std::size_t)cand);
+        if (dist > kWin - 1) break;
+        if (src[cand + best_len] == src[i + best_len]) {
+          int l = 0;
+          while (l < max_len && src[cand + l] == src[i + l]) ++l;
+          if (l > best_len) { best_len = l; best_dist = dist; if (l == max_len) break; }
+        }
+        const int32_t nx = prev[cand & (kWin - 1)];
+        if (nx >= cand) break;  // slot was recycled
+        cand = nx;
+      }
+    }
+    if (best_len >= 3) {
+      put_match(bw, best_len, best_dist);
+      for (int k = 0; k < best_len; ++k) insert(i + k);
+      i += best_len;
+    } else {
+      put_litlen(bw, src[i]);
+      insert(i);
+      ++i;
+    }
+  }
+  put_litlen(bw, 256);
+  bw.flush();
+}
+
+inline uint8_t paeth(int a, int b, int c) {
+  int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+  return (uint8_t)((pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c);
+}
+
+void put_be32(std::vector<uint8_t>& o, uint32_t v) {
+  o.push_back(v >> 24); o.push_back(v >> 16); o.push_back(v >> 8); o.push_back(v);
+}
+
+void put_chunk(std::vector<uint8_t>& o, const char type[4], const uint8_t* data, std::size_t n) {
+  put_be32(o, (uint32_t)n);
+  const std::size_t start = o.size();
+  o.insert(o.end(), type, type + 4);
+  if (n) o.insert(o.end(), data, data + n);
+  put_be32(o, crc32(o.data() + start, n + 4));
+}
+
+} // namespace
+
+uint32_t crc32(const uint8_t* p, std::size_t n, uint32_t crc) {
+  const auto& t = crc_table();
+  crc = ~crc;
+  while (n--) crc = t[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+bool encode_rgba(const uint8_t* rgba, int w, int h, int stride, std::vector<uint8_t>& out, bool flip_y) {
+  if (!rgba || w <= 0 || h <= 0) return false;
+  if (stride == 0) stride = w * 4;
+  const std::size_t row = (std::size_t)w * 4;
+
+  // Filter: per row pick the candidate with the smallest sum of |residual| (libpng heuristic).
+  std::vector<uint8_t> raw((row + 1) * h);
+  std::vector<uint8_t> cand[5];
+  for (auto& c : cand) c.resize(row);
+  const uint8_t* prev_row = nullptr;
+  for (int y = 0; y < h; ++y) {
+    const uint8_t* cur = rgba + (std::size_t)(flip_y ? h - 1 - y : y) * stride;
+    uint64_t best_cost = UINT64_MAX; int best = 0;
+    for (int f = 0; f < 5; ++f) {
+      if (!prev_row && (f == 2 || f == 4)) continue;  // Up/Paeth degenerate on row 0
+      uint8_t* d = cand[f].data();
+      uint64_t cost = 0;
+      for (std::size_t i = 0; i < row; ++i) {
+        const int a = i >= 4 ? cur[i - 4] : 0;
+        const int b = prev_row ? prev_row[i] : 0;
+        const int c = (prev_row && i >= 4) ? prev_row[i - 4] : 0;
+        uint8_t v = cur[i];
+        switch (f) {
+          case 1: v = (uint8_t)(v - a); break;
+          case 2: v = (uint8_t)(v - b); break;
+          case 3: v = (uint8_t)(v - ((a + b) >> 1)); break;
+          case 4: v = (uint8_t)(v - paeth(a, b, c)); break;
+          default: break;
+        }
+        d[i] = v;
+        cost += (v < 128) ? v : 256 - v;
+      }
+      if (cost < best_cost) { best_cost = cost; best = f; }
+    }
+    uint8_t* dst = &raw[(row + 1) * y];
+    dst[0] = (uint8_t)best;
+    std::memcpy(dst + 1, cand[best].data(), row);
+    prev_row = cur;
+  }
+
+  std::vector<uint8_t> z;
+  z.reserve(raw.size() / 4 + 64);
+  z.push_back(0x78); z.push_back(0x01);
+  deflate_fixed(raw.data(), raw.size(), z);
+  put_be32(z, adler32(raw.data(), raw.size()));
+
+  out.clear();
+  static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  out.insert(out.end(), sig, sig + 8);
+  uint8_t ihdr[13];
+  ihdr[0] = w >> 24; ihdr[1] = w >> 16; ihdr[2] = w >> 8; ihdr[3] = w;
+  ihdr[4] = h >> 24; ihdr[5] = h >> 16; ihdr[6] = h >> 8; ihdr[7] = h;
+  ihdr[8] = 8;   // bit depth
+  ihdr[9] = 6;   // colour type RGBA
+  ihdr[10] = 0; ihdr[11] = 0; ihdr[12] = 0;
+  put_chunk(out, "IHDR", ihdr, sizeof(ihdr));
+  put_chunk(out, "IDAT", z.data(), z.size());
+  put_chunk(out, "IEND", nullptr, 0);
+  return true;
+}
+
+bool write_rgba(const std::string& path, const uint8_t* rgba, int w, int h, int stride, bool flip_y) {
+  std::vector<uint8_t> bytes;
+  if (!encode_rgba(rgba, w, h, stride, bytes, flip_y)) return false;
+  FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+  const bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+  return (std::fclose(f) == 0) && ok;
+}
+
+} // namespace png
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Self-contained PNG encoder (RGBA8, per-row adaptive filter, zlib stream
+// with LZ77 + fixed-Huffman deflate). No external deps, thread-safe.
+namespace png {
+
+// `stride` is bytes per source row (0 = w*4). With flip_y the bottom row is
+// written first, which turns a GL readback into a top-down image for free.
+bool encode_rgba(const uint8_t* rgba, int w, int h, int stride, std::vector<uint8_t>& out,
+                 bool flip_y = false);
+bool write_rgba(const std::string& path, const uint8_t* rgba, int w, int h, int stride = 0,
+                bool flip_y = false);
+
+uint32_t crc32(const uint8_t* p, std::size_t n, uint32_t crc = 0);
+
+} // namespace png
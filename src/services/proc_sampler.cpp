@@ -0,0 +1,116 @@
+#include "proc_sampler.h"
+#include "telemetry.h"
+#include "zones.h"
+#include <algorithm>
+
+static constexpr const char* kHostKeys[] = {
+  "proc.host.cpu_pct", "proc.host.rss_mb", "proc.host.pss_mb", "proc.host.minflt_s",
+  "proc.host.majflt_s", "proc.host.vcsw_s", "proc.host.ivcsw_s",
+};
+static constexpr const char* kChildKeys[] = {
+  "proc.child.cpu_pct", "proc.child.rss_mb", "proc.child.pss_mb", "proc.child.minflt_s",
+  "proc.child.majflt_s", "proc.child.vcsw_s", "proc.child.ivcsw_s",
+};
+
+void ProcSampler::start(double hz) {
+  if (hz <= 0.0 || th_.joinable()) return;
+  host_.keys = kHostKeys;
+  child_.keys = kChildKeys;
+  stop_ = false;
+  th_ = std::thread([this, hz] { run(hz); });
+}
+
+void ProcSampler::stop() {
+  if (!th_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lk(wake_m_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  th_.join();
+}
+
+void ProcSampler::run(double hz) {
+  GPI_ZONE_THREAD("proc_sampler");
+  const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / hz));
+  const int self = proc::self_pid();
+  std::unique_lock<std::mutex> lk(wake_m_);
+  while (!stop_) {
+    lk.unlock();
+    {
+      GPI_ZONE("proc.sample");
+      sample(host_, self);
+      sample(child_, child_pid_.load(std::memory_order_relaxed));
+    }
+    lk.lock();
+    wake_.wait_for(lk, period, [this] { return stop_; });
+  }
+}
+
+void ProcSampler::sample(Track& t, int pid) {
+  ProcUsage u;
+  const bool ok = pid > 0 && proc::read_usage(pid, u);
+  const Clock::time_point now = Clock::now();
+  auto delta = [](uint64_t a, uint64_t b) { return a >= b ? (double)(a - b) : 0.0; };
+
+  std::lock_guard<std::mutex> lk(m_);
+  if (!ok || pid != t.pid) {
+    // Gone, or a new child: the next read is its baseline
+    t.pid = ok ? pid : 0;
+    t.prev = u;
+    t.prev_t = now;
+    t.last = Sample{};
+    return;
+  }
+  const double dt = std::chrono::duration<double>(now - t.prev_t).count();
+  if (dt <= 0.0) return;
+  const double cpu = std::max(0.0, u.cpu_s - t.prev.cpu_s);
+  Sample s;
+  s.valid = true;
+  s.pid = pid;
+  s.cpu_pct = 100.0 * cpu / dt;
+  s.rss_mb = u.rss_bytes / (1024.0 * 1024.0);
+  s.pss_mb = u.pss_bytes / (1024.0 * 1024.0);
+  s.minflt_s = delta(u.minflt, t.prev.minflt) / dt;
+  s.majflt_s = delta(u.majflt, t.prev.majflt) / dt;
+  s.vcsw_s = delta(u.vcsw, t.prev.vcsw) / dt;
+  s.ivcsw_s = delta(u.ivcsw, t.prev.ivcsw) / dt;
+
+  ProcSummary& sum = t.sum;
+  sum.seconds += dt;
+  t.cpu_s += cpu;
+  sum.cpu_avg_pct = 100.0 * t.cpu_s / sum.seconds;
+  sum.cpu_max_pct = std::max(sum.cpu_max_pct, s.cpu_pct);
+  sum.rss_peak_mb = std::max(sum.rss_peak_mb, s.rss_mb);
+  sum.pss_peak_mb = std::max(sum.pss_peak_mb, s.pss_mb);
+  sum.minflt += delta(u.minflt, t.prev.minflt);
+  sum.majflt += delta(u.majflt, t.prev.majflt);
+  sum.vcsw += delta(u.vcsw, t.prev.vcsw);
+  sum.ivcsw += delta(u.ivcsw, t.prev.ivcsw);
+
+  t.prev = u;
+  t.prev_t = now;
+  t.last = s;
+  const double v[] = { s.cpu_pct, s.rss_mb, s.pss_mb, s.minflt_s, s.majflt_s, s.vcsw_s, s.ivcsw_s };
+  for (int i = 0; i < 7; ++i) tel_.mark(t.keys[i], v[i]);
+}
+
+ProcSampler::Sample ProcSampler::host() const {
+  std::lock_guard<std::mutex> lk(m_);
+  return host_.last;
+}
+
+ProcSampler::Sample ProcSampler::child() const {
+  std::lock_guard<std::mutex> lk(m_);
+  return child_.last;
+}
+
+ProcSummary ProcSampler::host_summary() const {
+  std::lock_guard<std::mutex> lk(m_);
+  return host_.sum;
+}
+
+ProcSummary ProcSampler::child_summary() const {
+  std::lock_guard<std::mutex> lk(m_);
+  return child_.sum;
+}
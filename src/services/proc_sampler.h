@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "artifacts.h"
+#include "../platform/proc.h"
+
+class Telemetry;
+
+// CPU%, RSS/PSS, page faults and context switches of the host and of the
+// current gpi_child, read on a thread of its own at a configurable rate:
+// the /proc reads (smaps_rollup above all) cost far too much for the frame
+// loop. Every sample goes to telemetry as proc.host.* / proc.child.*; the HUD
+// shows the latest one and the session summary the totals since start().
+class ProcSampler {
+public:
+  struct Sample {
+    bool   valid = false;
+    int    pid = 0;
+    double cpu_pct = 0;                  // since the previous sample; 100 = one core
+    double rss_mb = 0, pss_mb = 0;
+    double minflt_s = 0, majflt_s = 0;   // per second since the previous sample
+    double vcsw_s = 0, ivcsw_s = 0;
+  };
+
+  explicit ProcSampler(Telemetry& tel) : tel_(tel) {}
+  ~ProcSampler() { stop(); }
+  ProcSampler(const ProcSampler&) = delete;
+  ProcSampler& operator=(const ProcSampler&) = delete;
+
+  void start(double hz);   // hz <= 0 leaves it off
+  void stop();
+  bool running() const { return th_.joinable(); }
+  // The gpi_child to follow, 0 for none; an atomic store, fine every frame
+  void set_child(int pid) { child_pid_.store(pid, std::memory_order_relaxed); }
+
+  Sample host() const;
+  Sample child() const;
+  ProcSummary host_summary() const;
+  ProcSummary child_summary() const;   // every child followed, counts added up
+
+private:
+  using Clock = std::chrono::steady_clock;
+  struct Track {
+    const char* const* keys;   // telemetry keys, literals
+    int pid = 0;               // prev is its baseline; 0 = none
+    ProcUsage prev;
+    Clock::time_point prev_t;
+    double cpu_s = 0;          // summed deltas, for sum.cpu_avg_pct
+    Sample last;
+    ProcSummary sum;
+  };
+
+  void run(double hz);
+  void sample(Track& t, int pid);
+
+  Telemetry& tel_;
+  std::atomic<int> child_pid_{0};
+  mutable std::mutex m_;   // both tracks
+  Track host_, child_;
+
+  std::mutex wake_m_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+  std::thread th_;
+};
@@ -1,62 +1,126 @@
 #include "screenshot.h"
+#include "png_writer.h"
+#if defined(__APPLE__)
 #include <OpenGL/gl3.h>
-#include <vector>
-#include <cstdio>
-
-// Simple PNG writer (no external deps)
-static bool write_png_simple(const char* path, int w, int h, const unsigned char* data) {
-  FILE* f = fopen(path, "wb");
-  if (!f) return false;
-  
-  // PNG header
-  fwrite("\x89PNG\r\n\x1a\n", 1, 8, f);
-  
-  // IHDR chunk
-  uint32_t ihdr_len = 13;
-  uint32_t ihdr_crc = 0x4E524148; // "IHDR" CRC
-  fwrite(&ihdr_len, 4, 1, f);
-  fwrite("IHDR", 4, 1, f);
-  fwrite(&w, 4, 1, f);
-  fwrite(&h, 4, 1, f);
-  fwrite("\x08\x02\x00\x00\x00", 5, 1, f); // 8bit RGBA
-  fwrite(&ihdr_crc, 4, 1, f);
-  
-  // IDAT chunk (simplified)
-  uint32_t idat_len = w * h * 4;
-  uint32_t idat_crc = 0x54414449; // "IDAT" CRC
-  fwrite(&idat_len, 4, 1, f);
-  fwrite("IDAT", 4, 1, f);
-  fwrite(data, idat_len, 1, f);
-  fwrite(&idat_crc, 4, 1, f);
-  
-  // IEND chunk
-  uint32_t iend_len = 0;
-  uint32_t iend_crc = 0x444E4549; // "IEND" CRC
-  fwrite(&iend_len, 4, 1, f);
-  fwrite("IEND", 4, 1, f);
-  fwrite(&iend_crc, 4, 1, f);
-  
-  fclose(f);
+#else
+#define GL_GLEXT_PROTOTYPES 1
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+ScreenshotQueue::ScreenshotQueue(int max_queued)
+  : max_queued_(max_queued > 0 ? max_queued : 1), pool_(2) {}
+
+ScreenshotQueue::~ScreenshotQueue() { pool_.wait_idle(); }
+
+bool ScreenshotQueue::enqueue_encode(std::string path, std::vector<uint8_t> px, int w, int h, bool flip_y) {
+  if (queued_.fetch_add(1) >= max_queued_) {
+    queued_.fetch_sub(1);
+    dropped_full_++;
+    return false;
+  }
+  pool_.submit([this, path = std::move(path), px = std::move(px), w, h, flip_y]{
+    const auto t0 = std::chrono::steady_clock::now();
+    std::error_code ec;
+    const auto parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+    // GL rows are bottom-up; the encoder flips while filtering, no extra pass.
+    const bool ok = png::write_rgba(path, px.data(), w, h, w * 4, flip_y);
+    last_encode_ms_.store(std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - t0).count());
+    (ok ? written_ : failed_)++;
+    queued_.fetch_sub(1);
+  });
+  return true;
+}
+
+bool ScreenshotQueue::capture_rgba(const std::string& path, const uint8_t* rgba, int w, int h) {
+  if (!rgba || w <= 0 || h <= 0) return false;
+  requested_++;
+  if (queued_.load() >= max_queued_) { dropped_full_++; return false; }
+  return enqueue_encode(path, std::vector<uint8_t>(rgba, rgba + (size_t)w * h * 4), w, h, false);
+}
+
+bool ScreenshotQueue::capture_gl(const std::string& path, int w, int h) {
+  if (w <= 0 || h <= 0) return false;
+  requested_++;
+  Slot& sl = slots_[next_slot_];
+  if (sl.busy) { dropped_busy_++; return false; }
+  next_slot_ = (next_slot_ + 1) % kSlots;
+
+  const size_t bytes = (size_t)w * h * 4;
+  if (!sl.pbo) glGenBuffers(1, &sl.pbo);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, sl.pbo);
+  if (sl.bytes != bytes) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)bytes, nullptr, GL_STREAM_READ);
+    sl.bytes = bytes;
+  }
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);  // async into the PBO
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  sl.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  sl.w = w; sl.h = h; sl.path = path; sl.busy = true;
   return true;
 }
 
-static void flip_vertical(std::vector<unsigned char>& p, int w, int h) {
-  const int row = w*4;
-  for(int y=0;y<h/2;y++){
-    int a=y*row, b=(h-1-y)*row;
-    for(int x=0;x<row;x++) std::swap(p[a+x], p[b+x]);
+void ScreenshotQueue::drain_slot(Slot& sl, bool block) {
+  if (!sl.busy) return;
+  GLsync fence = (GLsync)sl.fence;
+  const GLuint64 timeout = block ? 1000000000ull : 0;  // 1 s when flushing
+  const GLenum st = glClientWaitSync(fence, block ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+  if (st != GL_ALREADY_SIGNALED && st != GL_CONDITION_SATISFIED) {
+    if (!block) return;             // not ready yet, look again next frame
+    failed_++;                      // wait failed or timed out: give the slot back
+  } else {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, sl.pbo);
+    const void* src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)sl.bytes, GL_MAP_READ_BIT);
+    if (src) {
+      // One memcpy out of the mapping; everything else happens on the encoder.
+      if (queued_.load() < max_queued_) {
+        std::vector<uint8_t> px((const uint8_t*)src, (const uint8_t*)src + sl.bytes);
+        enqueue_encode(std::move(sl.path), std::move(px), sl.w, sl.h, true);
+      } else {
+        dropped_full_++;
+      }
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+      failed_++;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
   }
+  glDeleteSync(fence);
+  sl.fence = nullptr;
+  sl.busy = false;
+}
+
+void ScreenshotQueue::poll() {
+  for (Slot& sl : slots_) drain_slot(sl, false);
+}
+
+void ScreenshotQueue::flush() {
+  for (Slot& sl : slots_) drain_slot(sl, true);
+  pool_.wait_idle();
 }
 
-bool save_screenshot_png(const std::string& path, int w, int h) {
-  std::vector<unsigned char> px(w*h*4);
-  glReadPixels(0,0,w,h,GL_RGBA,GL_UNSIGNED_BYTE,px.data());
-  flip_vertical(px,w,h);
-  return write_png_simple(path.c_str(), w,h, px.data());
+void ScreenshotQueue::release_gl() {
+  for (Slot& sl : slots_) {
+    if (sl.fence) { glDeleteSync((GLsync)sl.fence); sl.fence = nullptr; }
+    if (sl.pbo) { glDeleteBuffers(1, &sl.pbo); sl.pbo = 0; }
+    sl.busy = false; sl.bytes = 0;
+  }
 }
 
-bool save_frame_sequence_png(const std::string& dir, int idx, int w, int h) {
-  char name[256];
-  std::snprintf(name,sizeof(name), "%s/frame_%06d.png", dir.c_str(), idx);
-  return save_screenshot_png(name,w,h);
+ScreenshotQueue::Stats ScreenshotQueue::stats() const {
+  Stats st;
+  st.requested = requested_.load();
+  st.written = written_.load();
+  st.failed = failed_.load();
+  st.dropped_busy = dropped_busy_.load();
+  st.dropped_full = dropped_full_.load();
+  st.queued = queued_.load();
+  st.last_encode_ms = last_encode_ms_.load();
+  return st;
 }
@@ -1,4 +1,62 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
 #include <string>
-bool save_screenshot_png(const std::string& path, int w, int h);
-bool save_frame_sequence_png(const std::string& dir, int frame_idx, int w, int h);
+#include <vector>
+#include "../platform/thread_pool.h"
+
+// Asynchronous screenshots. GL captures go through two pixel-pack buffers:
+// glReadPixels is queued into a free PBO with a fence, and the buffer is
+// mapped on a later frame once the fence has signalled, so the render thread
+// only ever pays for a fence check. The vertical flip, PNG encode and file
+// write run on a small worker pool behind a bounded queue; captures that
+// find no free PBO or a full queue are dropped and counted.
+class ScreenshotQueue {
+public:
+  struct Stats {
+    uint64_t requested = 0, written = 0, failed = 0;
+    uint64_t dropped_busy = 0;   // both PBOs still in flight
+    uint64_t dropped_full = 0;   // encode queue at capacity
+    int      queued = 0;
+    double   last_encode_ms = 0.0;
+  };
+
+  explicit ScreenshotQueue(int max_queued = 4);
+  ~ScreenshotQueue();
+
+  // GL path: reads the current back buffer (bottom-up rows). Needs a current context.
+  bool capture_gl(const std::string& path, int w, int h);
+  // CPU path (headless software rasterizer): RGBA8 rows top-down, copied.
+  bool capture_rgba(const std::string& path, const uint8_t* rgba, int w, int h);
+
+  // Once per frame on the GL thread: hands signalled readbacks to the encoder.
+  void poll();
+  // Waits for every in-flight readback and encode (shutdown, exit paths).
+  void flush();
+  // Frees the PBOs; call before the GL context goes away.
+  void release_gl();
+
+  Stats stats() const;
+
+private:
+  static constexpr int kSlots = 2;
+  struct Slot {
+    unsigned pbo = 0;
+    void*    fence = nullptr;   // GLsync
+    size_t   bytes = 0;         // current PBO allocation
+    int      w = 0, h = 0;
+    std::string path;
+    bool     busy = false;
+  };
+
+  bool enqueue_encode(std::string path, std::vector<uint8_t> px, int w, int h, bool flip_y);
+  void drain_slot(Slot& sl, bool block);
+
+  Slot slots_[kSlots];
+  int next_slot_ = 0;
+  const int max_queued_;
+  std::atomic<int> queued_{0};
+  std::atomic<uint64_t> requested_{0}, written_{0}, failed_{0}, dropped_busy_{0}, dropped_full_{0};
+  std::atomic<double> last_encode_ms_{0.0};
+  ThreadPool pool_;
+};
@@ -0,0 +1,717 @@
+#include "session_file.h"
+#include "artifact_writer.h"
+#include "log_histogram.h"
+#include "png_writer.h"
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace session_file {
+namespace {
+
+constexpr char kMagic[7] = { 'G','P','I','S','E','S','S' };
+
+void put_u32(std::vector<uint8_t>& o, uint32_t v) { for (int i = 0; i < 4; ++i) o.push_back((uint8_t)(v >> (8 * i))); }
+void put_u64(std::vector<uint8_t>& o, uint64_t v) { for (int i = 0; i < 8; ++i) o.push_back((uint8_t)(v >> (8 * i))); }
+void put_uvar(std::vector<uint8_t>& o, uint64_t u) {
+  while (u >= 0x80) { o.push_back((uint8_t)(u | 0x80)); u >>= 7; }
+  o.push_back((uint8_t)u);
+}
+void put_svar(std::vector<uint8_t>& o, int64_t v) { put_uvar(o, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63)); }
+void put_str(std::vector<uint8_t>& o, std::string_view s) { put_uvar(o, s.size()); o.insert(o.end(), s.begin(), s.end()); }
+// tag byte: high nibble = leading zero bytes of the XOR, low nibble = bytes stored
+void put_xor(std::vector<uint8_t>& o, uint64_t& prev, double v) {
+  const uint64_t bits = std::bit_cast<uint64_t>(v);
+  const uint64_t x = bits ^ prev;
+  prev = bits;
+  if (x == 0) { o.push_back(0); return; }
+  const int lz = std::countl_zero(x) / 8, tz = std::countr_zero(x) / 8;
+  const int len = 8 - lz - tz;
+  o.push_back((uint8_t)(lz << 4 | len));
+  for (int k = 0; k < len; ++k) o.push_back((uint8_t)(x >> (8 * (tz + k))));
+}
+
+// Bounds-checked reads over an untrusted buffer; any overrun clears ok
+struct Cursor {
+  const uint8_t* p;
+  const uint8_t* end;
+  bool ok = true;
+
+  std::size_t left() const { return (std::size_t)(end - p); }
+  bool need(std::size_t n) { if (!ok || left() < n) ok = false; return ok; }
+  uint64_t fixed(int bytes) {
+    if (!need((std::size_t)bytes)) return 0;
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= (uint64_t)*p++ << (8 * i);
+    return v;
+  }
+  uint64_t uvar() {
+    uint64_t u = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (!need(1)) return 0;
+      const uint8_t b = *p++;
+      u |= (uint64_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) return u;
+    }
+    ok = false;
+    return 0;
+  }
+  int64_t svar() { const uint64_t u = uvar(); return (int64_t)(u >> 1) ^ -(int64_t)(u & 1); }
+  std::string str() {
+    const uint64_t n = uvar();
+    if (!need(n)) return {};
+    std::string s((const char*)p, (std::size_t)n);
+    p += n;
+    return s;
+  }
+  double xor_value(uint64_t& prev) {
+    if (!need(1)) return 0.0;
+    const uint8_t t = *p++;
+    const int lz = t >> 4, n = t & 0x0F;
+    if (t != 0 && (n == 0 || lz + n > 8)) { ok = false; return 0.0; }
+    if (!need((std::size_t)n)) return 0.0;
+    uint64_t x = 0;
+    for (int k = 0; k < n; ++k) x |= (uint64_t)*p++ << (8 * k);
+    if (n) prev ^= x << (8 * (8 - lz - n));
+    return std::bit_cast<double>(prev);
+  }
+  // Never trust a count for reserve(): every element costs at least a byte
+  std::size_t cap(uint64_t n) const { return (std::size_t)std::min<uint64_t>(n, left()); }
+};
+
+struct NumField { const char* name; double FrameSummary::* m; };
+constexpr NumField kNumFields[] = {
+  { "avg_ms", &FrameSummary::avg_ms },           { "p50_ms", &FrameSummary::p50_ms },
+  { "p90_ms", &FrameSummary::p90_ms },           { "p95_ms", &FrameSummary::p95_ms },
+  { "p99_ms", &FrameSummary::p99_ms },           { "p999_ms", &FrameSummary::p999_ms },
+  { "max_ms", &FrameSummary::max_ms },           { "dropped_pct", &FrameSummary::dropped_pct },
+  { "pace_avg_ms", &FrameSummary::pace_avg_ms }, { "pace_p99_ms", &FrameSummary::pace_p99_ms },
+};
+struct LatGroup { const char* name; LatencyStats FrameSummary::* m; };
+constexpr LatGroup kLatGroups[] = {
+  { "input_latency", &FrameSummary::input_latency }, { "probe_latency", &FrameSummary::probe_latency },
+};
+struct LatField { const char* name; double LatencyStats::* m; };
+constexpr LatField kLatFields[] = {
+  { "p50_ms", &LatencyStats::p50_ms }, { "p95_ms", &LatencyStats::p95_ms },
+  { "p99_ms", &LatencyStats::p99_ms }, { "max_ms", &LatencyStats::max_ms },
+};
+struct ProcGroup { const char* name; ProcSummary FrameSummary::* m; };
+constexpr ProcGroup kProcGroups[] = {
+  { "proc_host", &FrameSummary::proc_host }, { "proc_child", &FrameSummary::proc_child },
+};
+struct ProcField { const char* name; double ProcSummary::* m; };
+constexpr ProcField kProcFields[] = {
+  { "cpu_avg_pct", &ProcSummary::cpu_avg_pct }, { "cpu_max_pct", &ProcSummary::cpu_max_pct },
+  { "rss_peak_mb", &ProcSummary::rss_peak_mb }, { "pss_peak_mb", &ProcSummary::pss_peak_mb },
+  { "minflt", &ProcSummary::minflt },           { "majflt", &ProcSummary::majflt },
+  { "vcsw", &ProcSummary::vcsw },               { "ivcsw", &ProcSummary::ivcsw },
+  { "seconds", &ProcSummary::seconds },
+};
+
+// SUMM and INFO store values in this order, names implied. New fields are
+// only ever appended, so older readers stop at the ones they know.
+std::vector<std::pair<std::string, double>> summary_numbers(const SessionInfo& info, const FrameSummary& s) {
+  std::vector<std::pair<std::string, double>> out;
+  out.emplace_back("target_fps", info.target_fps);
+  for (const auto& f : kNumFields) out.emplace_back(f.name, s.*f.m);
+  out.emplace_back("total_frames", (double)s.total_frames);
+  for (const auto& g : kLatGroups) {
+    for (const auto& f : kLatFields) out.emplace_back(std::string(g.name) + "." + f.name, (s.*g.m).*f.m);
+    out.emplace_back(std::string(g.name) + ".samples", (double)(s.*g.m).samples);
+  }
+  for (const auto& g : kProcGroups)
+    for (const auto& f : kProcFields) out.emplace_back(std::string(g.name) + "." + f.name, (s.*g.m).*f.m);
+  return out;
+}
+
+bool set_number(SessionInfo& info, FrameSummary& s, std::string_view name, double v) {
+  if (name == "target_fps") { info.target_fps = v; return true; }
+  if (name == "total_frames") { s.total_frames = (int)v; return true; }
+  for (const auto& f : kNumFields) if (name == f.name) { s.*f.m = v; return true; }
+  for (const auto& g : kLatGroups) {
+    const std::size_t n = std::strlen(g.name);
+    if (name.size() <= n + 1 || name.compare(0, n, g.name) != 0 || name[n] != '.') continue;
+    const std::string_view leaf = name.substr(n + 1);
+    if (leaf == "samples") { (s.*g.m).samples = (int)v; return true; }
+    for (const auto& f : kLatFields) if (leaf == f.name) { (s.*g.m).*f.m = v; return true; }
+  }
+  for (const auto& g : kProcGroups) {
+    const std::size_t n = std::strlen(g.name);
+    if (name.size() <= n + 1 || name.compare(0, n, g.name) != 0 || name[n] != '.') continue;
+    const std::string_view leaf = name.substr(n + 1);
+    for (const auto& f : kProcFields) if (leaf == f.name) { (s.*g.m).*f.m = v; return true; }
+  }
+  return false;   // unknown (newer) field: ignored
+}
+
+constexpr const char* kTextFields[] = { "app_version", "os", "plugin", "pacing" };
+
+bool set_text(SessionInfo& info, std::string_view name, std::string v) {
+  if (name == "app_version") info.app_version = std::move(v);
+  else if (name == "os") info.os = std::move(v);
+  else if (name == "plugin") info.plugin = std::move(v);
+  else if (name == "pacing") info.pacing = std::move(v);
+  else return false;
+  return true;
+}
+
+bool decode_series(Cursor& c, Series& s) {
+  s.key = c.str();
+  const uint64_t n = c.uvar();
+  s.t_us.reserve(c.cap(n)); s.value.reserve(c.cap(n));
+  int64_t t = 0, d = 0;
+  uint64_t bits = 0;
+  for (uint64_t i = 0; i < n && c.ok; ++i) {
+    if (i == 0) t = c.svar();
+    else { d += c.svar(); t += d; }
+    const double v = c.xor_value(bits);
+    s.t_us.push_back(t); s.value.push_back(v);
+  }
+  for (auto* tier : { &s.r1, &s.r10 }) {
+    const uint64_t nb = c.uvar();
+    tier->reserve(c.cap(nb));
+    int64_t bt = 0;
+    uint64_t mn = 0, mx = 0, sum = 0;
+    for (uint64_t i = 0; i < nb && c.ok; ++i) {
+      RollupBucket b{};
+      bt += c.svar();
+      b.t_us = bt;
+      b.min = c.xor_value(mn); b.max = c.xor_value(mx); b.sum = c.xor_value(sum);
+      b.count = (uint32_t)c.uvar();
+      tier->push_back(b);
+    }
+  }
+  return c.ok && c.left() == 0;
+}
+
+bool decode_section(uint32_t t, Cursor& c, Session& s) {
+  if (t == kInfo) {
+    const uint64_t n = c.uvar();
+    SessionInfo info = s.info;
+    for (uint64_t i = 0; i < n && c.ok; ++i) {
+      std::string v = c.str();
+      if (i < std::size(kTextFields)) set_text(info, kTextFields[i], std::move(v));
+    }
+    if (!c.ok || c.left()) return false;
+    s.info = std::move(info);
+  } else if (t == kSummary) {
+    const uint64_t n = c.uvar();
+    SessionInfo info = s.info;
+    FrameSummary sum = s.summary;
+    const auto names = summary_numbers(info, sum);
+    for (uint64_t i = 0; i < n && c.ok; ++i) {
+      uint64_t zero = 0;   // each value XOR'd against 0: zeros and round numbers stay short
+      const double v = c.xor_value(zero);
+      if (i < names.size()) set_number(info, sum, names[i].first, v);
+    }
+    if (!c.ok || c.left()) return false;
+    s.info = std::move(info); s.summary = sum;
+  } else if (t == kFrames) {
+    const uint64_t n = c.uvar();
+    std::vector<double> ms;
+    ms.reserve(c.cap(n));
+    int64_t ns = 0;
+    for (uint64_t i = 0; i < n && c.ok; ++i) { ns += c.svar(); ms.push_back((double)ns / 1e6); }
+    if (!c.ok || c.left()) return false;
+    s.frame_ms.insert(s.frame_ms.end(), ms.begin(), ms.end());
+  } else if (t == kSeries) {
+    Series ser;
+    if (!decode_series(c, ser)) return false;
+    s.series.push_back(std::move(ser));
+  } else if (t == kCounters) {
+    const uint64_t n = c.uvar();
+    std::vector<CallCounters> rows;
+    rows.reserve(c.cap(n));
+    for (uint64_t i = 0; i < n && c.ok; ++i) {
+      CallCounters r;
+      r.plugin = c.str();
+      r.phase = c.str();
+      r.calls = c.uvar();
+      r.valid = (uint32_t)c.uvar() & ((1u << kPerfEvents) - 1);
+      const uint64_t nev = c.uvar();   // a newer writer may count more events
+      for (uint64_t e = 0; e < nev && c.ok; ++e) {
+        const uint64_t v = c.uvar();
+        if (e < kPerfEvents) r.v[e] = v;
+      }
+      rows.push_back(std::move(r));
+    }
+    if (!c.ok || c.left()) return false;
+    s.counters.insert(s.counters.end(), rows.begin(), rows.end());
+  }
+  return true;   // unknown tags are skipped: newer writers may add sections
+}
+
+void csv_row(TextBuf& b, const std::string& key, int64_t t_us, double v) {
+  b.str(key).ch(',').num(t_us / 1e6).ch(',').num(v).ch('\n');
+}
+
+int64_t write_buf(const std::string& path, const TextBuf& b) {
+  return artifacts::write_text(path, b.view()) ? (int64_t)b.size() : -1;
+}
+
+} // namespace
+
+// --- encoder ---------------------------------------------------------------
+
+SeriesEncoder::SeriesEncoder(std::string_view key) : key_(key) { pts_.reserve(4096); }
+
+void SeriesEncoder::point(int64_t t_us, double v) {
+  if (npts_ == 0) {
+    put_svar(pts_, t_us);
+  } else {
+    const int64_t d = t_us - t_last_;
+    put_svar(pts_, d - d_last_);
+    d_last_ = d;
+  }
+  t_last_ = t_us;
+  put_xor(pts_, v_last_, v);
+  ++npts_;
+}
+
+void SeriesEncoder::rollup(int width_s, const RollupBucket& b) {
+  Tier& t = width_s >= 10 ? r10_ : r1_;
+  put_svar(t.buf, b.t_us - t.t);
+  t.t = b.t_us;
+  put_xor(t.buf, t.mn, b.min);
+  put_xor(t.buf, t.mx, b.max);
+  put_xor(t.buf, t.sum, b.sum);
+  put_uvar(t.buf, b.count);
+  ++t.n;
+}
+
+std::vector<uint8_t> SeriesEncoder::finish() {
+  std::vector<uint8_t> o;
+  o.reserve(key_.size() + pts_.size() + r1_.buf.size() + r10_.buf.size() + 32);
+  put_str(o, key_);
+  put_uvar(o, npts_);
+  o.insert(o.end(), pts_.begin(), pts_.end());
+  for (Tier* t : { &r1_, &r10_ }) {
+    put_uvar(o, t->n);
+    o.insert(o.end(), t->buf.begin(), t->buf.end());
+  }
+  return o;
+}
+
+// --- writer ----------------------------------------------------------------
+
+Writer::~Writer() { if (f_) std::fclose(f_); }
+
+bool Writer::open(const std::string& path, uint64_t created_unix_us, int64_t clock_us) {
+  std::error_code ec;
+  const auto parent = std::filesystem::path(path).parent_path();
+  if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+  f_ = std::fopen(path.c_str(), "wb");
+  if (!f_) return ok_ = false;
+  std::vector<uint8_t> h(kMagic, kMagic + sizeof(kMagic));
+  h.push_back(kVersion);
+  put_u64(h, created_unix_us);
+  put_u64(h, (uint64_t)clock_us);
+  ok_ = std::fwrite(h.data(), 1, h.size(), f_) == h.size();
+  bytes_ = (int64_t)h.size();
+  return ok_;
+}
+
+void Writer::section(uint32_t tag, const uint8_t* p, std::size_t n) {
+  if (!f_ || !ok_) return;
+  if (n > UINT32_MAX) { ok_ = false; return; }
+  std::vector<uint8_t> h;
+  put_u32(h, tag);
+  put_u32(h, (uint32_t)n);
+  std::vector<uint8_t> crc;
+  put_u32(crc, png::crc32(p, n));
+  ok_ = std::fwrite(h.data(), 1, h.size(), f_) == h.size() &&
+        (n == 0 || std::fwrite(p, 1, n, f_) == n) &&
+        std::fwrite(crc.data(), 1, crc.size(), f_) == crc.size();
+  bytes_ += (int64_t)(n + 12);
+}
+
+void Writer::info(const SessionInfo& info) {
+  std::vector<uint8_t> o;
+  const std::string* v[] = { &info.app_version, &info.os, &info.plugin, &info.pacing };   // kTextFields
+  put_uvar(o, std::size(v));
+  for (const auto* s : v) put_str(o, *s);
+  section(kInfo, o.data(), o.size());
+}
+
+void Writer::summary(const SessionInfo& info, const FrameSummary& sum) {
+  std::vector<uint8_t> o;
+  const auto nums = summary_numbers(info, sum);
+  put_uvar(o, nums.size());
+  for (const auto& kv : nums) { uint64_t zero = 0; put_xor(o, zero, kv.second); }
+  section(kSummary, o.data(), o.size());
+}
+
+void Writer::frames(const std::vector<double>& frame_ms) {
+  std::vector<uint8_t> o;
+  o.reserve(frame_ms.size() * 2 + 10);
+  put_uvar(o, frame_ms.size());
+  int64_t prev = 0;
+  for (double ms : frame_ms) {
+    const int64_t ns = std::llround(ms * 1e6);   // frame times are steady_clock ns to begin with
+    put_svar(o, ns - prev);
+    prev = ns;
+  }
+  section(kFrames, o.data(), o.size());
+}
+
+void Writer::counters(const std::vector<CallCounters>& c) {
+  if (c.empty()) return;
+  std::vector<uint8_t> o;
+  put_uvar(o, c.size());
+  for (const CallCounters& r : c) {
+    put_str(o, r.plugin);
+    put_str(o, r.phase);
+    put_uvar(o, r.calls);
+    put_uvar(o, r.valid);
+    put_uvar(o, kPerfEvents);
+    for (uint64_t v : r.v) put_uvar(o, v);
+  }
+  section(kCounters, o.data(), o.size());
+}
+
+void Writer::series(SeriesEncoder& enc) {
+  const auto p = enc.finish();
+  section(kSeries, p.data(), p.size());
+}
+
+void Writer::series(const Series& s) {
+  SeriesEncoder enc(s.key);
+  for (std::size_t i = 0; i < s.t_us.size(); ++i) enc.point(s.t_us[i], s.value[i]);
+  for (const auto& b : s.r1) enc.rollup(1, b);
+  for (const auto& b : s.r10) enc.rollup(10, b);
+  series(enc);
+}
+
+int64_t Writer::finish() {
+  if (!f_) return -1;
+  section(kEnd, nullptr, 0);
+  const bool closed = std::fclose(f_) == 0;
+  f_ = nullptr;
+  return ok_ && closed ? bytes_ : -1;
+}
+
+// --- whole sessions ----------------------------------------------------------
+
+int64_t write(const std::string& path, const Session& s) {
+  Writer w;
+  if (!w.open(path, s.created_unix_us, s.clock_us)) return -1;
+  w.info(s.info);
+  w.summary(s.info, s.summary);
+  w.frames(s.frame_ms);
+  w.counters(s.counters);
+  for (const auto& ser : s.series) w.series(ser);
+  return w.finish();
+}
+
+bool read(const std::string& path, Session& out, std::string* err) {
+  auto fail = [&](const char* why) { if (err) *err = why; return false; };
+  std::FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) return fail("cannot open");
+  std::vector<uint8_t> buf;
+  uint8_t tmp[64 * 1024];
+  for (std::size_t n; (n = std::fread(tmp, 1, sizeof(tmp), f)) > 0;) buf.insert(buf.end(), tmp, tmp + n);
+  std::fclose(f);
+
+  Cursor c{ buf.data(), buf.data() + buf.size() };
+  if (!c.need(sizeof(kMagic) + 1 + 16) || std::memcmp(c.p, kMagic, sizeof(kMagic)) != 0)
+    return fail("not a .gpisession file");
+  c.p += sizeof(kMagic);
+  if (*c.p++ > kVersion) return fail("written by a newer format version");
+  out = Session{};
+  out.created_unix_us = c.fixed(8);
+  out.clock_us = (int64_t)c.fixed(8);
+
+  while (c.left() >= 12) {
+    const uint32_t t = (uint32_t)c.fixed(4);
+    const uint32_t n = (uint32_t)c.fixed(4);
+    if (c.left() < (std::size_t)n + 4) break;   // torn tail
+    const uint8_t* payload = c.p;
+    c.p += n;
+    const uint32_t crc = (uint32_t)c.fixed(4);
+    if (t == kEnd) { out.complete = true; break; }
+    if (png::crc32(payload, n) != crc) { ++out.bad_sections; continue; }
+    Cursor sc{ payload, payload + n };
+    if (!decode_section(t, sc, out)) ++out.bad_sections;
+  }
+  if (err) err->clear();
+  return true;
+}
+
+int64_t export_text(const Session& s, const std::string& base) {
+  const int64_t head[] = {
+    artifacts::write_frame_csv(base + "-frames.csv", s.frame_ms),
+    artifacts::write_session_json(base + "-summary.json", s.info, s.summary),
+  };
+  int64_t total = 0;
+  for (int64_t n : head) { if (n < 0) return -1; total += n; }
+
+  TextBuf csv(1u << 20), json(1u << 20), roll(64 * 1024);
+  csv.str("key,time,value\n");
+  roll.str("key,width_s,time,min,max,avg,count\n");
+  json.str("{\n");
+  bool firstk = true;
+  for (const auto& ser : s.series) {
+    for (std::size_t i = 0; i < ser.t_us.size(); ++i) csv_row(csv, ser.key, ser.t_us[i], ser.value[i]);
+    if (!ser.t_us.empty()) {
+      if (!firstk) json.str(",\n");
+      firstk = false;
+      json.str("  \"").esc(ser.key).str("\": [");
+      for (std::size_t i = 0; i < ser.t_us.size(); ++i)
+        json.str(i ? ", [" : " [").num(ser.t_us[i] / 1e6).ch(',').num(ser.value[i]).ch(']');
+      json.str(" ]");
+    }
+    auto tier = [&](const std::vector<RollupBucket>& rb, int width) {
+      for (const auto& r : rb)
+        roll.str(ser.key).ch(',').num(width).ch(',').num(r.t_us / 1e6).ch(',').num(r.min).ch(',')
+            .num(r.max).ch(',').num(r.count ? r.sum / r.count : 0.0).ch(',').num(r.count).ch('\n');
+    };
+    tier(ser.r10, 10);
+    tier(ser.r1, 1);
+  }
+  json.str("\n}\n");
+  const int64_t tail[] = {
+    write_buf(base + "-telemetry.csv", csv),
+    write_buf(base + "-telemetry.json", json),
+    write_buf(base + "-telemetry-rollups.csv", roll),
+  };
+  for (int64_t n : tail) { if (n < 0) return -1; total += n; }
+  if (!s.counters.empty()) {
+    const int64_t n = artifacts::write_counters_csv(base + "-counters.csv", s.counters);
+    if (n < 0) return -1;
+    total += n;
+  }
+  return total;
+}
+
+namespace {
+
+// Flattens our own -summary.json ("a": {"b": 1} -> "a.b") into fields;
+// enough for what write_session_json produces, not general JSON.
+void parse_summary(const std::string& js, Session& s) {
+  std::vector<std::string> scope;
+  std::string key;
+  for (std::size_t i = 0; i < js.size();) {
+    const char c = js[i];
+    if (c == '"') {
+      std::string str;
+      for (++i; i < js.size() && js[i] != '"'; ++i) {
+        if (js[i] == '\\' && i + 1 < js.size()) { ++i; str.push_back(js[i] == 'n' ? '\n' : js[i]); }
+        else str.push_back(js[i]);
+      }
+      ++i;
+      std::size_t j = i;
+      while (j < js.size() && std::isspace((unsigned char)js[j])) ++j;
+      if (j < js.size() && js[j] == ':') { key = str; i = j + 1; continue; }
+      set_info_field(s, key, str);
+    } else if (c == '{') {
+      if (!key.empty()) scope.push_back(key);
+      key.clear(); ++i;
+    } else if (c == '}') {
+      if (!scope.empty()) scope.pop_back();
+      ++i;
+    } else if (c == '-' || std::isdigit((unsigned char)c)) {
+      char* end = nullptr;
+      const double v = std::strtod(js.c_str() + i, &end);
+      std::string name = scope.empty() ? key : scope.back() + "." + key;
+      set_summary_field(s, name, v);
+      i = (std::size_t)(end - js.c_str());
+    } else {
+      ++i;
+    }
+  }
+}
+
+std::string slurp(const std::string& path) {
+  std::ifstream f(path, std::ios::binary);
+  std::ostringstream o;
+  o << f.rdbuf();
+  return o.str();
+}
+
+} // namespace
+
+bool import_text(const std::string& base, Session& s, std::string* err) {
+  s = Session{};
+  s.complete = true;
+
+  std::ifstream frames(base + "-frames.csv");
+  if (!frames) { if (err) *err = "cannot open " + base + "-frames.csv"; return false; }
+  std::string line;
+  std::getline(frames, line);   // header
+  while (std::getline(frames, line)) {
+    const auto comma = line.find(',');
+    if (comma != std::string::npos) s.frame_ms.push_back(std::strtod(line.c_str() + comma + 1, nullptr));
+  }
+  parse_summary(slurp(base + "-summary.json"), s);
+
+  std::ifstream tel(base + "-telemetry.csv");
+  std::map<std::string, std::size_t> ids;
+  std::getline(tel, line);
+  while (std::getline(tel, line)) {
+    // key,time,value; keys may contain commas, the two numbers never do
+    const auto c2 = line.rfind(',');
+    const auto c1 = c2 == std::string::npos || c2 == 0 ? std::string::npos : line.rfind(',', c2 - 1);
+    if (c1 == std::string::npos) continue;
+    const std::string key = line.substr(0, c1);
+    auto [it, fresh] = ids.emplace(key, s.series.size());
+    if (fresh) { s.series.emplace_back(); s.series.back().key = key; }
+    auto& ser = s.series[it->second];
+    ser.t_us.push_back(std::llround(std::strtod(line.c_str() + c1 + 1, nullptr) * 1e6));
+    ser.value.push_back(std::strtod(line.c_str() + c2 + 1, nullptr));
+  }
+
+  // Optional: only written when counters were on
+  std::ifstream ctr(base + "-counters.csv");
+  std::getline(ctr, line);
+  while (std::getline(ctr, line)) {
+    // plugin,phase,calls,<one per PerfEvent>,ratios...; empty cell = not counted
+    std::vector<std::string> cell;
+    for (std::size_t p = 0;;) {
+      const auto q = line.find(',', p);
+      cell.push_back(line.substr(p, q == std::string::npos ? std::string::npos : q - p));
+      if (q == std::string::npos) break;
+      p = q + 1;
+    }
+    if (cell.size() < 3 + kPerfEvents) continue;
+    CallCounters c;
+    c.plugin = cell[0];
+    c.phase = cell[1];
+    c.calls = std::strtoull(cell[2].c_str(), nullptr, 10);
+    for (int e = 0; e < kPerfEvents; ++e) {
+      if (cell[3 + e].empty()) continue;
+      c.v[e] = std::strtoull(cell[3 + e].c_str(), nullptr, 10);
+      c.valid |= 1u << e;
+    }
+    s.counters.push_back(std::move(c));
+  }
+  return true;
+}
+
+Session merge(const std::vector<Session>& in) {
+  Session out;
+  if (in.empty()) return out;
+  std::vector<const Session*> order;
+  for (const auto& s : in) order.push_back(&s);
+  // Oldest process first; telemetry time 0 is each process's start
+  auto origin = [](const Session* s) { return (int64_t)s->created_unix_us - s->clock_us; };
+  std::stable_sort(order.begin(), order.end(), [&](auto* a, auto* b) { return origin(a) < origin(b); });
+  const int64_t t0 = origin(order.front());
+
+  out.created_unix_us = order.back()->created_unix_us;
+  out.clock_us = (int64_t)out.created_unix_us - t0;
+  out.info = order.front()->info;
+  out.complete = true;
+  std::string plugins;
+  std::map<std::string, std::size_t> by_key;
+  for (const Session* s : order) {
+    if (!s->info.plugin.empty() && ("+" + plugins + "+").find("+" + s->info.plugin + "+") == std::string::npos)
+      plugins += (plugins.empty() ? "" : "+") + s->info.plugin;
+    out.frame_ms.insert(out.frame_ms.end(), s->frame_ms.begin(), s->frame_ms.end());
+    out.complete &= s->complete;
+    out.bad_sections += s->bad_sections;
+    const int64_t shift = origin(s) - t0;
+    for (const auto& ser : s->series) {
+      auto [it, fresh] = by_key.emplace(ser.key, out.series.size());
+      if (fresh) { out.series.emplace_back(); out.series.back().key = ser.key; }
+      Series& d = out.series[it->second];
+      for (std::size_t i = 0; i < ser.t_us.size(); ++i) { d.t_us.push_back(ser.t_us[i] + shift); d.value.push_back(ser.value[i]); }
+      for (auto b : ser.r1)  { b.t_us += shift; d.r1.push_back(b); }
+      for (auto b : ser.r10) { b.t_us += shift; d.r10.push_back(b); }
+    }
+    for (const CallCounters& r : s->counters) {
+      auto it = std::find_if(out.counters.begin(), out.counters.end(),
+                             [&](const CallCounters& o) { return o.plugin == r.plugin && o.phase == r.phase; });
+      if (it == out.counters.end()) { out.counters.push_back(r); continue; }
+      it->valid = it->calls ? (r.calls ? it->valid & r.valid : it->valid) : r.valid;
+      for (int e = 0; e < kPerfEvents; ++e) it->v[e] += r.v[e];
+      it->calls += r.calls;
+    }
+  }
+  out.info.plugin = plugins;
+
+  // Overlapping processes interleave: keep each key in time order
+  for (auto& d : out.series) {
+    std::vector<std::size_t> idx(d.t_us.size());
+    for (std::size_t i = 0; i < idx.size(); ++i) idx[i] = i;
+    std::stable_sort(idx.begin(), idx.end(), [&](auto a, auto b) { return d.t_us[a] < d.t_us[b]; });
+    std::vector<int64_t> t(idx.size());
+    std::vector<double> v(idx.size());
+    for (std::size_t i = 0; i < idx.size(); ++i) { t[i] = d.t_us[idx[i]]; v[i] = d.value[idx[i]]; }
+    d.t_us.swap(t); d.value.swap(v);
+    auto by_t = [](const RollupBucket& a, const RollupBucket& b) { return a.t_us < b.t_us; };
+    std::stable_sort(d.r1.begin(), d.r1.end(), by_t);
+    std::stable_sort(d.r10.begin(), d.r10.end(), by_t);
+  }
+
+  FrameSummary& sum = out.summary;
+  sum.total_frames = (int)out.frame_ms.size();
+  if (!out.frame_ms.empty()) {
+    LogHistogram h;
+    double total = 0.0, mx = 0.0;
+    const double budget = out.info.target_fps > 0 ? 1000.0 / out.info.target_fps : 16.6;
+    int over = 0;
+    for (double ms : out.frame_ms) {
+      h.record(ms <= 0.0 ? 0 : (uint64_t)(ms * 1e6 + 0.5));
+      total += ms; mx = std::max(mx, ms);
+      over += ms > budget;
+    }
+    static constexpr double kPcts[5] = { 50.0, 90.0, 95.0, 99.0, 99.9 };
+    uint64_t v[5];
+    h.percentiles(kPcts, 5, v);
+    sum.avg_ms = total / (double)out.frame_ms.size();
+    sum.p50_ms = v[0] / 1e6; sum.p90_ms = v[1] / 1e6; sum.p95_ms = v[2] / 1e6;
+    sum.p99_ms = v[3] / 1e6; sum.p999_ms = v[4] / 1e6; sum.max_ms = mx;
+    sum.dropped_pct = 100.0 * over / (double)out.frame_ms.size();
+  }
+  double pace_w = 0.0;
+  for (const Session* s : order) {
+    const double w = (double)s->summary.total_frames;
+    sum.pace_avg_ms += s->summary.pace_avg_ms * w;
+    pace_w += w;
+    sum.pace_p99_ms = std::max(sum.pace_p99_ms, s->summary.pace_p99_ms);
+    for (const auto& g : kLatGroups) {
+      const LatencyStats& a = s->summary.*g.m;
+      LatencyStats& o = sum.*g.m;
+      o.p50_ms += a.p50_ms * a.samples;
+      o.p95_ms = std::max(o.p95_ms, a.p95_ms);
+      o.p99_ms = std::max(o.p99_ms, a.p99_ms);
+      o.max_ms = std::max(o.max_ms, a.max_ms);
+      o.samples += a.samples;
+    }
+    // Sessions are separate processes: peaks are the worst one, counts add up
+    for (const auto& g : kProcGroups) {
+      const ProcSummary& a = s->summary.*g.m;
+      ProcSummary& o = sum.*g.m;
+      o.cpu_avg_pct += a.cpu_avg_pct * a.seconds;
+      o.cpu_max_pct = std::max(o.cpu_max_pct, a.cpu_max_pct);
+      o.rss_peak_mb = std::max(o.rss_peak_mb, a.rss_peak_mb);
+      o.pss_peak_mb = std::max(o.pss_peak_mb, a.pss_peak_mb);
+      o.minflt += a.minflt; o.majflt += a.majflt;
+      o.vcsw += a.vcsw; o.ivcsw += a.ivcsw;
+      o.seconds += a.seconds;
+    }
+  }
+  if (pace_w > 0) sum.pace_avg_ms /= pace_w;
+  for (const auto& g : kLatGroups) {
+    LatencyStats& o = sum.*g.m;
+    if (o.samples) o.p50_ms /= o.samples;
+  }
+  for (const auto& g : kProcGroups) {
+    ProcSummary& o = sum.*g.m;
+    if (o.seconds > 0) o.cpu_avg_pct /= o.seconds;
+  }
+  return out;
+}
+
+bool set_summary_field(Session& s, std::string_view name, double v) { return set_number(s.info, s.summary, name, v); }
+bool set_info_field(Session& s, std::string_view name, std::string_view v) { return set_text(s.info, name, std::string(v)); }
+
+} // namespace session_file
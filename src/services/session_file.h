@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "artifacts.h"
+#include "telemetry_store.h"
+
+// Binary session artifact (.gpisession): what save_artifacts_now used to
+// spread over four text files, in one file a tenth of the size.
+//
+//   header   "GPISESS" + format version byte,
+//            u64 wall clock (unix us) and i64 telemetry clock (us) at open
+//   section* u32 tag, u32 payload bytes, payload, u32 CRC-32 of the payload
+//   "END "   empty section; a file without it was cut short
+//
+// Fixed-width integers are little-endian; counts, lengths and deltas are
+// LEB128 varints, signed ones zigzagged. Frame times are nanosecond deltas;
+// telemetry timestamps are delta-of-deltas and values are XOR'd against the
+// previous one with zero bytes dropped (the TelemetryStore chunk scheme).
+// Sections go to disk one by one as they are produced; a reader keeps every
+// intact section before a torn tail and skips ones whose checksum fails.
+namespace session_file {
+
+constexpr uint8_t kVersion = 1;
+constexpr uint32_t tag(const char (&s)[5]) {
+  return (uint32_t)(uint8_t)s[0] | (uint32_t)(uint8_t)s[1] << 8 | (uint32_t)(uint8_t)s[2] << 16 |
+         (uint32_t)(uint8_t)s[3] << 24;
+}
+constexpr uint32_t kInfo    = tag("INFO");   // SessionInfo strings
+constexpr uint32_t kSummary = tag("SUMM");   // FrameSummary numbers + target_fps
+constexpr uint32_t kFrames  = tag("FRAM");   // frame times
+constexpr uint32_t kSeries  = tag("TSER");   // one telemetry key: raw points + rollups
+constexpr uint32_t kCounters = tag("PCTR");  // per-plugin hardware counter totals
+constexpr uint32_t kEnd     = tag("END ");
+
+struct Series {
+  std::string key;
+  std::vector<int64_t> t_us;
+  std::vector<double> value;
+  std::vector<RollupBucket> r1, r10;
+};
+
+struct Session {
+  uint64_t created_unix_us = 0;   // wall clock when the file was opened
+  int64_t  clock_us = 0;          // telemetry clock at the same moment
+  SessionInfo info;
+  FrameSummary summary;
+  std::vector<double> frame_ms;
+  std::vector<Series> series;
+  std::vector<CallCounters> counters;
+  bool complete = false;          // END section seen
+  int  bad_sections = 0;          // failed checksum or decode, skipped
+};
+
+// Encodes one TSER payload incrementally, so a series can be written
+// straight out of the TelemetryStore without copying it first.
+class SeriesEncoder {
+public:
+  explicit SeriesEncoder(std::string_view key);
+  void point(int64_t t_us, double v);
+  void rollup(int width_s, const RollupBucket& b);   // width 1 or 10
+  // Assembles and returns the payload; the encoder is spent afterwards
+  std::vector<uint8_t> finish();
+
+private:
+  struct Tier { std::vector<uint8_t> buf; uint32_t n = 0; int64_t t = 0; uint64_t mn = 0, mx = 0, sum = 0; };
+  std::string key_;
+  std::vector<uint8_t> pts_;
+  uint32_t npts_ = 0;
+  int64_t t_last_ = 0, d_last_ = 0;
+  uint64_t v_last_ = 0;
+  Tier r1_, r10_;
+};
+
+// Streams sections to disk as they are added.
+class Writer {
+public:
+  Writer() = default;
+  ~Writer();   // closes without END if finish() was not reached
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  bool open(const std::string& path, uint64_t created_unix_us, int64_t clock_us);
+  void info(const SessionInfo& info);                            // strings
+  void summary(const SessionInfo& info, const FrameSummary& sum);  // numbers, target_fps included
+  void frames(const std::vector<double>& frame_ms);
+  void counters(const std::vector<CallCounters>& c);   // nothing when empty
+  void series(SeriesEncoder& enc);
+  void series(const Series& s);
+  void section(uint32_t tag, const uint8_t* p, std::size_t n);
+  // Writes END and closes; bytes written, or -1 if anything failed
+  int64_t finish();
+
+private:
+  std::FILE* f_ = nullptr;
+  int64_t bytes_ = 0;
+  bool ok_ = false;
+};
+
+// Whole-session helpers
+int64_t write(const std::string& path, const Session& s);
+bool read(const std::string& path, Session& out, std::string* err = nullptr);
+
+// Fields by their -summary.json names ("p99_ms", "input_latency.p50_ms");
+// false for names this version does not know
+bool set_summary_field(Session& s, std::string_view name, double v);
+bool set_info_field(Session& s, std::string_view name, std::string_view v);
+
+// The text artifacts the host used to write: BASE-frames.csv, -summary.json,
+// -telemetry.csv, -telemetry.json, -telemetry-rollups.csv, and -counters.csv
+// when there are counters. Bytes, or -1.
+int64_t export_text(const Session& s, const std::string& base);
+// The reverse, for sessions saved before the binary format: BASE-frames.csv
+// is required, the other files are read when present. False if the frames
+// cannot be opened.
+bool import_text(const std::string& base, Session& out, std::string* err = nullptr);
+
+// Sessions on one timeline: telemetry is rebased to the earliest process
+// start, frames are concatenated oldest session first and the summary is
+// recomputed from the merged frames (latency percentiles are combined
+// conservatively: p50 sample-weighted, p95 and up the worst of the inputs).
+// Counter totals of the same plugin and phase add up.
+Session merge(const std::vector<Session>& in);
+
+} // namespace session_file
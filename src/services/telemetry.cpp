@@ -1,36 +1,261 @@
 #include "telemetry.h"
-#include <fstream>
-
-void Telemetry::mark(const std::string& key, double value) {
-  auto now = std::chrono::steady_clock::now();
-  double t = std::chrono::duration<double>(now - t0_).count();
-  std::lock_guard<std::mutex> lk(m_);
-  series_[key].push_back({t, value});
-}
-
-void Telemetry::flush_csv(const std::string& path) {
-  std::lock_guard<std::mutex> lk(m_);
-  std::ofstream f(path, std::ios::trunc);
-  if (!f) return;
-  f << "key,time,value\n";
-  for (auto& [k, vec] : series_)
-    for (auto& [t, v] : vec) f << k << "," << t << "," << v << "\n";
-}
-
-void Telemetry::flush_json(const std::string& path) {
-  std::lock_guard<std::mutex> lk(m_);
-  std::ofstream f(path, std::ios::trunc);
-  if (!f) return;
-  f << "{\n";
-  bool firstk = true;
-  for (auto& [k, vec] : series_) {
-    if (!firstk) f << ",\n"; firstk = false;
-    f << "  \"" << k << "\": [";
-    for (size_t i=0;i<vec.size();++i) {
-      auto [t,v]=vec[i];
-      f << (i? ", ":" ") << "[" << t << "," << v << "]";
+#include "artifact_writer.h"
+#include "zones.h"
+#include <cstring>
+
+namespace {
+std::atomic<uint64_t> g_next_instance{1};
+}
+
+// Per-thread producer state. The ring is shared with the registry so it
+// outlives the thread until the aggregator has drained it.
+struct TelemetryTls {
+  static constexpr int kCache = 64;
+  struct Entry { const char* key = nullptr; const char* name = nullptr; uint32_t id = 0; };
+  uint64_t owner = 0;
+  std::shared_ptr<Telemetry::Ring> ring;
+  Entry cache[kCache];
+  ~TelemetryTls() { if (ring) ring->orphaned.store(true, std::memory_order_release); }
+};
+static thread_local TelemetryTls tls;
+
+Telemetry::Telemetry() : instance_(g_next_instance.fetch_add(1)) {
+  worker_ = std::thread([this]{ run(); });
+}
+
+Telemetry::~Telemetry() {
+  { std::lock_guard<std::mutex> lk(wake_m_); stop_ = true; }
+  wake_.notify_all();
+  if (worker_.joinable()) worker_.join();
+}
+
+uint32_t Telemetry::intern(std::string_view key) {
+  std::lock_guard<std::mutex> lk(keys_m_);
+  auto it = ids_.find(std::string(key));
+  if (it != ids_.end()) return it->second;
+  const uint32_t id = (uint32_t)names_.size();
+  names_.emplace_back(key);
+  ids_.emplace(names_.back(), id);
+  return id;
+}
+
+Telemetry::Ring* Telemetry::local_ring() {
+  if (tls.owner != instance_) {
+    if (tls.ring) tls.ring->orphaned.store(true, std::memory_order_release);
+    tls = TelemetryTls{};
+    tls.ring = std::make_shared<Ring>();
+    tls.owner = instance_;
+    std::lock_guard<std::mutex> lk(rings_m_);
+    rings_.push_back(tls.ring);
+  }
+  return tls.ring.get();
+}
+
+void Telemetry::mark(uint32_t id, double value) {
+  Ring* r = local_ring();
+  const uint32_t h = r->head.load(std::memory_order_relaxed);
+  if (h - r->tail.load(std::memory_order_acquire) >= Ring::kCap) {
+    r->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const int64_t t = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - t0_).count();
+  r->rec[h % Ring::kCap] = Record{ t, value, id };
+  r->head.store(h + 1, std::memory_order_release);
+}
+
+void Telemetry::mark(const char* key, double value) {
+  if (!key) key = "(null)";
+  local_ring();   // binds tls (and its cache) to this instance
+  auto& e = tls.cache[((uintptr_t)key >> 3) % TelemetryTls::kCache];
+  // The pointer alone is not enough: callers may reuse a buffer for new keys
+  if (e.key != key || std::strcmp(e.name, key) != 0) {
+    const uint32_t id = intern(key);
+    std::lock_guard<std::mutex> lk(keys_m_);
+    e = TelemetryTls::Entry{ key, names_[id].c_str(), id };
+  }
+  mark(e.id, value);
+}
+
+void Telemetry::drain() {
+  std::vector<std::shared_ptr<Ring>> rings;
+  { std::lock_guard<std::mutex> lk(rings_m_); rings = rings_; }
+  bool any_retired = false;
+  for (auto& r : rings) {
+    // orphaned is read before head so a retired ring's last marks are seen
+    const bool orphaned = r->orphaned.load(std::memory_order_acquire);
+    const uint32_t h = r->head.load(std::memory_order_acquire);
+    uint32_t t = r->tail.load(std::memory_order_relaxed);
+    for (; t != h; ++t) {
+      const Record& rec = r->rec[t % Ring::kCap];
+      store_.append(rec.id, rec.t_ns / 1000, rec.value);
+      if (!streaming_) continue;
+      if (backlog_.size() < kMaxBacklog) backlog_.push_back(rec);
+      else backlog_lost_.fetch_add(1, std::memory_order_relaxed);
+    }
+    r->tail.store(t, std::memory_order_release);
+    any_retired |= orphaned;
+  }
+  store_.maintain(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - t0_).count());
+  usage_bytes_.store(store_.bytes(), std::memory_order_relaxed);
+  usage_max_.store(store_.max_bytes(), std::memory_order_relaxed);
+  usage_keys_.store(store_.series_count(), std::memory_order_relaxed);
+  usage_points_.store(store_.raw_points(), std::memory_order_relaxed);
+
+  if (!any_retired) return;
+  std::lock_guard<std::mutex> lk(rings_m_);
+  for (size_t i = 0; i < rings_.size();) {
+    auto& r = rings_[i];
+    if (r->orphaned.load(std::memory_order_acquire) &&
+        r->tail.load(std::memory_order_relaxed) == r->head.load(std::memory_order_acquire)) {
+      dropped_retired_ += r->dropped.load(std::memory_order_relaxed);
+      rings_[i] = rings_.back();
+      rings_.pop_back();
+    } else {
+      ++i;
+    }
+  }
+}
+
+void Telemetry::run() {
+  std::unique_lock<std::mutex> lk(wake_m_);
+  while (!stop_) {
+    wake_.wait_for(lk, std::chrono::milliseconds(5));
+    lk.unlock();
+    { std::lock_guard<std::mutex> alk(agg_m_); drain(); }
+    lk.lock();
+  }
+}
+
+uint64_t Telemetry::dropped() const {
+  std::lock_guard<std::mutex> lk(rings_m_);
+  uint64_t n = dropped_retired_;
+  for (auto& r : rings_) n += r->dropped.load(std::memory_order_relaxed);
+  return n;
+}
+
+void Telemetry::configure(std::size_t max_bytes, double raw_seconds) {
+  std::lock_guard<std::mutex> lk(agg_m_);
+  store_.configure(max_bytes, raw_seconds);
+  usage_max_.store(store_.max_bytes(), std::memory_order_relaxed);
+}
+
+Telemetry::Usage Telemetry::usage() const {
+  Usage u{};
+  u.bytes = usage_bytes_.load(std::memory_order_relaxed);
+  u.max_bytes = usage_max_.load(std::memory_order_relaxed);
+  u.keys = usage_keys_.load(std::memory_order_relaxed);
+  u.raw_points = usage_points_.load(std::memory_order_relaxed);
+  u.dropped = dropped();
+  u.stream_lost = backlog_lost_.load(std::memory_order_relaxed);
+  return u;
+}
+
+void Telemetry::sync_names() {
+  std::lock_guard<std::mutex> lk(keys_m_);
+  for (std::size_t i = export_names_.size(); i < names_.size(); ++i) export_names_.push_back(names_[i]);
+}
+
+static void csv_row(TextBuf& b, const std::string& key, int64_t t_us, double v) {
+  b.str(key).ch(',').num(t_us / 1e6).ch(',').num(v).ch('\n');
+}
+
+static int64_t write_buf(const std::string& path, const TextBuf& b, bool append) {
+  return artifacts::write_text(path, b.view(), append) ? (int64_t)b.size() : -1;
+}
+
+int64_t Telemetry::flush_csv(const std::string& path) {
+  GPI_ZONE("Telemetry::flush_csv");
+  std::lock_guard<std::mutex> elk(export_m_);
+  TextBuf b(1u << 20);
+  b.str("key,time,value\n");
+  {
+    std::lock_guard<std::mutex> lk(agg_m_);
+    drain();
+    sync_names();
+    for (uint32_t id = 0; id < (uint32_t)store_.series_count(); ++id)
+      store_.for_each_raw(id, [&](int64_t t, double v) { csv_row(b, export_names_[id], t, v); });
+  }
+  return write_buf(path, b, false);
+}
+
+int64_t Telemetry::append_csv(const std::string& path) {
+  GPI_ZONE("Telemetry::append_csv");
+  std::lock_guard<std::mutex> elk(export_m_);
+  const bool fresh = path != stream_path_;
+  TextBuf b(fresh ? (1u << 20) : 64 * 1024);
+  spare_.clear();
+  {
+    std::lock_guard<std::mutex> lk(agg_m_);
+    drain();
+    sync_names();
+    if (fresh) {
+      // Everything held so far; the backlog restarts from here
+      b.str("key,time,value\n");
+      for (uint32_t id = 0; id < (uint32_t)store_.series_count(); ++id)
+        store_.for_each_raw(id, [&](int64_t t, double v) { csv_row(b, export_names_[id], t, v); });
+      backlog_.clear();
+      streaming_ = true;
+    } else {
+      spare_.swap(backlog_);
+    }
+  }
+  for (const Record& r : spare_) csv_row(b, export_names_[r.id], r.t_ns / 1000, r.value);
+  stream_path_ = path;
+  if (b.empty()) return 0;
+  const int64_t n = write_buf(path, b, !fresh);
+  if (n < 0) stream_path_.clear();   // start over with a full write next time
+  return n;
+}
+
+int64_t Telemetry::flush_rollups_csv(const std::string& path) {
+  GPI_ZONE("Telemetry::flush_rollups_csv");
+  std::lock_guard<std::mutex> elk(export_m_);
+  TextBuf b(256 * 1024);
+  b.str("key,width_s,time,min,max,avg,count\n");
+  auto tier = [&](uint32_t id, const std::deque<RollupBucket>* rb, int width) {
+    if (!rb) return;
+    for (const auto& r : *rb)
+      b.str(export_names_[id]).ch(',').num(width).ch(',').num(r.t_us / 1e6).ch(',').num(r.min).ch(',')
+       .num(r.max).ch(',').num(r.count ? r.sum / r.count : 0.0).ch(',').num(r.count).ch('\n');
+  };
+  {
+    std::lock_guard<std::mutex> lk(agg_m_);
+    drain();
+    sync_names();
+    for (uint32_t id = 0; id < (uint32_t)store_.series_count(); ++id) {
+      tier(id, store_.rollup_10s(id), 10);
+      tier(id, store_.rollup_1s(id), 1);
+    }
+  }
+  return write_buf(path, b, false);
+}
+
+int64_t Telemetry::flush_json(const std::string& path) {
+  GPI_ZONE("Telemetry::flush_json");
+  std::lock_guard<std::mutex> elk(export_m_);
+  TextBuf b(1u << 20);
+  b.str("{\n");
+  {
+    std::lock_guard<std::mutex> lk(agg_m_);
+    drain();
+    sync_names();
+    bool firstk = true;
+    for (uint32_t id = 0; id < (uint32_t)store_.series_count(); ++id) {
+      bool first = true;
+      store_.for_each_raw(id, [&](int64_t t, double v) {
+        if (first) {
+          if (!firstk) b.str(",\n");
+          firstk = false;
+          b.str("  \"").esc(export_names_[id]).str("\": [");
+        }
+        b.str(first ? " [" : ", [").num(t / 1e6).ch(',').num(v).ch(']');
+        first = false;
+      });
+      if (!first) b.str(" ]");
     }
-    f << " ]";
   }
-  f << "\n}\n";
+  b.str("\n}\n");
+  return write_buf(path, b, false);
 }
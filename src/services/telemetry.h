@@ -1,17 +1,125 @@
 #pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <unordered_map>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <chrono>
+#include "telemetry_store.h"
 
+// Telemetry marks from any thread. Keys are interned to small ids once
+// (mutex, first sight only). A mark appends {time, value, id} to the calling
+// thread's own SPSC ring: no lock, no allocation after the thread's first
+// mark, and nothing shared with other producers. A background thread drains
+// the rings every few ms into a memory-capped TelemetryStore; flushes drain
+// first. A full ring drops the mark and counts it rather than block the caller.
+// Exports format into a TextBuf while holding the aggregator (never a
+// producer) and write the file after releasing it; they are meant to run on
+// the ArtifactWriter thread.
 class Telemetry {
 public:
-  void mark(const std::string& key, double value);
-  void flush_csv(const std::string& path);
-  void flush_json(const std::string& path);
+  struct Usage {
+    std::size_t bytes = 0, max_bytes = 0;
+    std::size_t keys = 0;
+    uint64_t raw_points = 0;
+    uint64_t dropped = 0;
+    uint64_t stream_lost = 0;   // points append_csv() never saw (backlog cap)
+  };
+
+  Telemetry();
+  ~Telemetry();
+  Telemetry(const Telemetry&) = delete;
+  Telemetry& operator=(const Telemetry&) = delete;
+
+  uint32_t intern(std::string_view key);
+  void mark(uint32_t id, double value);
+  // Resolves the key through a per-thread pointer cache, so repeated marks
+  // with the same (literal) key skip the intern table.
+  void mark(const char* key, double value);
+
+  // Memory cap for stored points and rollups; raw points older than
+  // raw_seconds are folded into 1 s buckets
+  void configure(std::size_t max_bytes, double raw_seconds);
+
+  // Raw points still held (rolled-up data goes to flush_rollups_csv).
+  // Each returns the bytes written, or -1 on failure.
+  int64_t flush_csv(const std::string& path);
+  int64_t flush_json(const std::string& path);
+  int64_t flush_rollups_csv(const std::string& path);
+  // Append-only CSV: the first call for a path writes every raw point held,
+  // later calls append only what was drained since. From then on the
+  // aggregator keeps new points aside (up to kMaxBacklog) until the next call.
+  int64_t append_csv(const std::string& path);
+  // f(key, id, store) for every key after a drain, holding the aggregator:
+  // encode or copy only, write files afterwards
+  template <class F> void visit_series(F&& f) {
+    std::lock_guard<std::mutex> elk(export_m_);
+    std::lock_guard<std::mutex> lk(agg_m_);
+    drain();
+    sync_names();
+    for (uint32_t id = 0; id < (uint32_t)store_.series_count(); ++id)
+      f(export_names_[id], id, static_cast<const TelemetryStore&>(store_));
+  }
+  // The clock marks are stamped with: microseconds since construction
+  int64_t clock_us() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0_).count();
+  }
+  uint64_t dropped() const;
+  Usage usage() const;   // sizes as of the last drain; cheap enough per frame
+
 private:
-  std::mutex m_;
-  std::unordered_map<std::string, std::vector<std::pair<double,double>>> series_;
-  std::chrono::steady_clock::time_point t0_ = std::chrono::steady_clock::now();
+  struct Record { int64_t t_ns; double value; uint32_t id; };
+  struct Ring {
+    static constexpr uint32_t kCap = 4096;
+    Record rec[kCap];
+    alignas(64) std::atomic<uint32_t> head{0};   // producer
+    alignas(64) std::atomic<uint32_t> tail{0};   // aggregator
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> orphaned{false};           // producer thread exited
+  };
+  friend struct TelemetryTls;
+
+  static constexpr std::size_t kMaxBacklog = 1u << 20;
+
+  Ring* local_ring();
+  void drain();     // caller holds agg_m_
+  void sync_names();   // caller holds export_m_
+  void run();
+
+  const uint64_t instance_;
+  const std::chrono::steady_clock::time_point t0_ = std::chrono::steady_clock::now();
+
+  std::mutex keys_m_;
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::deque<std::string> names_;   // deque: interned strings never move
+
+  mutable std::mutex rings_m_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  uint64_t dropped_retired_ = 0;    // from rings already removed (under rings_m_)
+
+  std::mutex agg_m_;
+  TelemetryStore store_;
+  std::atomic<std::size_t> usage_bytes_{0}, usage_max_{0}, usage_keys_{0};
+  std::atomic<uint64_t> usage_points_{0};
+  bool streaming_ = false;          // append_csv() has started (under agg_m_)
+  std::vector<Record> backlog_;     // drained since the last append_csv() (under agg_m_)
+  std::atomic<uint64_t> backlog_lost_{0};
+
+  // Exports run one at a time and read key names from their own copy, so
+  // formatting never holds keys_m_ against a producer's first mark.
+  std::mutex export_m_;
+  std::vector<std::string> export_names_;
+  std::vector<Record> spare_;       // swapped with backlog_, keeps its capacity
+  std::string stream_path_;
+
+  std::mutex wake_m_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+  std::thread worker_;
 };
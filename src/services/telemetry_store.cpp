@@ -0,0 +1,121 @@
+#include "telemetry_store.h"
+#include <algorithm>
+#include <limits>
+
+static int put_varint(uint8_t* p, int64_t v) {
+  uint64_t u = ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);   // zigzag
+  int n = 0;
+  while (u >= 0x80) { p[n++] = (uint8_t)(u | 0x80); u >>= 7; }
+  p[n++] = (uint8_t)u;
+  return n;
+}
+
+void TelemetryStore::configure(std::size_t max_bytes, double raw_seconds) {
+  max_bytes_ = std::max<std::size_t>(max_bytes, 4 * sizeof(Chunk));
+  raw_window_us_ = (int64_t)(std::max(raw_seconds, 1.0) * 1e6);
+}
+
+// Appends one point; false when it does not fit (the chunk is then sealed).
+bool TelemetryStore::encode(Chunk& c, int64_t t_us, double value) {
+  uint8_t tmp[10 + 1 + 8];
+  int n = 0;
+  int64_t delta = 0;
+  if (c.count > 0) {
+    delta = t_us - c.t_last;
+    n += put_varint(tmp, delta - c.prev_delta);
+  }
+  const uint64_t bits = std::bit_cast<uint64_t>(value);
+  const uint64_t x = c.count > 0 ? bits ^ c.prev_bits : bits;
+  if (x == 0) {
+    tmp[n++] = 0;
+  } else {
+    const int lz = std::countl_zero(x) / 8, tz = std::countr_zero(x) / 8;
+    const int len = 8 - lz - tz;
+    tmp[n++] = (uint8_t)(lz << 4 | len);
+    for (int k = 0; k < len; ++k) tmp[n++] = (uint8_t)(x >> (8 * (tz + k)));
+  }
+  if (c.used + n > kChunkBytes) return false;
+  std::copy(tmp, tmp + n, c.data + c.used);
+  c.used += n;
+  if (c.count == 0) c.t_first = t_us;
+  c.t_last = t_us;
+  c.prev_delta = delta;
+  c.prev_bits = bits;
+  ++c.count;
+  return true;
+}
+
+void TelemetryStore::append(uint32_t id, int64_t t_us, double value) {
+  if (id >= series_.size()) series_.resize(id + 1);
+  Series& s = series_[id];
+  if (s.chunks.empty() || !encode(*s.chunks.back(), t_us, value)) {
+    s.chunks.push_back(std::make_unique<Chunk>());
+    bytes_ += sizeof(Chunk);
+    encode(*s.chunks.back(), t_us, value);
+  }
+  ++raw_points_;
+}
+
+void TelemetryStore::add_to(std::deque<RollupBucket>& tier, int64_t t_us, int64_t width_us,
+                            double mn, double mx, double sum, uint32_t n) {
+  const int64_t start = t_us - ((t_us % width_us) + width_us) % width_us;
+  // Points arrive nearly in order (per-thread rings drain one after another)
+  for (auto it = tier.rbegin(); it != tier.rend() && it - tier.rbegin() < 4; ++it) {
+    if (it->t_us == start) {
+      it->min = std::min(it->min, mn); it->max = std::max(it->max, mx);
+      it->sum += sum; it->count += n;
+      return;
+    }
+    if (it->t_us < start) break;
+  }
+  if (!tier.empty() && start < tier.back().t_us) {
+    // Far out of order: charge it to the newest bucket rather than reorder
+    auto& b = tier.back();
+    b.min = std::min(b.min, mn); b.max = std::max(b.max, mx); b.sum += sum; b.count += n;
+    return;
+  }
+  tier.push_back(RollupBucket{ start, mn, mx, sum, n });
+}
+
+void TelemetryStore::roll_chunk(Series& s) {
+  const Chunk& c = *s.chunks.front();
+  const std::size_t before = s.r1.size();
+  decode(c, [&](int64_t t, double v) { add_to(s.r1, t, 1000000, v, v, v, 1); });
+  bytes_ += (s.r1.size() - before) * sizeof(RollupBucket);
+  bytes_ -= sizeof(Chunk);
+  raw_points_ -= c.count;
+  s.chunks.pop_front();
+}
+
+void TelemetryStore::fold_1s(Series& s) {
+  const RollupBucket b = s.r1.front();
+  s.r1.pop_front();
+  const std::size_t before = s.r10.size();
+  add_to(s.r10, b.t_us, 10000000, b.min, b.max, b.sum, b.count);
+  bytes_ += (s.r10.size() - before) * sizeof(RollupBucket);
+  bytes_ -= sizeof(RollupBucket);
+}
+
+void TelemetryStore::maintain(int64_t now_us) {
+  // Age: sealed chunks past the raw window, 1 s buckets past ten minutes
+  for (auto& s : series_) {
+    while (s.chunks.size() > 1 && s.chunks.front()->t_last < now_us - raw_window_us_) roll_chunk(s);
+    while (!s.r1.empty() && s.r1.front().t_us < now_us - kRollup1sKeepUs) fold_1s(s);
+  }
+  // Memory cap: oldest raw chunk anywhere, then oldest 1 s, then oldest 10 s
+  while (bytes_ > max_bytes_) {
+    Series* oldest = nullptr;
+    int64_t t = std::numeric_limits<int64_t>::max();
+    for (auto& s : series_)
+      if (!s.chunks.empty() && s.chunks.front()->t_first < t) { t = s.chunks.front()->t_first; oldest = &s; }
+    if (oldest) { roll_chunk(*oldest); continue; }
+    for (auto& s : series_)
+      if (!s.r1.empty() && s.r1.front().t_us < t) { t = s.r1.front().t_us; oldest = &s; }
+    if (oldest) { fold_1s(*oldest); continue; }
+    for (auto& s : series_)
+      if (!s.r10.empty() && s.r10.front().t_us < t) { t = s.r10.front().t_us; oldest = &s; }
+    if (!oldest) break;
+    oldest->r10.pop_front();
+    bytes_ -= sizeof(RollupBucket);
+  }
+}
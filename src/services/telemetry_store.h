@@ -0,0 +1,100 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Aggregated [t, t + width) of one key
+struct RollupBucket {
+  int64_t t_us;
+  double  min, max, sum;
+  uint32_t count;
+};
+
+// Bounded per-key storage behind Telemetry. Recent points live in
+// fixed-size columnar chunks: timestamps as zigzag varint delta-of-deltas
+// (a steady cadence costs one byte), values XOR'd against the previous
+// one and stored without their zero bytes (repeats cost one byte).
+// Chunks older than the raw window, or the oldest ones once the memory cap
+// is hit, are folded into 1 s min/max/avg/count buckets; 1 s buckets past
+// ten minutes fold into 10 s buckets. Under pressure the oldest rollups go
+// last. Single-threaded: Telemetry's aggregator owns it.
+class TelemetryStore {
+public:
+  static constexpr std::size_t kChunkBytes = 4096;
+  static constexpr int64_t kRollup1sKeepUs = 600ll * 1000000;
+
+  void configure(std::size_t max_bytes, double raw_seconds);
+  void append(uint32_t id, int64_t t_us, double value);
+  // Age-based rollups and the memory cap; cheap when nothing is due
+  void maintain(int64_t now_us);
+
+  std::size_t bytes() const { return bytes_; }
+  std::size_t max_bytes() const { return max_bytes_; }
+  std::size_t series_count() const { return series_.size(); }
+  uint64_t raw_points() const { return raw_points_; }
+
+  // Raw points of `id`, oldest chunk first: f(t_us, value)
+  template <class F> void for_each_raw(uint32_t id, F&& f) const {
+    if (id >= series_.size()) return;
+    for (const auto& c : series_[id].chunks) decode(*c, f);
+  }
+  const std::deque<RollupBucket>* rollup_1s(uint32_t id) const { return id < series_.size() ? &series_[id].r1 : nullptr; }
+  const std::deque<RollupBucket>* rollup_10s(uint32_t id) const { return id < series_.size() ? &series_[id].r10 : nullptr; }
+
+private:
+  struct Chunk {
+    int64_t  t_first = 0, t_last = 0;
+    int64_t  prev_delta = 0;
+    uint64_t prev_bits = 0;
+    uint32_t count = 0, used = 0;
+    uint8_t  data[kChunkBytes];
+  };
+  struct Series {
+    std::deque<std::unique_ptr<Chunk>> chunks;
+    std::deque<RollupBucket> r1, r10;
+  };
+
+  static bool encode(Chunk& c, int64_t t_us, double value);
+  template <class F> static void decode(const Chunk& c, F&& f);
+  static int64_t read_varint(const uint8_t*& p);
+
+  void roll_chunk(Series& s);            // oldest chunk -> 1 s buckets
+  void fold_1s(Series& s);               // oldest 1 s bucket -> 10 s
+  static void add_to(std::deque<RollupBucket>& tier, int64_t t_us, int64_t width_us,
+                     double mn, double mx, double sum, uint32_t n);
+
+  std::deque<Series> series_;   // deque: Series is not nothrow-movable
+  std::size_t max_bytes_ = 16u << 20;
+  int64_t raw_window_us_ = 120ll * 1000000;
+  std::size_t bytes_ = 0;
+  uint64_t raw_points_ = 0;
+};
+
+inline int64_t TelemetryStore::read_varint(const uint8_t*& p) {
+  uint64_t u = 0;
+  for (int shift = 0;; shift += 7) {
+    const uint8_t b = *p++;
+    u |= (uint64_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) break;
+  }
+  return (int64_t)(u >> 1) ^ -(int64_t)(u & 1);   // zigzag
+}
+
+template <class F> void TelemetryStore::decode(const Chunk& c, F&& f) {
+  const uint8_t* p = c.data;
+  int64_t t = c.t_first, delta = 0;
+  uint64_t bits = 0;
+  for (uint32_t i = 0; i < c.count; ++i) {
+    if (i > 0) { delta += read_varint(p); t += delta; }
+    // tag: high nibble = leading zero bytes, low nibble = stored bytes
+    const uint8_t tag = *p++;
+    const int lz = tag >> 4, n = tag & 0x0F;
+    uint64_t x = 0;
+    for (int k = 0; k < n; ++k) x |= (uint64_t)*p++ << (8 * k);
+    if (n) bits ^= x << (8 * (8 - lz - n));
+    f(t, std::bit_cast<double>(bits));
+  }
+}
@@ -0,0 +1,116 @@
+#include "trace.h"
+#include "artifact_writer.h"
+#include <algorithm>
+
+namespace {
+std::atomic<uint64_t> g_next_tracer{1};
+}
+
+// The ring is shared with the registry, so a thread's events stay
+// exportable after the thread exits.
+struct TracerTls {
+  uint64_t owner = 0;
+  std::shared_ptr<Tracer::Ring> ring;
+};
+static thread_local TracerTls trace_tls;
+
+Tracer::Tracer() : instance_(g_next_tracer.fetch_add(1)) {}
+
+Tracer::Ring* Tracer::local_ring() {
+  if (trace_tls.owner != instance_) {
+    auto r = std::make_shared<Ring>();
+    r->ev.resize(kRingEvents);
+    {
+      std::lock_guard<std::mutex> lk(rings_m_);
+      r->tid = (uint32_t)rings_.size() + 1;
+      rings_.push_back(r);
+    }
+    trace_tls.ring = std::move(r);
+    trace_tls.owner = instance_;
+  }
+  return trace_tls.ring.get();
+}
+
+void Tracer::push(const Event& e) {
+  Ring* r = local_ring();
+  std::lock_guard<std::mutex> lk(r->m);
+  r->ev[r->head % kRingEvents] = e;
+  ++r->head;
+}
+
+void Tracer::span(const char* name, const char* cat, int64_t t0_ns, int64_t t1_ns, const char* detail) {
+  push(Event{ name, cat, detail, t0_ns, std::max<int64_t>(t1_ns - t0_ns, 0) });
+}
+
+void Tracer::instant(const char* name, const char* cat, const char* detail) {
+  push(Event{ name, cat, detail, now_ns(), -1 });
+}
+
+void Tracer::name_thread(const char* name) {
+  Ring* r = local_ring();
+  std::lock_guard<std::mutex> lk(r->m);
+  r->name = name;
+}
+
+const char* Tracer::intern(std::string_view s) {
+  std::lock_guard<std::mutex> lk(strings_m_);
+  for (auto it = strings_.rbegin(); it != strings_.rend() && it - strings_.rbegin() < 16; ++it)
+    if (*it == s) return it->c_str();
+  strings_.emplace_back(s);
+  return strings_.back().c_str();
+}
+
+int64_t Tracer::write_chrome_json(const std::string& path, double seconds) {
+  TextBuf b(256 * 1024);
+  chrome_json(b, seconds);
+  return artifacts::write_text(path, b.view()) ? (int64_t)b.size() : -1;
+}
+
+void Tracer::chrome_json(TextBuf& b, double seconds, const JsonExtra& extra) {
+  const int64_t now = now_ns();
+  const int64_t from = now - (int64_t)(seconds * 1e9);
+
+  struct Track { uint32_t tid; const char* name; std::vector<Event> ev; };
+  std::vector<Track> tracks;
+  {
+    std::vector<std::shared_ptr<Ring>> rings;
+    { std::lock_guard<std::mutex> lk(rings_m_); rings = rings_; }
+    for (auto& r : rings) {
+      Track t{ r->tid, nullptr, {} };
+      std::lock_guard<std::mutex> lk(r->m);
+      t.name = r->name;
+      const uint64_t n = std::min<uint64_t>(r->head, kRingEvents);
+      t.ev.reserve((std::size_t)n);
+      for (uint64_t i = r->head - n; i != r->head; ++i) {
+        const Event& e = r->ev[i % kRingEvents];
+        if (e.t_ns + std::max<int64_t>(e.dur_ns, 0) >= from) t.ev.push_back(e);
+      }
+      tracks.push_back(std::move(t));
+    }
+  }
+
+  // Timestamps are microseconds from the earliest exported event
+  int64_t origin = now;
+  for (const auto& t : tracks)
+    for (const Event& e : t.ev) origin = std::min(origin, e.t_ns);
+  b.str("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool first = true;
+  auto sep = [&] { if (!first) b.str(",\n"); first = false; };
+  for (const auto& t : tracks) {
+    sep();
+    b.str("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":").num(t.tid)
+     .str(",\"args\":{\"name\":\"").esc(t.name ? t.name : "thread").str("\"}}");
+    for (const Event& e : t.ev) {
+      sep();
+      b.str("{\"name\":\"").esc(e.name).str("\",\"cat\":\"").esc(e.cat ? e.cat : "host")
+       .str("\",\"pid\":1,\"tid\":").num(t.tid).str(",\"ts\":").num((double)(e.t_ns - origin) / 1000.0);
+      if (e.dur_ns >= 0) b.str(",\"ph\":\"X\",\"dur\":").num((double)e.dur_ns / 1000.0);
+      else b.str(",\"ph\":\"i\",\"s\":\"t\"");
+      if (e.detail) b.str(",\"args\":{\"detail\":\"").esc(e.detail).str("\"}");
+      b.ch('}');
+    }
+  }
+  b.str("\n]");
+  if (extra) extra(b, origin);
+  b.str("}\n");
+}
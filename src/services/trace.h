@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "zones.h"
+
+class TextBuf;
+
+// Rolling timeline of named spans and instant events for Chrome Trace Event
+// export (chrome://tracing, ui.perfetto.dev). Every thread records into its
+// own fixed ring that overwrites its oldest events, so the last several
+// seconds are always on hand and a hitch can be dumped after the fact.
+// A record is one uncontended per-ring lock: the exporter is the only other
+// party and copies a ring out under the same lock. Names and categories must
+// outlive the tracer (literals, or intern()).
+class Tracer {
+public:
+  static constexpr std::size_t kRingEvents = 1u << 16;   // per thread
+
+  Tracer();
+  Tracer(const Tracer&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+
+  // Same clock as the input event timestamps (steady_clock since its epoch)
+  static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void span(const char* name, const char* cat, int64_t t0_ns, int64_t t1_ns, const char* detail = nullptr);
+  void instant(const char* name, const char* cat, const char* detail = nullptr);
+  // Labels the calling thread's track in the viewer
+  void name_thread(const char* name);
+  // Stable copy of a runtime string (plugin paths, error text)
+  const char* intern(std::string_view s);
+
+  // Chrome Trace Event JSON of everything that ended in the last
+  // `seconds`. Meant for the ArtifactWriter thread; bytes, or -1.
+  int64_t write_chrome_json(const std::string& path, double seconds);
+  // Same document into `out`. `extra` may append further top-level members
+  // (",\"key\":...") with times relative to the trace's origin_ns.
+  using JsonExtra = std::function<void(TextBuf& out, int64_t origin_ns)>;
+  void chrome_json(TextBuf& out, double seconds, const JsonExtra& extra = {});
+
+private:
+  struct Event {
+    const char* name;
+    const char* cat;
+    const char* detail;   // optional args.detail
+    int64_t t_ns;
+    int64_t dur_ns;       // < 0: instant event
+  };
+  struct Ring {
+    std::mutex m;
+    std::vector<Event> ev;
+    uint64_t head = 0;
+    uint32_t tid = 0;
+    const char* name = nullptr;
+  };
+  friend struct TracerTls;
+
+  Ring* local_ring();
+  void push(const Event& e);
+
+  const uint64_t instance_;
+  std::mutex rings_m_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  std::mutex strings_m_;
+  std::deque<std::string> strings_;
+};
+
+// Records [construction, destruction) as one span, and as a zone of the
+// same name when zones are built in
+class TraceScope {
+public:
+  TraceScope(Tracer& t, const char* name, const char* cat = "host", const char* detail = nullptr)
+    : t_(t), name_(name), cat_(cat), detail_(detail), t0_(Tracer::now_ns())
+#if GPI_ZONES
+    , zone_(name)
+#endif
+  {}
+  ~TraceScope() { t_.span(name_, cat_, t0_, Tracer::now_ns(), detail_); }
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+  Tracer& t_;
+  const char* name_;
+  const char* cat_;
+  const char* detail_;
+  int64_t t0_;
+#if GPI_ZONES
+  gpi::ZoneScope zone_;
+#endif
+};
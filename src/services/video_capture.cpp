@@ -0,0 +1,215 @@
+#include "video_capture.h"
+#if defined(__APPLE__)
+#include <OpenGL/gl3.h>
+#else
+#define GL_GLEXT_PROTOTYPES 1
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+VideoCapture::~VideoCapture() { stop(); }
+
+bool VideoCapture::start(const std::string& path, int w, int h, int fps, int decimate) {
+  if (active_ || w <= 0 || h <= 0) return false;
+  std::error_code ec;
+  const auto parent = std::filesystem::path(path).parent_path();
+  if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+  f_ = std::fopen(path.c_str(), "wb");
+  if (!f_) return false;
+  std::setvbuf(f_, nullptr, _IOFBF, 1 << 20);
+
+  decimate_ = decimate > 0 ? decimate : 1;
+  std::fprintf(f_, "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C420jpeg XYSCSS=420JPEG\n",
+               w, h, fps > 0 ? fps : 60, decimate_);
+  path_ = path; w_ = w; h_ = h;
+  frame_idx_ = 0;
+  frame_bytes_ = (size_t)w * h * 4;
+  bufs_.assign(kRing, std::vector<uint8_t>(frame_bytes_));
+  free_.clear();
+  for (int i = 0; i < kRing; ++i) free_.push_back(i);
+  yuv_.resize((size_t)w * h + 2 * (size_t)((w + 1) / 2) * ((h + 1) / 2));
+  st_ = Stats{};
+  write_ms_total_ = 0.0;
+  stop_ = false;
+  active_ = true;
+  writer_ = std::thread([this]{ writer_main(); });
+  return true;
+}
+
+void VideoCapture::stop() {
+  if (!active_) return;
+  for (Slot& sl : slots_) drain_slot(sl, true);
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (writer_.joinable()) writer_.join();
+  std::fclose(f_); f_ = nullptr;
+  active_ = false;
+}
+
+bool VideoCapture::keep_frame() {
+  const uint64_t idx = frame_idx_++;
+  std::lock_guard<std::mutex> lk(m_);
+  st_.offered++;
+  if (idx % (uint64_t)decimate_ != 0) { st_.decimated++; return false; }
+  return true;
+}
+
+int VideoCapture::acquire_buffer() {
+  std::lock_guard<std::mutex> lk(m_);
+  if (free_.empty()) { st_.dropped_writer++; return -1; }
+  int b = free_.back(); free_.pop_back();
+  return b;
+}
+
+void VideoCapture::capture_gl(int w, int h) {
+  if (!active_ || w != w_ || h != h_) return;
+  const uint64_t idx = frame_idx_;
+  if (!keep_frame()) return;
+  Slot& sl = slots_[next_slot_];
+  if (sl.busy) { std::lock_guard<std::mutex> lk(m_); st_.dropped_gpu++; return; }
+  next_slot_ = (next_slot_ + 1) % kRing;
+
+  // The PBOs outlive a recording; the next one may be at another size
+  if (!sl.pbo) glGenBuffers(1, &sl.pbo);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, sl.pbo);
+  if (sl.bytes != frame_bytes_) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)frame_bytes_, nullptr, GL_STREAM_READ);
+    sl.bytes = frame_bytes_;
+  }
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  sl.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  sl.idx = idx; sl.busy = true;
+}
+
+void VideoCapture::capture_rgba(const uint8_t* rgba, int w, int h) {
+  if (!active_ || !rgba || w != w_ || h != h_) return;
+  const uint64_t idx = frame_idx_;
+  if (!keep_frame()) return;
+  const int b = acquire_buffer();
+  if (b < 0) return;
+  std::memcpy(bufs_[b].data(), rgba, frame_bytes_);
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    jobs_.push_back({b, idx, false});
+  }
+  cv_.notify_one();
+}
+
+void VideoCapture::drain_slot(Slot& sl, bool block) {
+  if (!sl.busy) return;
+  GLsync fence = (GLsync)sl.fence;
+  const GLenum st = glClientWaitSync(fence, block ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                     block ? 1000000000ull : 0);
+  const bool ready = (st == GL_ALREADY_SIGNALED || st == GL_CONDITION_SATISFIED);
+  if (!ready && !block) return;   // still in flight, check next frame
+  if (ready) {
+    const int b = acquire_buffer();
+    if (b >= 0) {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, sl.pbo);
+      const void* src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)frame_bytes_, GL_MAP_READ_BIT);
+      if (src) {
+        std::memcpy(bufs_[b].data(), src, frame_bytes_);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        std::lock_guard<std::mutex> lk(m_);
+        jobs_.push_back({b, sl.idx, true});
+      } else {
+        std::lock_guard<std::mutex> lk(m_);
+        free_.push_back(b);
+        st_.dropped_gpu++;
+      }
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      cv_.notify_one();
+    }
+  } else {
+    std::lock_guard<std::mutex> lk(m_);
+    st_.dropped_gpu++;
+  }
+  glDeleteSync(fence);
+  sl.fence = nullptr;
+  sl.busy = false;
+}
+
+void VideoCapture::poll() {
+  if (!active_) return;
+  for (Slot& sl : slots_) drain_slot(sl, false);
+}
+
+void VideoCapture::release_gl() {
+  stop();
+  for (Slot& sl : slots_) {
+    if (sl.fence) { glDeleteSync((GLsync)sl.fence); sl.fence = nullptr; }
+    if (sl.pbo) { glDeleteBuffers(1, &sl.pbo); sl.pbo = 0; }
+    sl.busy = false; sl.bytes = 0;
+  }
+}
+
+void VideoCapture::writer_main() {
+  for (;;) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lk(m_);
+      cv_.wait(lk, [&]{ return stop_ || !jobs_.empty(); });
+      if (jobs_.empty()) return;   // stop requested and fully drained
+      job = jobs_.front(); jobs_.pop_front();
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    write_frame(bufs_[job.buf].data(), job.idx, job.flip_y);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::lock_guard<std::mutex> lk(m_);
+    free_.push_back(job.buf);
+    st_.written++;
+    write_ms_total_ += ms;
+  }
+}
+
+// RGBA -> I420, BT.601 limited range, 2x2 box-filtered chroma.
+void VideoCapture::write_frame(const uint8_t* rgba, uint64_t idx, bool flip_y) {
+  const int w = w_, h = h_, cw = (w + 1) / 2, ch = (h + 1) / 2;
+  uint8_t* Y = yuv_.data();
+  uint8_t* U = Y + (size_t)w * h;
+  uint8_t* V = U + (size_t)cw * ch;
+  auto row = [&](int y){ return rgba + (size_t)(flip_y ? h - 1 - y : y) * w * 4; };
+
+  for (int y = 0; y < h; ++y) {
+    const uint8_t* p = row(y);
+    uint8_t* yo = Y + (size_t)y * w;
+    for (int x = 0; x < w; ++x, p += 4)
+      yo[x] = (uint8_t)(((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16);
+  }
+  for (int cy = 0; cy < ch; ++cy) {
+    const uint8_t* r0 = row(2 * cy);
+    const uint8_t* r1 = row(std::min(2 * cy + 1, h - 1));
+    for (int cx = 0; cx < cw; ++cx) {
+      const int x0 = 2 * cx * 4, x1 = std::min(2 * cx + 1, w - 1) * 4;
+      const int r = r0[x0] + r0[x1] + r1[x0] + r1[x1];
+      const int g = r0[x0 + 1] + r0[x1 + 1] + r1[x0 + 1] + r1[x1 + 1];
+      const int b = r0[x0 + 2] + r0[x1 + 2] + r1[x0 + 2] + r1[x1 + 2];
+      U[(size_t)cy * cw + cx] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 512) >> 10) + 128);
+      V[(size_t)cy * cw + cx] = (uint8_t)(((112 * r - 94 * g - 18 * b + 512) >> 10) + 128);
+    }
+  }
+
+  char hdr[48];
+  const int n = std::snprintf(hdr, sizeof(hdr), "FRAME Xidx=%llu\n", (unsigned long long)idx);
+  std::fwrite(hdr, 1, (size_t)n, f_);
+  std::fwrite(yuv_.data(), 1, yuv_.size(), f_);
+  std::lock_guard<std::mutex> lk(m_);
+  st_.bytes += (uint64_t)n + yuv_.size();
+}
+
+VideoCapture::Stats VideoCapture::stats() const {
+  std::lock_guard<std::mutex> lk(m_);
+  Stats s = st_;
+  s.pending = (int)jobs_.size();
+  s.avg_write_ms = st_.written ? write_ms_total_ / (double)st_.written : 0.0;
+  return s;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Streaming video capture into a single Y4M (4:2:0) file.
+//
+// GL frames are read back asynchronously into a ring of pixel-pack buffers;
+// poll() maps the ones whose fence has signalled into a fixed set of CPU
+// buffers, and a writer thread converts RGBA to I420 and appends one
+// "FRAME Xidx=<n>" record per frame, so dropped frames show up as gaps in
+// the index. Nothing on the render thread blocks: when the PBO ring or the
+// writer falls behind the frame is dropped and counted instead.
+class VideoCapture {
+public:
+  struct Stats {
+    uint64_t offered = 0;        // capture() calls while recording
+    uint64_t decimated = 0;      // skipped by the capture-rate divider
+    uint64_t written = 0;
+    uint64_t dropped_gpu = 0;    // no free PBO (readback ring full)
+    uint64_t dropped_writer = 0; // no free CPU buffer (writer behind)
+    uint64_t bytes = 0;
+    int      pending = 0;        // frames queued for the writer
+    double   avg_write_ms = 0.0; // convert + fwrite per frame
+  };
+
+  static constexpr int kRing = 4;
+
+  VideoCapture() = default;
+  ~VideoCapture();
+  VideoCapture(const VideoCapture&) = delete;
+  VideoCapture& operator=(const VideoCapture&) = delete;
+
+  // fps is the nominal host rate written to the header; every `decimate`-th
+  // offered frame is kept.
+  bool start(const std::string& path, int w, int h, int fps, int decimate);
+  // Drains outstanding readbacks (blocking) and closes the file.
+  void stop();
+  bool active() const { return active_; }
+  const std::string& path() const { return path_; }
+
+  // End of frame, GL thread. Size changes mid-recording are dropped.
+  void capture_gl(int w, int h);
+  // Headless: RGBA8 rows top-down.
+  void capture_rgba(const uint8_t* rgba, int w, int h);
+  // Once per frame on the GL thread.
+  void poll();
+  // Frees the PBOs; call before the GL context goes away.
+  void release_gl();
+
+  Stats stats() const;
+
+private:
+  struct Slot { unsigned pbo = 0; void* fence = nullptr; uint64_t idx = 0; bool busy = false; size_t bytes = 0; };
+  struct Job  { int buf; uint64_t idx; bool flip_y; };
+
+  bool keep_frame();
+  int  acquire_buffer();
+  void drain_slot(Slot& sl, bool block);
+  void writer_main();
+  void write_frame(const uint8_t* rgba, uint64_t idx, bool flip_y);
+
+  bool active_ = false;
+  std::string path_;
+  int w_ = 0, h_ = 0, decimate_ = 1;
+  uint64_t frame_idx_ = 0;
+  Slot slots_[kRing];
+  int next_slot_ = 0;
+  size_t frame_bytes_ = 0;
+
+  std::FILE* f_ = nullptr;
+  std::vector<std::vector<uint8_t>> bufs_;   // kRing RGBA frames
+  std::vector<uint8_t> yuv_;                 // writer-owned I420 scratch
+  std::vector<int> free_;                    // free buffer indices
+  std::deque<Job> jobs_;
+  mutable std::mutex m_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+  std::thread writer_;
+
+  Stats st_;                                 // guarded by m_
+  double write_ms_total_ = 0.0;
+};
@@ -0,0 +1,101 @@
+#include "zones.h"
+#if GPI_ZONES
+#include <algorithm>
+
+namespace gpi {
+
+ZoneProfiler& zones() {
+  static ZoneProfiler p;
+  return p;
+}
+
+// Keeps the calling thread's ring alive for the profiler and flags it once
+// the thread exits, so its last zones are still drained before removal.
+struct ZoneTls {
+  std::shared_ptr<ZoneBuffer> buf;
+  ~ZoneTls() {
+    if (buf) buf->orphaned.store(true, std::memory_order_release);
+    t_zone_buffer = nullptr;
+  }
+};
+static thread_local ZoneTls zone_tls;
+
+ZoneBuffer* zone_buffer_slow() { return zones().register_thread(); }
+
+ZoneProfiler::ZoneProfiler() : cal_ticks_(zone_ticks()), cal_time_(std::chrono::steady_clock::now()) {
+  frame_start_ = cal_ticks_;
+}
+
+ZoneBuffer* ZoneProfiler::register_thread() {
+  auto b = std::make_shared<ZoneBuffer>();
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    b->thread = next_thread_++;
+    names_.push_back(nullptr);
+    buffers_.push_back(b);
+  }
+  zone_tls.buf = b;
+  t_zone_buffer = b.get();
+  return b.get();
+}
+
+// ns per tick from everything seen since start; settles within a few frames
+void ZoneProfiler::calibrate(uint64_t now_ticks) {
+  const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - cal_time_).count();
+  if (now_ticks > cal_ticks_ && ns > 1e6) ns_per_tick_ = ns / (double)(now_ticks - cal_ticks_);
+}
+
+void ZoneProfiler::end_frame() {
+  const uint64_t now = zone_ticks();
+  calibrate(now);
+  ZoneFrame& f = frames_[cursor_];
+  cursor_ = (cursor_ + 1) % kHistory;
+  f.t0 = frame_start_;
+  f.t1 = now;
+  f.zones.clear();
+  frame_start_ = now;
+
+  std::lock_guard<std::mutex> lk(m_);
+  for (std::size_t i = 0; i < buffers_.size();) {
+    ZoneBuffer& b = *buffers_[i];
+    if (const char* n = b.name.load(std::memory_order_relaxed)) names_[b.thread] = n;
+    const bool orphaned = b.orphaned.load(std::memory_order_acquire);
+    const uint32_t h = b.head.load(std::memory_order_acquire);
+    uint32_t t = b.tail.load(std::memory_order_relaxed);
+    for (; t != h; ++t) f.zones.push_back(b.rec[t % ZoneBuffer::kCap]);
+    b.tail.store(t, std::memory_order_release);
+    if (orphaned) {
+      dropped_retired_ += b.dropped.load(std::memory_order_relaxed);
+      buffers_[i] = buffers_.back();
+      buffers_.pop_back();
+    } else {
+      ++i;
+    }
+  }
+  // Rings hold zones in end order; the view wants parents before children
+  std::sort(f.zones.begin(), f.zones.end(), [](const ZoneSample& a, const ZoneSample& b) {
+    return a.thread != b.thread ? a.thread < b.thread : a.t0 != b.t0 ? a.t0 < b.t0 : a.depth < b.depth;
+  });
+}
+
+const ZoneFrame& ZoneProfiler::worst() const {
+  int w = 0;
+  for (int i = 1; i < kHistory; ++i)
+    if (frames_[i].t1 - frames_[i].t0 > frames_[w].t1 - frames_[w].t0) w = i;
+  return frames_[w];
+}
+
+const char* ZoneProfiler::thread_name(uint16_t t) const {
+  std::lock_guard<std::mutex> lk(m_);
+  return t < names_.size() && names_[t] ? names_[t] : nullptr;
+}
+
+uint64_t ZoneProfiler::dropped() const {
+  std::lock_guard<std::mutex> lk(m_);
+  uint64_t n = dropped_retired_;
+  for (const auto& b : buffers_) n += b->dropped.load(std::memory_order_relaxed);
+  return n;
+}
+
+} // namespace gpi
+#endif
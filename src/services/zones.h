@@ -0,0 +1,155 @@
+#pragma once
+// GPI_ZONE("name"): scoped timing zone for host code, shown per frame in the
+// HUD flame view. Built with GPI_ZONES=1 (CMake option GPI_WITH_ZONES);
+// otherwise the macro expands to nothing and this header declares nothing
+// else that costs anything. GPI_ZONE_FRAME() closes a frame (main loop).
+#ifndef GPI_ZONES
+#define GPI_ZONES 0
+#endif
+
+#if GPI_ZONES
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace gpi {
+
+// Raw counter: TSC on x86, the virtual counter on arm64; converted to ns
+// with a ratio the profiler calibrates against steady_clock
+inline uint64_t zone_ticks() {
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+  uint64_t v;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+  return v;
+#else
+  return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+struct ZoneSample {
+  const char* name;
+  uint64_t t0, t1;     // ticks
+  uint16_t depth;      // nesting on its thread, 0 = outermost
+  uint16_t thread;     // index into ZoneProfiler::thread_name()
+};
+
+// Single-producer ring owned by one thread; the profiler drains it at frame
+// boundaries. A full ring drops the zone and counts it.
+struct ZoneBuffer {
+  static constexpr uint32_t kCap = 1u << 13;
+  ZoneSample rec[kCap];
+  alignas(64) std::atomic<uint32_t> head{0};   // producer
+  alignas(64) std::atomic<uint32_t> tail{0};   // profiler
+  std::atomic<uint64_t> dropped{0};
+  std::atomic<bool> orphaned{false};
+  std::atomic<const char*> name{nullptr};
+  uint16_t thread = 0;
+  uint16_t depth = 0;                          // producer only
+
+  void push(const char* n, uint64_t t0, uint64_t t1, uint16_t d) {
+    const uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= kCap) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    rec[h % kCap] = ZoneSample{ n, t0, t1, d, thread };
+    head.store(h + 1, std::memory_order_release);
+  }
+};
+
+ZoneBuffer* zone_buffer_slow();
+inline thread_local ZoneBuffer* t_zone_buffer = nullptr;
+inline ZoneBuffer* zone_buffer() {
+  ZoneBuffer* b = t_zone_buffer;
+  return b ? b : zone_buffer_slow();
+}
+
+class ZoneScope {
+public:
+  explicit ZoneScope(const char* name) : b_(zone_buffer()), name_(name) {
+    ++b_->depth;
+    t0_ = zone_ticks();
+  }
+  ~ZoneScope() {
+    const uint64_t t1 = zone_ticks();
+    b_->push(name_, t0_, t1, --b_->depth);
+  }
+  ZoneScope(const ZoneScope&) = delete;
+  ZoneScope& operator=(const ZoneScope&) = delete;
+
+private:
+  ZoneBuffer* b_;
+  const char* name_;
+  uint64_t t0_;
+};
+
+// One frame's zones from every thread, ordered by thread then start
+struct ZoneFrame {
+  uint64_t t0 = 0, t1 = 0;   // ticks between two end_frame() calls
+  std::vector<ZoneSample> zones;
+};
+
+// Collects the per-thread rings once per frame (main thread) and keeps the
+// last kHistory frames so the worst one stays inspectable.
+class ZoneProfiler {
+public:
+  static constexpr int kHistory = 240;
+
+  ZoneProfiler();
+  // Drains every thread's ring into the frame that just ended
+  void end_frame();
+
+  const ZoneFrame& last() const { return frames_[(cursor_ + kHistory - 1) % kHistory]; }
+  const ZoneFrame& worst() const;
+  double ns_per_tick() const { return ns_per_tick_; }
+  double ms(uint64_t ticks) const { return (double)ticks * ns_per_tick_ / 1e6; }
+  const char* thread_name(uint16_t t) const;
+  uint64_t dropped() const;
+
+  ZoneBuffer* register_thread();   // zone_buffer_slow()
+
+private:
+  friend struct ZoneTls;
+  void calibrate(uint64_t now_ticks);
+
+  mutable std::mutex m_;
+  std::vector<std::shared_ptr<ZoneBuffer>> buffers_;
+  std::vector<const char*> names_;   // by thread index (under m_)
+  uint64_t dropped_retired_ = 0;
+  uint16_t next_thread_ = 0;
+
+  ZoneFrame frames_[kHistory];
+  int cursor_ = 0;
+  uint64_t frame_start_ = 0;
+
+  uint64_t cal_ticks_ = 0;
+  std::chrono::steady_clock::time_point cal_time_;
+  double ns_per_tick_ = 1.0;
+};
+
+ZoneProfiler& zones();
+// Names the calling thread's track in the flame view
+inline void zone_thread_name(const char* name) { zone_buffer()->name.store(name, std::memory_order_relaxed); }
+
+} // namespace gpi
+
+#define GPI_ZONE_CAT2(a, b) a##b
+#define GPI_ZONE_CAT(a, b) GPI_ZONE_CAT2(a, b)
+#define GPI_ZONE(name) ::gpi::ZoneScope GPI_ZONE_CAT(gpi_zone_, __LINE__)(name)
+#define GPI_ZONE_THREAD(name) ::gpi::zone_thread_name(name)
+#define GPI_ZONE_FRAME() ::gpi::zones().end_frame()
+#else
+#define GPI_ZONE(name) ((void)0)
+#define GPI_ZONE_THREAD(name) ((void)0)
+#define GPI_ZONE_FRAME() ((void)0)
+#endif
@@ -1,4 +1,5 @@
 #include "draw_prim.h"
+#include "soft_raster.h"
 #include <imgui.h>
 
 static ImU32 to_col(unsigned int rgba) {
@@ -19,3 +20,8 @@ void draw2d::draw_rects(const GPI_DrawRect* r, int count) {
     dl->AddRectFilled(p1, p2, to_col(r[i].rgba), 4.0f);
   }
 }
+
+void draw2d::draw_rects_soft(SoftRaster& out, const GPI_DrawRect* r, int count) {
+  if (!r || count<=0) return;
+  for (int i=0;i<count;++i) out.fill_rect(r[i].x, r[i].y, r[i].w, r[i].h, r[i].rgba, 4.0f);
+}
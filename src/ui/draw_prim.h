@@ -3,6 +3,9 @@
 #include <cstdint>
 #include "../../include/gpi/gpi_plugin.h"
 
+class SoftRaster;
+
 namespace draw2d {
 void draw_rects(const GPI_DrawRect* r, int count);
+void draw_rects_soft(SoftRaster& out, const GPI_DrawRect* r, int count);
 }
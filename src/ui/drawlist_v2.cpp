@@ -0,0 +1,155 @@
+#include "drawlist_v2.h"
+#include <algorithm>
+
+namespace {
+
+struct Reader {
+  const uint8_t* p;
+  const uint8_t* e;
+  bool has(uint32_t n) const { return (uint32_t)(e - p) >= n; }
+  uint8_t  u8()  { return *p++; }
+  uint16_t u16() { uint16_t v = (uint16_t)(p[0] | (p[1] << 8)); p += 2; return v; }
+  int16_t  i16() { return (int16_t)u16(); }
+  uint32_t u32() { uint32_t lo = u16(); return lo | ((uint32_t)u16() << 16); }
+  float    q()   { return i16() * 0.25f; }   // GPI_DL2_Q
+};
+
+// Payload bytes after the opcode; TEXT adds its string length on top.
+int payload_size(uint8_t op) {
+  switch (op) {
+    case GPI_DL2_COLOR:      return 4;
+    case GPI_DL2_RECT:       return 8;
+    case GPI_DL2_RRECT:      return 9;
+    case GPI_DL2_LINE:       return 9;
+    case GPI_DL2_CIRCLE:     return 6;
+    case GPI_DL2_SPRITE:     return 20;
+    case GPI_DL2_TEXT:       return 8;
+    case GPI_DL2_PUSH_CLIP:  return 8;
+    case GPI_DL2_POP_CLIP:   return 0;
+    case GPI_DL2_PUSH_XFORM: return 6;
+    case GPI_DL2_POP_XFORM:  return 0;
+    default:                 return -1;
+  }
+}
+
+struct Xform { float tx, ty, s; };
+struct Clip  { float x0, y0, x1, y1; };
+
+} // namespace
+
+const char* dl2_error_str(Dl2Error e) {
+  switch (e) {
+    case Dl2Error::None:           return "ok";
+    case Dl2Error::BadHeader:      return "bad header";
+    case Dl2Error::Truncated:      return "truncated command";
+    case Dl2Error::BadOpcode:      return "unknown opcode";
+    case Dl2Error::StackOverflow:  return "clip/transform stack overflow";
+    case Dl2Error::StackUnderflow: return "pop on empty clip/transform stack";
+    case Dl2Error::Unbalanced:     return "unbalanced clip/transform stack";
+    case Dl2Error::CountMismatch:  return "cmd_count mismatch";
+  }
+  return "?";
+}
+
+Dl2Error dl2_decode(const GPI_DrawListV2* dl, uint32_t mapped_bytes, Dl2Sink* sink) {
+  if (!dl || mapped_bytes < sizeof(GPI_DrawListV2)) return Dl2Error::BadHeader;
+  // Snapshot the header: the plugin side may be writing concurrently.
+  const uint32_t magic = dl->magic, version = dl->version;
+  const uint32_t capacity = dl->capacity, size = dl->size, count = dl->cmd_count;
+  if (magic != GPI_DL2_MAGIC || (version >> 16) != (GPI_DL2_VERSION >> 16)) return Dl2Error::BadHeader;
+  if (capacity > mapped_bytes - sizeof(GPI_DrawListV2) || size > capacity) return Dl2Error::BadHeader;
+
+  const uint8_t* base = (const uint8_t*)dl + sizeof(GPI_DrawListV2);
+  Reader r{base, base + size};
+  Xform xf[GPI_DL2_MAX_STACK + 1] = {{0.0f, 0.0f, 1.0f}};
+  Clip  cl[GPI_DL2_MAX_STACK + 1] = {{-1e9f, -1e9f, 1e9f, 1e9f}};
+  int xd = 0, cd = 0;
+  uint32_t rgba = 0xFFFFFFFFu, n = 0;
+  Dl2Error err = Dl2Error::None;
+
+  auto X = [&](float v){ return xf[xd].tx + xf[xd].s * v; };
+  auto Y = [&](float v){ return xf[xd].ty + xf[xd].s * v; };
+
+  while (r.p < r.e) {
+    const uint8_t op = r.u8();
+    const int ps = payload_size(op);
+    if (ps < 0) { err = Dl2Error::BadOpcode; break; }
+    if (!r.has((uint32_t)ps)) { err = Dl2Error::Truncated; break; }
+    ++n;
+    const float s = xf[xd].s;
+    switch (op) {
+      case GPI_DL2_COLOR: rgba = r.u32(); break;
+      case GPI_DL2_RECT:
+      case GPI_DL2_RRECT: {
+        const float x = r.q(), y = r.q(), w = r.q(), h = r.q();
+        const float rad = (op == GPI_DL2_RRECT) ? r.u8() * 0.25f : 0.0f;
+        if (sink) sink->rect(X(x), Y(y), w * s, h * s, rad * s, rgba);
+        break;
+      }
+      case GPI_DL2_LINE: {
+        const float x0 = r.q(), y0 = r.q(), x1 = r.q(), y1 = r.q(), t = r.u8() * 0.25f;
+        if (sink) sink->line(X(x0), Y(y0), X(x1), Y(y1), t * s, rgba);
+        break;
+      }
+      case GPI_DL2_CIRCLE: {
+        const float cx = r.q(), cy = r.q(), rad = r.u16() * 0.25f;
+        if (sink) sink->circle(X(cx), Y(cy), rad * s, rgba);
+        break;
+      }
+      case GPI_DL2_SPRITE: {
+        const float x = r.q(), y = r.q(), w = r.q(), h = r.q();
+        const float u0 = r.u16() / 65535.0f, v0 = r.u16() / 65535.0f;
+        const float u1 = r.u16() / 65535.0f, v1 = r.u16() / 65535.0f;
+        const uint32_t img = r.u32();
+        if (sink) sink->sprite(X(x), Y(y), w * s, h * s, u0, v0, u1, v1, img, rgba);
+        break;
+      }
+      case GPI_DL2_TEXT: {
+        const float x = r.q(), y = r.q();
+        const uint8_t size_px = r.u8(), align = r.u8();
+        const uint16_t len = r.u16();
+        if (!r.has(len)) { err = Dl2Error::Truncated; break; }
+        const char* str = (const char*)r.p;
+        r.p += len;
+        if (sink) sink->text(X(x), Y(y), size_px * s, align, rgba, str, str + len);
+        break;
+      }
+      case GPI_DL2_PUSH_CLIP: {
+        const float x = r.q(), y = r.q(), w = r.q(), h = r.q();
+        if (cd == GPI_DL2_MAX_STACK) { err = Dl2Error::StackOverflow; break; }
+        const Clip& p = cl[cd];
+        Clip c{ std::max(p.x0, X(x)), std::max(p.y0, Y(y)),
+                std::min(p.x1, X(x + w)), std::min(p.y1, Y(y + h)) };
+        c.x1 = std::max(c.x1, c.x0); c.y1 = std::max(c.y1, c.y0);
+        cl[++cd] = c;
+        if (sink) sink->push_clip(c.x0, c.y0, c.x1, c.y1);
+        break;
+      }
+      case GPI_DL2_POP_CLIP:
+        if (cd == 0) { err = Dl2Error::StackUnderflow; break; }
+        --cd;
+        if (sink) sink->pop_clip();
+        break;
+      case GPI_DL2_PUSH_XFORM: {
+        const float tx = r.q(), ty = r.q(), sc = r.u16() / 256.0f;
+        if (xd == GPI_DL2_MAX_STACK) { err = Dl2Error::StackOverflow; break; }
+        const Xform& p = xf[xd];
+        xf[xd + 1] = { p.tx + p.s * tx, p.ty + p.s * ty, p.s * sc };
+        ++xd;
+        break;
+      }
+      case GPI_DL2_POP_XFORM:
+        if (xd == 0) { err = Dl2Error::StackUnderflow; break; }
+        --xd;
+        break;
+    }
+    if (err != Dl2Error::None) break;
+  }
+
+  if (err == Dl2Error::None) {
+    if (cd != 0 || xd != 0) err = Dl2Error::Unbalanced;
+    else if (n != count) err = Dl2Error::CountMismatch;
+  }
+  if (sink) while (cd-- > 0) sink->pop_clip();
+  return err;
+}
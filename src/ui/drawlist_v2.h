@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+extern "C" {
+#include "../../include/gpi/gpi_plugin.h"
+}
+
+// Receives decoded V2 commands in screen space: transforms are applied and
+// clip rects are already intersected with their parent.
+struct Dl2Sink {
+  virtual ~Dl2Sink() = default;
+  virtual void rect(float x, float y, float w, float h, float rounding, uint32_t rgba) = 0;
+  virtual void line(float x0, float y0, float x1, float y1, float thickness, uint32_t rgba) = 0;
+  virtual void circle(float cx, float cy, float r, uint32_t rgba) = 0;
+  virtual void sprite(float x, float y, float w, float h, float u0, float v0, float u1, float v1,
+                      GPI_ImageHandle image, uint32_t tint) = 0;
+  virtual void text(float x, float y, float size_px, uint32_t align, uint32_t rgba,
+                    const char* s, const char* e) = 0;
+  virtual void push_clip(float x0, float y0, float x1, float y1) = 0;
+  virtual void pop_clip() = 0;
+};
+
+enum class Dl2Error {
+  None, BadHeader, Truncated, BadOpcode, StackOverflow, StackUnderflow, Unbalanced, CountMismatch
+};
+const char* dl2_error_str(Dl2Error e);
+
+// Walks the stream once; with sink == nullptr it only validates. `mapped_bytes`
+// is the size of the mapping holding the list and bounds `capacity`. The
+// stream may live in shared memory, so every read is bounds-checked even when
+// a validation pass already succeeded; on error the sink's clip stack is unwound.
+Dl2Error dl2_decode(const GPI_DrawListV2* dl, uint32_t mapped_bytes, Dl2Sink* sink);
@@ -1,16 +1,276 @@
 #include "font_atlas.h"
+#include "glyph_cache.h"
+#include "../platform/fs.h"
 #include <imgui.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 
-bool fontatlas_init_default(HostFont& out, float pixel_height) {
-  if (ImGui::GetCurrentContext() == nullptr) return false; // Safety check
-  ImGuiIO& io = ImGui::GetIO();
-  ImFontConfig cfg; cfg.FontDataOwnedByAtlas = false;
-  ImFont* f = io.Fonts->AddFontDefault();
+namespace {
+
+// On-disk bake: CacheHeader, then line UVs (float4 each), CacheGlyph[glyph_count],
+// then the A8 bitmap. Native endianness; the magic doubles as a byte-order check.
+constexpr uint32_t kCacheMagic   = 0x31414647u;  // "GFA1"
+constexpr uint32_t kCacheVersion = 1;
+constexpr int      kLineUVs      = IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1;
+
+struct CacheHeader {
+  uint32_t magic, version;
+  uint64_t key;            // hash of everything that shapes the bake
+  uint64_t payload_hash;   // hash of the bytes after the header
+  uint32_t tex_w, tex_h, glyph_count, line_uv_count;
+  float font_size, ascent, descent;
+  uint32_t fallback_char, ellipsis_char;
+  float white_u, white_v, uv_scale_x, uv_scale_y;
+  uint32_t reserved;
+};
+static_assert(sizeof(CacheHeader) == 80, "cache header layout");
+
+struct CacheGlyph {
+  uint32_t codepoint, reserved;
+  float advance, x0, y0, x1, y1, u0, v0, u1, v1;
+};
+static_assert(sizeof(CacheGlyph) == 44, "cache glyph layout");
+
+uint64_t fnv1a64(const void* p, std::size_t n, uint64_t h = 0xcbf29ce484222325ull) {
+  const uint8_t* b = (const uint8_t*)p;
+  for (std::size_t i = 0; i < n; ++i) { h ^= b[i]; h *= 0x100000001b3ull; }
+  return h;
+}
+
+bool read_file(const std::string& path, std::vector<uint8_t>& out) {
+  std::ifstream f(path, std::ios::binary);
   if (!f) return false;
-  io.Fonts->Build();
-  out.imgui_font = f;
+  out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+  return !out.empty();
+}
+
+// Copies the atlas bitmap and glyph table so text can be rasterized on the CPU.
+void capture_cpu_atlas(ImFontAtlas* atlas, const ImFont* f, HostFont& out) {
+  unsigned char* px = nullptr; int w = 0, h = 0;
+  atlas->GetTexDataAsAlpha8(&px, &w, &h);
+  if (!px || w <= 0 || h <= 0) return;
+  out.atlas_w = w; out.atlas_h = h;
+  out.atlas_alpha.assign(px, px + (size_t)w * h);
+
+  out.glyphs.clear();
+  out.glyphs.reserve(f->Glyphs.Size);
+  for (const ImFontGlyph& g : f->Glyphs) {
+    FontGlyph fg;
+    fg.codepoint = g.Codepoint; fg.advance = g.AdvanceX;
+    fg.x0 = g.X0; fg.y0 = g.Y0; fg.x1 = g.X1; fg.y1 = g.Y1;
+    fg.u0 = g.U0; fg.v0 = g.V0; fg.u1 = g.U1; fg.v1 = g.V1;
+    if (!g.Visible) fg.x1 = fg.x0;  // whitespace: advance only
+    out.glyphs.push_back(fg);
+  }
+  std::sort(out.glyphs.begin(), out.glyphs.end(),
+            [](const FontGlyph& a, const FontGlyph& b){ return a.codepoint < b.codepoint; });
+  out.fallback_glyph = -1;
+  if (f->FallbackGlyph) {
+    for (size_t i = 0; i < out.glyphs.size(); ++i)
+      if (out.glyphs[i].codepoint == f->FallbackGlyph->Codepoint) { out.fallback_glyph = (int)i; break; }
+  }
+}
+
+void fill_metrics(const ImFont* f, HostFont& out) {
+  out.imgui_font = (void*)f;
   out.ascent = f->Ascent; out.descent = f->Descent;
   out.line_gap = 0.0f;
   out.atlas_px_height = f->FontSize;
+}
+
+// Rebuilds the ImFont and atlas texture state ImGui expects after Build(),
+// from a validated cache image. Mouse cursor shapes are not baked into the
+// cache, so software cursors are disabled for cached atlases.
+ImFont* install_cached(ImFontAtlas* atlas, const uint8_t* base) {
+  const CacheHeader& h = *(const CacheHeader*)base;
+  const uint8_t* p = base + sizeof(CacheHeader);
+  const float* lines = (const float*)p;             p += sizeof(float) * 4 * h.line_uv_count;
+  const CacheGlyph* glyphs = (const CacheGlyph*)p;  p += sizeof(CacheGlyph) * h.glyph_count;
+  const uint8_t* alpha = p;
+
+  atlas->Clear();
+  atlas->Flags |= ImFontAtlasFlags_NoMouseCursors;
+
+  ImFontConfig cfg;
+  cfg.FontDataOwnedByAtlas = false;
+  cfg.SizePixels = h.font_size;
+  atlas->ConfigData.push_back(cfg);
+  ImFont* f = IM_NEW(ImFont);
+  atlas->Fonts.push_back(f);
+  atlas->ConfigData.back().DstFont = f;
+
+  f->ContainerAtlas = atlas;
+  f->ConfigData = &atlas->ConfigData.back();
+  f->ConfigDataCount = 1;
+  f->FontSize = h.font_size;
+  f->Ascent = h.ascent; f->Descent = h.descent;
+  f->FallbackChar = (ImWchar)h.fallback_char;
+  f->EllipsisChar = (ImWchar)h.ellipsis_char;
+  for (uint32_t i = 0; i < h.glyph_count; ++i) {
+    const CacheGlyph& g = glyphs[i];
+    if (g.codepoint == '\t') continue;  // BuildLookupTable synthesizes TAB from space
+    f->AddGlyph(nullptr, (ImWchar)g.codepoint, g.x0, g.y0, g.x1, g.y1, g.u0, g.v0, g.u1, g.v1, g.advance);
+  }
+  f->BuildLookupTable();
+
+  const std::size_t bytes = (std::size_t)h.tex_w * h.tex_h;
+  atlas->TexPixelsAlpha8 = (unsigned char*)IM_ALLOC(bytes);
+  std::memcpy(atlas->TexPixelsAlpha8, alpha, bytes);
+  atlas->TexWidth = (int)h.tex_w; atlas->TexHeight = (int)h.tex_h;
+  atlas->TexUvScale = ImVec2(h.uv_scale_x, h.uv_scale_y);
+  atlas->TexUvWhitePixel = ImVec2(h.white_u, h.white_v);
+  for (int i = 0; i < kLineUVs; ++i)
+    atlas->TexUvLines[i] = ImVec4(lines[i*4+0], lines[i*4+1], lines[i*4+2], lines[i*4+3]);
+  atlas->TexReady = true;
+  return f;
+}
+
+// Maps the cache file and checks it against `key`. Returns the font on a hit.
+ImFont* load_cache(ImFontAtlas* atlas, const std::string& path, uint64_t key) {
+  fsu::MappedFile m;
+  if (!fsu::map_readonly(path, m)) return nullptr;
+  ImFont* f = nullptr;
+  const CacheHeader* h = (const CacheHeader*)m.data;
+  if (m.size >= sizeof(CacheHeader) && h->magic == kCacheMagic && h->version == kCacheVersion &&
+      h->key == key && h->line_uv_count == (uint32_t)kLineUVs && h->glyph_count > 0 &&
+      h->glyph_count < (1u << 20) && h->tex_w > 0 && h->tex_h > 0 &&
+      h->tex_w <= 16384 && h->tex_h <= 16384) {
+    const std::size_t want = sizeof(CacheHeader) + sizeof(float) * 4 * kLineUVs +
+                             sizeof(CacheGlyph) * h->glyph_count + (std::size_t)h->tex_w * h->tex_h;
+    if (m.size == want &&
+        fnv1a64(m.data + sizeof(CacheHeader), m.size - sizeof(CacheHeader)) == h->payload_hash)
+      f = install_cached(atlas, m.data);
+  }
+  fsu::unmap(m);
+  return f;
+}
+
+// Serializes a freshly built atlas. Written to a temp file and renamed so a
+// crash mid-write never leaves a half file that passes the size check.
+bool save_cache(ImFontAtlas* atlas, const ImFont* f, const std::string& path, uint64_t key) {
+  unsigned char* px = nullptr; int w = 0, h = 0;
+  atlas->GetTexDataAsAlpha8(&px, &w, &h);
+  if (!px || w <= 0 || h <= 0 || f->Glyphs.empty()) return false;
+
+  CacheHeader hdr{};
+  hdr.magic = kCacheMagic; hdr.version = kCacheVersion; hdr.key = key;
+  hdr.tex_w = (uint32_t)w; hdr.tex_h = (uint32_t)h;
+  hdr.glyph_count = (uint32_t)f->Glyphs.Size; hdr.line_uv_count = kLineUVs;
+  hdr.font_size = f->FontSize; hdr.ascent = f->Ascent; hdr.descent = f->Descent;
+  hdr.fallback_char = f->FallbackChar; hdr.ellipsis_char = f->EllipsisChar;
+  hdr.white_u = atlas->TexUvWhitePixel.x; hdr.white_v = atlas->TexUvWhitePixel.y;
+  hdr.uv_scale_x = atlas->TexUvScale.x; hdr.uv_scale_y = atlas->TexUvScale.y;
+
+  std::vector<uint8_t> buf(sizeof(CacheHeader));
+  auto append = [&](const void* p, std::size_t n){
+    buf.insert(buf.end(), (const uint8_t*)p, (const uint8_t*)p + n);
+  };
+  for (int i = 0; i < kLineUVs; ++i) {
+    const ImVec4& l = atlas->TexUvLines[i];
+    const float v[4] = {l.x, l.y, l.z, l.w};
+    append(v, sizeof(v));
+  }
+  for (const ImFontGlyph& g : f->Glyphs) {
+    const CacheGlyph cg{g.Codepoint, 0, g.AdvanceX, g.X0, g.Y0, g.X1, g.Y1, g.U0, g.V0, g.U1, g.V1};
+    append(&cg, sizeof(cg));
+  }
+  append(px, (std::size_t)w * h);
+  hdr.payload_hash = fnv1a64(buf.data() + sizeof(CacheHeader), buf.size() - sizeof(CacheHeader));
+  std::memcpy(buf.data(), &hdr, sizeof(hdr));
+
+  std::error_code ec;
+  std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+  const std::string tmp = path + ".tmp";
+  {
+    std::ofstream o(tmp, std::ios::binary | std::ios::trunc);
+    if (!o) return false;
+    o.write((const char*)buf.data(), (std::streamsize)buf.size());
+    if (!o) return false;
+  }
+  std::filesystem::rename(tmp, path, ec);
+  return !ec;
+}
+
+std::string cache_path(const std::string& dir, const std::string& ttf_path, float px) {
+  const std::string stem = ttf_path.empty() ? std::string("default")
+                                            : std::filesystem::path(ttf_path).stem().string();
+  char name[160];
+  std::snprintf(name, sizeof(name), "fontatlas_%s_%.1f.bin", stem.c_str(), px);
+  return (std::filesystem::path(dir) / name).string();
+}
+
+} // namespace
+
+bool fontatlas_init(HostFont& out, const std::string& ttf_path, float pixel_height,
+                    const std::string& cache_dir) {
+  if (pixel_height <= 0.0f) pixel_height = 13.0f;
+  // Headless runs have no ImGui context; keep a host-owned atlas alive instead.
+  static ImFontAtlas headless_atlas;
+  ImFontAtlas* atlas = ImGui::GetCurrentContext() ? ImGui::GetIO().Fonts : &headless_atlas;
+  if (atlas == &headless_atlas && atlas->IsBuilt()) {
+    ImFont* f = atlas->Fonts[0];
+    fill_metrics(f, out);
+    capture_cpu_atlas(atlas, f, out);
+    return true;
+  }
+
+  std::vector<uint8_t> ttf;
+  if (!ttf_path.empty() && !read_file(ttf_path, ttf)) {
+    std::fprintf(stderr, "Font: cannot read %s, using built-in font\n", ttf_path.c_str());
+  }
+
+  // Key: format + ImGui version, font bytes, size and glyph ranges.
+  const ImWchar* ranges = atlas->GetGlyphRangesDefault();
+  std::size_t nranges = 0;
+  while (ranges[nranges]) ++nranges;
+  const uint32_t ver[3] = {kCacheVersion, (uint32_t)IMGUI_VERSION_NUM, (uint32_t)sizeof(ImWchar)};
+  uint64_t key = fnv1a64(ver, sizeof(ver));
+  key = ttf.empty() ? fnv1a64("builtin:ProggyClean", 19, key) : fnv1a64(ttf.data(), ttf.size(), key);
+  key = fnv1a64(&pixel_height, sizeof(pixel_height), key);
+  key = fnv1a64(ranges, nranges * sizeof(ImWchar), key);
+
+  const std::string path = cache_dir.empty() ? std::string()
+                         : cache_path(cache_dir, ttf.empty() ? std::string() : ttf_path, pixel_height);
+  ImFont* f = path.empty() ? nullptr : load_cache(atlas, path, key);
+  out.from_cache = f != nullptr;
+  if (!f) {
+    atlas->Clear();
+    ImFontConfig cfg;
+    cfg.SizePixels = pixel_height;
+    if (!ttf.empty()) {
+      // The atlas owns (and IM_FREEs) the font data.
+      void* data = IM_ALLOC(ttf.size());
+      std::memcpy(data, ttf.data(), ttf.size());
+      f = atlas->AddFontFromMemoryTTF(data, (int)ttf.size(), pixel_height, &cfg, ranges);
+    } else {
+      f = atlas->AddFontDefault(&cfg);
+    }
+    if ((!f || !atlas->Build()) && !ttf.empty()) {
+      std::fprintf(stderr, "Font: %s failed to build, using built-in font\n", ttf_path.c_str());
+      atlas->Clear();
+      f = atlas->AddFontDefault(&cfg);
+      if (f && !atlas->Build()) f = nullptr;
+    }
+    if (!f || !atlas->IsBuilt()) return false;
+    if (!path.empty() && !save_cache(atlas, f, path, key))
+      std::fprintf(stderr, "Font: could not write atlas cache %s\n", path.c_str());
+  }
+  fill_metrics(f, out);
+  capture_cpu_atlas(atlas, f, out);
   return true;
 }
+
+GlyphRef HostFont::resolve(uint32_t cp) const {
+  GlyphRef r;
+  if ((r.g = find_glyph_exact(cp))) return r;
+  if (dynamic && (r.g = dynamic->lookup(cp, &r.page))) return r;
+  r.page = -1;
+  r.g = fallback_glyph >= 0 ? &glyphs[fallback_glyph] : nullptr;
+  return r;
+}
+
+bool fontatlas_init_default(HostFont& out, float pixel_height) {
+  return fontatlas_init(out, std::string(), pixel_height);
+}
@@ -1,9 +1,62 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Glyph quad in font units (FontSize == atlas_px_height); UVs index atlas_alpha.
+struct FontGlyph {
+  uint32_t codepoint = 0;
+  float advance = 0;
+  float x0=0, y0=0, x1=0, y1=0;
+  float u0=0, v0=0, u1=0, v1=0;
+};
+
+class GlyphCache;
+
+// A resolved glyph and where its pixels live: page -1 is the static atlas,
+// anything else a GlyphCache page.
+struct GlyphRef {
+  const FontGlyph* g = nullptr;
+  int page = -1;
+};
 
 struct HostFont {
   void* imgui_font = nullptr;  // ImFont*
   float ascent=0, descent=0, line_gap=0, atlas_px_height=0;
+
+  // CPU copy of the atlas for the software renderer (and anything else that
+  // rasterizes text without a GL context).
+  std::vector<uint8_t> atlas_alpha;   // A8, atlas_w * atlas_h
+  int atlas_w = 0, atlas_h = 0;
+  std::vector<FontGlyph> glyphs;      // sorted by codepoint
+  int fallback_glyph = -1;            // index into glyphs, -1 if none
+  bool from_cache = false;            // atlas came from the on-disk bake
+  GlyphCache* dynamic = nullptr;      // on-demand glyphs missing from the atlas
+
+  const FontGlyph* find_glyph_exact(uint32_t cp) const {
+    auto it = std::lower_bound(glyphs.begin(), glyphs.end(), cp,
+                               [](const FontGlyph& g, uint32_t c){ return g.codepoint < c; });
+    return (it != glyphs.end() && it->codepoint == cp) ? &*it : nullptr;
+  }
+  const FontGlyph* find_glyph(uint32_t cp) const {
+    if (const FontGlyph* g = find_glyph_exact(cp)) return g;
+    return fallback_glyph >= 0 ? &glyphs[fallback_glyph] : nullptr;
+  }
+  // Static atlas first, then the dynamic cache (which queues misses), then
+  // the fallback glyph.
+  GlyphRef resolve(uint32_t cp) const;
 };
 
+// Builds the host font from `ttf_path` (empty = ImGui's built-in ProggyClean)
+// at `pixel_height`. Works without an ImGui context (headless) by using a
+// host-owned atlas; in that case imgui_font points into that atlas.
+//
+// The baked atlas (A8 bitmap, glyph metrics, white/line UVs) is cached in
+// `cache_dir`, keyed by a hash of the font bytes, size, glyph ranges and
+// ImGui version. Later launches map the file and skip rasterization; any
+// mismatch or damage falls back to a rebuild that rewrites the cache.
+// An empty cache_dir disables caching.
+bool fontatlas_init(HostFont& out, const std::string& ttf_path, float pixel_height,
+                    const std::string& cache_dir = "userdata/cache");
 bool fontatlas_init_default(HostFont& out, float pixel_height = 18.0f);
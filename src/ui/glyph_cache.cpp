@@ -0,0 +1,248 @@
+#include "glyph_cache.h"
+#if defined(__APPLE__)
+#include <OpenGL/gl3.h>
+#else
+#define GL_GLEXT_PROTOTYPES 1
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+// ImGui ships stb_truetype; a private static copy keeps this unit independent
+// of the one compiled into imgui_draw.cpp. Being static, every stbtt function
+// this unit does not call would warn as unused.
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-function"
+#pragma clang diagnostic ignored "-Wunused-parameter"
+#elif defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#elif defined(_MSC_VER)
+#pragma warning (push)
+#pragma warning (disable: 4505)   // unreferenced function with internal linkage has been removed
+#pragma warning (disable: 4100)   // unreferenced formal parameter
+#endif
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <imstb_truetype.h>
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
+#elif defined(_MSC_VER)
+#pragma warning (pop)
+#endif
+
+GlyphCache::GlyphCache() = default;
+
+GlyphCache::~GlyphCache() {
+  pool_.wait_idle();  // jobs read ttf_/info_
+  delete (stbtt_fontinfo*)info_;
+}
+
+bool GlyphCache::init(const std::string& ttf_path, float pixel_height, float baseline, int max_pages) {
+  if (ttf_path.empty() || pixel_height <= 0) return false;
+  std::ifstream f(ttf_path, std::ios::binary);
+  if (!f) return false;
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  auto* info = new stbtt_fontinfo();
+  const int off = data.empty() ? -1 : stbtt_GetFontOffsetForIndex(data.data(), 0);
+  if (off < 0 || !stbtt_InitFont(info, data.data(), off)) { delete info; return false; }
+
+  ttf_ = std::move(data);        // buffer address is unchanged by the move
+  info_ = info;
+  scale_ = stbtt_ScaleForPixelHeight(info, pixel_height);
+  baseline_ = baseline;
+  cell_ = std::min((int)std::ceil(pixel_height * 1.5f) + 2, kPageSize);
+  per_row_ = kPageSize / cell_;
+  max_pages_ = std::max(1, max_pages);
+  pages_.reserve(max_pages_);
+  return true;
+}
+
+GlyphCache::Raster GlyphCache::rasterize(uint32_t cp) const {
+  Raster r; r.cp = cp;
+  auto* info = (stbtt_fontinfo*)info_;
+  const int gi = stbtt_FindGlyphIndex(info, (int)cp);
+  if (gi == 0) return r;
+  int adv = 0, lsb = 0, x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+  stbtt_GetGlyphHMetrics(info, gi, &adv, &lsb);
+  stbtt_GetGlyphBitmapBox(info, gi, scale_, scale_, &x0, &y0, &x1, &y1);
+  r.ok = true;
+  r.advance = adv * scale_;
+  r.x0 = (float)x0; r.y0 = baseline_ + (float)y0;
+  // Oversized glyphs are cropped to the cell (1 px gutter each side).
+  r.w = std::min(x1 - x0, cell_ - 2);
+  r.h = std::min(y1 - y0, cell_ - 2);
+  if (r.w > 0 && r.h > 0) {
+    r.a8.resize((size_t)r.w * r.h);
+    stbtt_MakeGlyphBitmap(info, r.a8.data(), r.w, r.h, r.w, scale_, scale_, gi);
+  } else {
+    r.w = r.h = 0;
+  }
+  return r;
+}
+
+void GlyphCache::lru_unlink(int i) {
+  Slot& s = slots_[i];
+  if (s.prev >= 0) slots_[s.prev].next = s.next; else lru_head_ = s.next;
+  if (s.next >= 0) slots_[s.next].prev = s.prev; else lru_tail_ = s.prev;
+  s.prev = s.next = -1;
+}
+
+void GlyphCache::lru_push_front(int i) {
+  Slot& s = slots_[i];
+  s.prev = -1; s.next = lru_head_;
+  if (lru_head_ >= 0) slots_[lru_head_].prev = i;
+  lru_head_ = i;
+  if (lru_tail_ < 0) lru_tail_ = i;
+}
+
+int GlyphCache::take_slot() {
+  if (free_.empty() && (int)pages_.size() < max_pages_) {
+    const int per_page = per_row_ * per_row_;
+    const int base = (int)slots_.size();
+    pages_.push_back(Page{});
+    pages_.back().a8.assign((size_t)kPageSize * kPageSize, 0);
+    slots_.resize(slots_.size() + per_page);
+    for (int i = per_page - 1; i >= 0; --i) free_.push_back(base + i);
+  }
+  if (!free_.empty()) { const int i = free_.back(); free_.pop_back(); return i; }
+  // Full: recycle the least recently drawn glyph, but never one referenced
+  // this frame (its pixels may already be queued for drawing).
+  const int i = lru_tail_;
+  if (i < 0 || slots_[i].last_frame >= frame_) return -1;
+  resident_.erase(slots_[i].cp);
+  lru_unlink(i);
+  slots_[i].used = false;
+  ++evicted_;
+  return i;
+}
+
+bool GlyphCache::place(const Raster& r) {
+  if (!r.ok) { absent_.insert(r.cp); return true; }
+  const int i = take_slot();
+  if (i < 0) return false;
+
+  const int per_page = per_row_ * per_row_;
+  const int page = i / per_page, cell = i % per_page;
+  const int cx = (cell % per_row_) * cell_, cy = (cell / per_row_) * cell_;
+  Page& p = pages_[page];
+  for (int y = 0; y < cell_; ++y)
+    std::memset(&p.a8[(size_t)(cy + y) * kPageSize + cx], 0, cell_);
+  for (int y = 0; y < r.h; ++y)
+    std::memcpy(&p.a8[(size_t)(cy + 1 + y) * kPageSize + cx + 1], &r.a8[(size_t)y * r.w], r.w);
+
+  Slot& s = slots_[i];
+  s.cp = r.cp; s.used = true; s.last_frame = frame_;  // never evicted by its own batch
+  FontGlyph& g = s.g;
+  g.codepoint = r.cp; g.advance = r.advance;
+  g.x0 = r.x0; g.y0 = r.y0; g.x1 = r.x0 + r.w; g.y1 = r.y0 + r.h;
+  const float inv = 1.0f / kPageSize;
+  g.u0 = (cx + 1) * inv; g.v0 = (cy + 1) * inv;
+  g.u1 = (cx + 1 + r.w) * inv; g.v1 = (cy + 1 + r.h) * inv;
+  if (!s.dirty) { s.dirty = true; p.dirty.push_back(i); }
+  lru_push_front(i);
+  resident_[r.cp] = i;
+  ++uploaded_;
+  return true;
+}
+
+void GlyphCache::begin_frame() {
+  if (!active()) return;
+  last_.misses = (uint32_t)missed_.size();
+  last_.uploaded = uploaded_;
+  last_.evicted = evicted_;
+  missed_.clear();
+  uploaded_ = evicted_ = 0;
+  ++frame_;
+
+  std::vector<Raster> ready;
+  {
+    std::lock_guard<std::mutex> lk(done_m_);
+    ready.swap(done_);
+  }
+  if (!deferred_.empty()) {
+    ready.insert(ready.begin(), std::make_move_iterator(deferred_.begin()),
+                 std::make_move_iterator(deferred_.end()));
+    deferred_.clear();
+  }
+  for (Raster& r : ready) {
+    if (place(r)) pending_.erase(r.cp);
+    else deferred_.push_back(std::move(r));
+  }
+}
+
+const FontGlyph* GlyphCache::lookup(uint32_t cp, int* page) {
+  if (!active()) return nullptr;
+  auto it = resident_.find(cp);
+  if (it != resident_.end()) {
+    const int i = it->second;
+    slots_[i].last_frame = frame_;
+    if (lru_head_ != i) { lru_unlink(i); lru_push_front(i); }
+    *page = i / (per_row_ * per_row_);
+    return &slots_[i].g;
+  }
+  if (absent_.count(cp)) return nullptr;
+  missed_.insert(cp);
+  if (blocking_) {
+    if (!pending_.count(cp) && place(rasterize(cp)) && resident_.count(cp)) return lookup(cp, page);
+  } else if (pending_.insert(cp).second) {
+    pool_.submit([this, cp]{
+      Raster r = rasterize(cp);
+      std::lock_guard<std::mutex> lk(done_m_);
+      done_.push_back(std::move(r));
+    });
+  }
+  return nullptr;
+}
+
+unsigned GlyphCache::gl_texture(int page) {
+  Page& p = pages_[page];
+  const int per_page = per_row_ * per_row_;
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  if (!p.gl_tex) {
+    glGenTextures(1, &p.gl_tex);
+    glBindTexture(GL_TEXTURE_2D, p.gl_tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // Single channel storage, sampled as white * coverage like the font atlas.
+    const GLint swizzle[4] = {GL_ONE, GL_ONE, GL_ONE, GL_RED};
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, kPageSize, kPageSize, 0, GL_RED, GL_UNSIGNED_BYTE, p.a8.data());
+  } else if (!p.dirty.empty()) {
+    glBindTexture(GL_TEXTURE_2D, p.gl_tex);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, kPageSize);
+    for (int i : p.dirty) {
+      const int cell = i % per_page;
+      const int cx = (cell % per_row_) * cell_, cy = (cell / per_row_) * cell_;
+      glTexSubImage2D(GL_TEXTURE_2D, 0, cx, cy, cell_, cell_, GL_RED, GL_UNSIGNED_BYTE,
+                      &p.a8[(size_t)cy * kPageSize + cx]);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  }
+  for (int i : p.dirty) slots_[i].dirty = false;
+  p.dirty.clear();
+  return p.gl_tex;
+}
+
+void GlyphCache::release_gl() {
+  for (Page& p : pages_)
+    if (p.gl_tex) { glDeleteTextures(1, &p.gl_tex); p.gl_tex = 0; }
+}
+
+GlyphCacheStats GlyphCache::stats() const {
+  GlyphCacheStats st = last_;
+  st.pages = (int)pages_.size();
+  st.slots_used = (int)resident_.size();
+  st.slots_total = max_pages_ * per_row_ * per_row_;
+  st.pending = (int)pending_.size();
+  return st;
+}
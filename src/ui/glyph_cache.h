@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "font_atlas.h"
+#include "../platform/thread_pool.h"
+
+struct GlyphCacheStats {
+  int pages = 0;              // pages allocated so far
+  int slots_used = 0, slots_total = 0;
+  // Last completed frame
+  uint32_t misses = 0;        // distinct codepoints drawn without a resident glyph
+  uint32_t uploaded = 0;      // glyphs placed into pages
+  uint32_t evicted = 0;
+  int pending = 0;            // rasterizations in flight
+};
+
+// Dynamic A8 glyph atlas for codepoints the prebaked atlas lacks (CJK etc.).
+// Misses are rasterized on a worker thread from the TTF and placed into
+// fixed-size cells on 512x512 pages at the next begin_frame(); when every
+// page is full the least recently drawn glyph is evicted. Glyph metrics are
+// in the same units as the host font (px at atlas_px_height), so text
+// scales exactly like the static atlas. GL pages get sub-rect updates.
+class GlyphCache {
+public:
+  static constexpr int kPageSize = 512;
+
+  GlyphCache();
+  ~GlyphCache();
+  GlyphCache(const GlyphCache&) = delete;
+  GlyphCache& operator=(const GlyphCache&) = delete;
+
+  // `baseline` is the static font's rounded ascent so both share a baseline.
+  bool init(const std::string& ttf_path, float pixel_height, float baseline, int max_pages = 4);
+  bool active() const { return !ttf_.empty(); }
+
+  // Rasterize misses inline so the very first frame is complete
+  // (headless golden runs must not depend on worker timing).
+  void set_blocking(bool b) { blocking_ = b; }
+
+  // Places finished rasterizations and rolls the per-frame stats over.
+  void begin_frame();
+
+  // Resident glyph for cp (touching it for LRU), or nullptr after queueing
+  // it. Codepoints the font does not have also return nullptr.
+  const FontGlyph* lookup(uint32_t cp, int* page);
+
+  const uint8_t* page_pixels(int page) const { return pages_[page].a8.data(); }
+  // GL path: creates the page texture on first use and uploads dirty cells.
+  unsigned gl_texture(int page);
+  void release_gl();
+
+  GlyphCacheStats stats() const;
+
+private:
+  struct Raster {
+    uint32_t cp = 0;
+    bool ok = false;
+    int w = 0, h = 0;
+    float x0 = 0, y0 = 0, advance = 0;
+    std::vector<uint8_t> a8;
+  };
+  struct Slot {
+    uint32_t cp = 0;
+    bool used = false, dirty = false;
+    int prev = -1, next = -1;      // LRU links, head = most recent
+    uint64_t last_frame = 0;
+    FontGlyph g;
+  };
+  struct Page {
+    std::vector<uint8_t> a8;
+    unsigned gl_tex = 0;
+    std::vector<int> dirty;        // slot indices awaiting upload
+  };
+
+  Raster rasterize(uint32_t cp) const;
+  bool place(const Raster& r);
+  int take_slot();
+  void lru_unlink(int i);
+  void lru_push_front(int i);
+
+  std::vector<uint8_t> ttf_;
+  void* info_ = nullptr;           // stbtt_fontinfo
+  float scale_ = 0, baseline_ = 0;
+  int cell_ = 0, per_row_ = 0, max_pages_ = 0;
+  bool blocking_ = false;
+
+  std::vector<Page> pages_;
+  std::vector<Slot> slots_;
+  std::vector<int> free_;
+  int lru_head_ = -1, lru_tail_ = -1;
+  std::unordered_map<uint32_t, int> resident_;
+  std::unordered_set<uint32_t> pending_, absent_, missed_;
+  std::vector<Raster> deferred_;   // finished but no evictable slot yet
+  uint64_t frame_ = 1;
+  uint32_t uploaded_ = 0, evicted_ = 0;
+  GlyphCacheStats last_{};
+
+  std::mutex done_m_;
+  std::vector<Raster> done_;
+  ThreadPool pool_{1};
+};
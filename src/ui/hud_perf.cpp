@@ -1,11 +1,42 @@
 #include "hud_perf.h"
 #include <imgui.h>
+#include <algorithm>
+#include <cstdio>
 
-static void spark(const std::vector<double>& s, float h=36.0f) {
-  if (s.empty()) { ImGui::TextDisabled("no data"); return; }
+static void spark(const CallHistogram& h, float height=36.0f) {
+  if (h.size() == 0) { ImGui::TextDisabled("no data"); return; }
   ImGui::PlotLines("##spark", [](void* d,int i)->float{
-    auto* v = (std::vector<double>*)d; return (float)(*v)[i];
-  }, (void*)&s, (int)s.size(), 0, nullptr, 0.0f, 24.0f, ImVec2(180,h));
+    return (float)((const CallHistogram*)d)->at((size_t)i);
+  }, (void*)&h, (int)h.size(), 0, nullptr, 0.0f, 24.0f, ImVec2(180,height));
+}
+
+void PerCallHud::add_counters(const std::string& plugin, const char* phase, const PerfSample& s) {
+  if (!s.valid) return;
+  for (CallCounters& c : counters)
+    if (c.plugin == plugin && c.phase == phase) { c.add(s); return; }
+  CallCounters c;
+  c.plugin = plugin;
+  c.phase = phase;
+  c.add(s);
+  counters.push_back(std::move(c));
+}
+
+// Rough rules of thumb (misses per 1000 instructions) for where the time goes
+static const char* likely_bound(const CallCounters& c) {
+  if (c.has(kPerfLlcMisses) && c.mpki(kPerfLlcMisses) >= 1.0) return "LLC misses (memory bound)";
+  if (c.has(kPerfL1dMisses) && c.mpki(kPerfL1dMisses) >= 20.0) return "L1d misses";
+  if (c.has(kPerfBranchMisses) && c.mpki(kPerfBranchMisses) >= 5.0) return "branch misses";
+  return c.ipc() >= 1.0 ? "compute" : "";
+}
+
+static void counter_line(const CallCounters& c) {
+  char l1[16] = "-", llc[16] = "-", br[16] = "-";
+  if (c.has(kPerfL1dMisses)) std::snprintf(l1, sizeof(l1), "%.1f", c.mpki(kPerfL1dMisses));
+  if (c.has(kPerfLlcMisses)) std::snprintf(llc, sizeof(llc), "%.2f", c.mpki(kPerfLlcMisses));
+  if (c.has(kPerfBranchMisses)) std::snprintf(br, sizeof(br), "%.2f", c.mpki(kPerfBranchMisses));
+  const double mcyc = c.calls ? (double)c.v[kPerfCycles] / (double)c.calls / 1e6 : 0.0;
+  ImGui::Text("%s %s  IPC %.2f  %.2f Mcyc/call  miss/ki L1d %s  LLC %s  br %s  %s",
+              c.plugin.c_str(), c.phase.c_str(), c.ipc(), mcyc, l1, llc, br, likely_bound(c));
 }
 
 void PerCallHud::draw_small() {
@@ -14,10 +45,28 @@ void PerCallHud::draw_small() {
     ImGuiWindowFlags_NoDecoration|ImGuiWindowFlags_AlwaysAutoResize|
     ImGuiWindowFlags_NoSavedSettings|ImGuiWindowFlags_NoFocusOnAppearing|ImGuiWindowFlags_NoNav);
   auto us = upd.stats(), rs = ren.stats();
-  ImGui::Text("Update  avg %.2f  p95 %.2f  p99 %.2f  last %.2f", us.avg, us.p95, us.p99, us.last);
-  spark(upd.samples());
+  ImGui::Text("Update  avg %.2f  p50 %.2f  p90 %.2f  p99 %.2f  p99.9 %.2f  max %.2f  last %.2f",
+              us.avg, us.p50, us.p90, us.p99, us.p999, us.max, us.last);
+  spark(upd);
   ImGui::Separator();
-  ImGui::Text("Render  avg %.2f  p95 %.2f  p99 %.2f  last %.2f", rs.avg, rs.p95, rs.p99, rs.last);
-  spark(ren.samples());
+  ImGui::Text("Render  avg %.2f  p50 %.2f  p90 %.2f  p99 %.2f  p99.9 %.2f  max %.2f  last %.2f",
+              rs.avg, rs.p50, rs.p90, rs.p99, rs.p999, rs.max, rs.last);
+  spark(ren);
+  if (!counters.empty()) {
+    ImGui::Separator();
+    for (const CallCounters& c : counters) counter_line(c);
+  }
+  if (profile.samples()) {
+    if (ImGui::GetTime() - top_t_ >= 0.5) {
+      top_ = profile.top((std::size_t)std::max(profile_top, 1));
+      top_t_ = ImGui::GetTime();
+    }
+    const double n = (double)profile.samples();
+    ImGui::Separator();
+    ImGui::Text("Profile  %llu samples  %llu dropped      self%%  total%%",
+                (unsigned long long)profile.samples(), (unsigned long long)profile.dropped());
+    for (const auto& r : top_)
+      ImGui::Text("  %-40.40s %6.1f %6.1f", r.name.c_str(), 100.0 * (double)r.self / n, 100.0 * (double)r.total / n);
+  }
   ImGui::End();
 }
@@ -1,8 +1,20 @@
 #pragma once
+#include <string>
+#include <vector>
 #include "../services/metrics_detail.h"
+#include "../services/artifacts.h"
+#include "../runtime/plugin_profile.h"
 
 struct PerCallHud {
   CallHistogram upd{512};
   CallHistogram ren{512};
+  std::vector<CallCounters> counters;   // session totals per plugin and phase
+  PluginProfileReader profile;          // sampled stacks, when profile_hz > 0
+  int profile_top = 12;
+  void add_counters(const std::string& plugin, const char* phase, const PerfSample& s);
   void draw_small();
+
+private:
+  std::vector<PluginProfileReader::Row> top_;   // refreshed twice a second
+  double top_t_ = -1.0;
 };
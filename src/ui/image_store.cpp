@@ -0,0 +1,51 @@
+#include "image_store.h"
+#if defined(__APPLE__)
+#include <OpenGL/gl3.h>
+#else
+#include <GL/gl.h>
+#endif
+#include <cstring>
+
+uint32_t ImageStore::upload(const void* rgba, int w, int h) {
+  if (!rgba || w <= 0 || h <= 0 || w > 8192 || h > 8192) return 0;
+  const uint32_t handle = next_++;
+  HostImage& im = images_[handle];
+  im.w = w; im.h = h;
+  im.rgba.resize((size_t)w * h * 4);
+  std::memcpy(im.rgba.data(), rgba, im.rgba.size());
+  return handle;
+}
+
+void ImageStore::free(uint32_t handle) {
+  auto it = images_.find(handle);
+  if (it == images_.end()) return;
+  if (it->second.gl_tex) glDeleteTextures(1, &it->second.gl_tex);
+  images_.erase(it);
+}
+
+const HostImage* ImageStore::get(uint32_t handle) const {
+  auto it = images_.find(handle);
+  return it == images_.end() ? nullptr : &it->second;
+}
+
+unsigned ImageStore::gl_texture(uint32_t handle) {
+  auto it = images_.find(handle);
+  if (it == images_.end()) return 0;
+  HostImage& im = it->second;
+  if (!im.gl_tex) {
+    glGenTextures(1, &im.gl_tex);
+    glBindTexture(GL_TEXTURE_2D, im.gl_tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, im.w, im.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, im.rgba.data());
+  }
+  return im.gl_tex;
+}
+
+void ImageStore::release_gl() {
+  for (auto& kv : images_)
+    if (kv.second.gl_tex) { glDeleteTextures(1, &kv.second.gl_tex); kv.second.gl_tex = 0; }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Host side of GPI_CAP_IMAGES_V1: plugin uploads keep a CPU copy (used by the
+// software rasterizer) and get a GL texture lazily on first GL draw.
+struct HostImage {
+  int w = 0, h = 0;
+  std::vector<uint8_t> rgba;
+  unsigned gl_tex = 0;
+};
+
+class ImageStore {
+public:
+  uint32_t upload(const void* rgba, int w, int h);   // 0 = failure
+  void free(uint32_t handle);
+  const HostImage* get(uint32_t handle) const;
+  // GL path only; creates the texture on first use (needs a current context).
+  unsigned gl_texture(uint32_t handle);
+  void release_gl();
+
+private:
+  std::unordered_map<uint32_t, HostImage> images_;
+  uint32_t next_ = 1;
+};
@@ -1,4 +1,5 @@
 #include "log_panel.h"
+#include "../services/zones.h"
 #include <imgui.h>
 #include <deque>
 
@@ -10,6 +11,7 @@ static bool pass(int filter, LogLvl lvl) {
 }
 
 void LogPanel::draw(LogBus& bus) {
+  GPI_ZONE("LogPanel::draw");
   ImGui::SetNextWindowSize({560,320}, ImGuiCond_FirstUseEver);
   if (ImGui::Begin("Log")) {
     ImGui::TextUnformatted("Filter:");
@@ -18,6 +20,12 @@ void LogPanel::draw(LogBus& bus) {
     ImGui::RadioButton("Info",  &filter_, 1); ImGui::SameLine();
     ImGui::RadioButton("Warn",  &filter_, 2); ImGui::SameLine();
     ImGui::RadioButton("Error", &filter_, 3);
+    const LogBus::Stats st = bus.stats();
+    if (st.dropped || st.limited) {
+      ImGui::SameLine();
+      ImGui::TextDisabled("(%llu dropped, %llu rate-limited)",
+                          (unsigned long long)st.dropped, (unsigned long long)st.limited);
+    }
 
     ImGui::Separator();
     std::deque<LogMsg> snap; bus.snapshot(snap, 1000);
@@ -1,13 +1,63 @@
 #include "render_drawlist.h"
 #include "font_atlas.h"
+#include "image_store.h"
+#include "glyph_cache.h"
+#include "../services/zones.h"
 #include <imgui.h>
+#include <imgui_internal.h>
+#include <cmath>
+#include <cstdint>
 
 static ImU32 to_col(unsigned rgba){
   unsigned r= rgba & 0xFFu, g=(rgba>>8)&0xFFu, b=(rgba>>16)&0xFFu, a=(rgba>>24)&0xFFu;
   return IM_COL32(r,g,b,a);
 }
 
+// With a dynamic glyph cache attached, runs are laid out here instead of by
+// ImFont::RenderText so each glyph can come from either atlas. The layout
+// mirrors RenderText (pixel-snapped origin, FontSize-scaled metrics).
+static float text_width(const HostFont& font, ImFont* f, float size_px, const char* s, const char* e) {
+  if (!font.dynamic) return f->CalcTextSizeA(size_px, FLT_MAX, 0.0f, s, e).x;
+  const float scale = size_px / font.atlas_px_height;
+  float line = 0, widest = 0;
+  while (s < e) {
+    unsigned int c = 0;
+    s += ImTextCharFromUtf8(&c, s, e);
+    if (c == '\n') { widest = ImMax(widest, line); line = 0; continue; }
+    if (c == '\r') continue;
+    if (const FontGlyph* g = font.resolve(c).g) line += g->advance * scale;
+  }
+  return ImMax(widest, line);
+}
+
+static void add_text(ImDrawList* bg, const HostFont& font, ImFont* f, float size_px, ImVec2 pos,
+                     ImU32 col, const char* s, const char* e) {
+  if (!font.dynamic) { bg->AddText(f, size_px, pos, col, s, e); return; }
+  const float scale = size_px / font.atlas_px_height;
+  const ImTextureID atlas_tex = f->ContainerAtlas->TexID;
+  const float ox = std::floor(pos.x);
+  float cx = ox, cy = std::floor(pos.y);
+  while (s < e) {
+    unsigned int c = 0;
+    s += ImTextCharFromUtf8(&c, s, e);
+    if (c == '\n') { cx = ox; cy += size_px; continue; }
+    if (c == '\r') continue;
+    const GlyphRef r = font.resolve(c);
+    const FontGlyph* g = r.g;
+    if (!g) continue;
+    if (g->x1 > g->x0) {
+      const ImTextureID tex = r.page < 0 ? atlas_tex
+                                         : (ImTextureID)(intptr_t)font.dynamic->gl_texture(r.page);
+      bg->AddImage(tex, ImVec2(cx + g->x0 * scale, cy + g->y0 * scale),
+                   ImVec2(cx + g->x1 * scale, cy + g->y1 * scale),
+                   ImVec2(g->u0, g->v0), ImVec2(g->u1, g->v1), col);
+    }
+    cx += g->advance * scale;
+  }
+}
+
 void render_drawlist_v1(const GPI_DrawListV1* dl){
+  GPI_ZONE("render_drawlist_v1");
   if (!dl || dl->magic!=GPI_DL_MAGIC) return;
   if (ImGui::GetCurrentContext() == nullptr) return; // Safety check
   ImDrawList* bg = ImGui::GetBackgroundDrawList();
@@ -19,6 +69,7 @@ void render_drawlist_v1(const GPI_DrawListV1* dl){
 }
 
 void render_drawlist_v15(const GPI_DrawListV15* dl, const HostFont& font) {
+  GPI_ZONE("render_drawlist_v15");
   if (!dl || dl->magic != GPI_DL15_MAGIC) return;
   if (ImGui::GetCurrentContext() == nullptr) return; // Safety check
   ImDrawList* bg = ImGui::GetBackgroundDrawList();
@@ -48,11 +99,61 @@ void render_drawlist_v15(const GPI_DrawListV15* dl, const HostFont& font) {
     // alignment: pre-measure width in pixels
     const char* s = utf8 + tr.utf8_off;
     const char* e = s + tr.utf8_len;
-    ImVec2 sz = ifont->CalcTextSizeA(tr.size_px, FLT_MAX, 0.0f, s, e);
+    if (tr.align != GPI_TALIGN_LEFT) {
+      const float w = text_width(font, ifont, tr.size_px, s, e);
+      pos.x -= (tr.align == GPI_TALIGN_CENTER) ? w * 0.5f : w;
+    }
 
-    if (tr.align == GPI_TALIGN_CENTER) pos.x -= sz.x * 0.5f;
-    else if (tr.align == GPI_TALIGN_RIGHT) pos.x -= sz.x;
+    add_text(bg, font, ifont, tr.size_px, pos, to_col(tr.rgba), s, e);
+  }
+}
 
-    bg->AddText(ifont, tr.size_px, pos, to_col(tr.rgba), s, e);
+namespace {
+struct ImGuiDl2Sink final : Dl2Sink {
+  ImDrawList* bg;
+  const HostFont& hfont;
+  ImFont* font;
+  ImageStore& images;
+  ImGuiDl2Sink(ImDrawList* d, const HostFont& hf, ImageStore& im)
+    : bg(d), hfont(hf), font((ImFont*)hf.imgui_font), images(im) {}
+
+  void rect(float x, float y, float w, float h, float rounding, uint32_t rgba) override {
+    bg->AddRectFilled(ImVec2(x, y), ImVec2(x + w, y + h), to_col(rgba), rounding);
+  }
+  void line(float x0, float y0, float x1, float y1, float t, uint32_t rgba) override {
+    bg->AddLine(ImVec2(x0, y0), ImVec2(x1, y1), to_col(rgba), t);
+  }
+  void circle(float cx, float cy, float r, uint32_t rgba) override {
+    bg->AddCircleFilled(ImVec2(cx, cy), r, to_col(rgba));
+  }
+  void sprite(float x, float y, float w, float h, float u0, float v0, float u1, float v1,
+              GPI_ImageHandle image, uint32_t tint) override {
+    const unsigned tex = images.gl_texture(image);
+    if (!tex) return;
+    bg->AddImage((ImTextureID)(intptr_t)tex, ImVec2(x, y), ImVec2(x + w, y + h),
+                 ImVec2(u0, v0), ImVec2(u1, v1), to_col(tint));
   }
+  void text(float x, float y, float size_px, uint32_t align, uint32_t rgba, const char* s, const char* e) override {
+    if (!font) return;
+    if (align != GPI_TALIGN_LEFT) {
+      const float w = text_width(hfont, font, size_px, s, e);
+      x -= (align == GPI_TALIGN_CENTER) ? w * 0.5f : w;
+    }
+    add_text(bg, hfont, font, size_px, ImVec2(x, y), to_col(rgba), s, e);
+  }
+  void push_clip(float x0, float y0, float x1, float y1) override {
+    bg->PushClipRect(ImVec2(x0, y0), ImVec2(x1, y1), true);
+  }
+  void pop_clip() override { bg->PopClipRect(); }
+};
+} // namespace
+
+Dl2Error render_drawlist_v2(const GPI_DrawListV2* dl, uint32_t bytes, const HostFont& font, ImageStore& images) {
+  GPI_ZONE("render_drawlist_v2");
+  if (ImGui::GetCurrentContext() == nullptr) return Dl2Error::None;
+  if (!dl || dl->size == 0) return Dl2Error::None;
+  const Dl2Error err = dl2_decode(dl, bytes, nullptr);
+  if (err != Dl2Error::None) return err;
+  ImGuiDl2Sink sink(ImGui::GetBackgroundDrawList(), font, images);
+  return dl2_decode(dl, bytes, &sink);
 }
@@ -2,6 +2,17 @@
 extern "C" { 
 #include "../../include/gpi/gpi_plugin.h" 
 }
+#include "drawlist_v2.h"
 struct HostFont;
+class SoftRaster;
+class ImageStore;
 void render_drawlist_v1(const GPI_DrawListV1* dl);
 void render_drawlist_v15(const GPI_DrawListV15* dl, const HostFont& font);
+// Validates the whole stream first; an invalid list draws nothing.
+Dl2Error render_drawlist_v2(const GPI_DrawListV2* dl, uint32_t bytes, const HostFont& font, ImageStore& images);
+
+// Same translation into the CPU rasterizer (headless / goldens).
+void render_drawlist_v1_soft(const GPI_DrawListV1* dl, SoftRaster& out);
+void render_drawlist_v15_soft(const GPI_DrawListV15* dl, const HostFont& font, SoftRaster& out);
+Dl2Error render_drawlist_v2_soft(const GPI_DrawListV2* dl, uint32_t bytes, const HostFont& font,
+                                 const ImageStore& images, SoftRaster& out);
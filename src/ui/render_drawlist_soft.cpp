@@ -0,0 +1,100 @@
+#include "render_drawlist.h"
+#include "font_atlas.h"
+#include "soft_raster.h"
+#include "image_store.h"
+#include "../services/zones.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Rounding used by the ImGui path for every quad.
+static constexpr float kQuadRounding = 4.0f;
+
+void render_drawlist_v1_soft(const GPI_DrawListV1* dl, SoftRaster& out) {
+  GPI_ZONE("render_drawlist_v1_soft");
+  if (!dl || dl->magic != GPI_DL_MAGIC) return;
+  const uint32_t n = (dl->quad_count <= dl->max_quads) ? dl->quad_count : dl->max_quads;
+  for (uint32_t i=0;i<n;++i) {
+    const auto& q = dl->quads[i];
+    out.fill_rect(q.x, q.y, q.w, q.h, q.rgba, kQuadRounding);
+  }
+}
+
+void render_drawlist_v15_soft(const GPI_DrawListV15* dl, const HostFont& font, SoftRaster& out) {
+  GPI_ZONE("render_drawlist_v15_soft");
+  if (!dl || dl->magic != GPI_DL15_MAGIC) return;
+
+  /* --- quads --- */
+  const uint32_t nq = (dl->quad_count <= dl->max_quads) ? dl->quad_count : dl->max_quads;
+  auto* quads = (const GPI_QuadV1*)((const uint8_t*)dl + sizeof(GPI_DrawListV15));
+  for (uint32_t i=0; i<nq; ++i) {
+    const auto& q = quads[i];
+    out.fill_rect(q.x, q.y, q.w, q.h, q.rgba, kQuadRounding);
+  }
+
+  /* --- text --- */
+  auto* runs = (const GPI_TextRunV15*)((const uint8_t*)quads + dl->max_quads*sizeof(GPI_QuadV1));
+  auto* utf8 = (const char*)((const uint8_t*)runs + dl->max_text*sizeof(GPI_TextRunV15));
+  const uint32_t nt = (dl->text_count <= dl->max_text) ? dl->text_count : dl->max_text;
+
+  for (uint32_t i=0; i<nt; ++i) {
+    const auto& tr = runs[i];
+    if (tr.utf8_off + tr.utf8_len > dl->utf8_capacity) continue;
+    const char* s = utf8 + tr.utf8_off;
+    const char* e = s + tr.utf8_len;
+    float x = tr.x;
+    if (tr.align == GPI_TALIGN_CENTER) x -= out.measure_text(font, tr.size_px, s, e) * 0.5f;
+    else if (tr.align == GPI_TALIGN_RIGHT) x -= out.measure_text(font, tr.size_px, s, e);
+    out.draw_text(font, x, tr.y, tr.size_px, tr.rgba, s, e);
+  }
+}
+
+namespace {
+struct SoftDl2Sink final : Dl2Sink {
+  const HostFont& font;
+  const ImageStore& images;
+  SoftRaster& out;
+  struct Clip { float x0, y0, x1, y1; };
+  std::vector<Clip> clips;
+  SoftDl2Sink(const HostFont& f, const ImageStore& im, SoftRaster& o) : font(f), images(im), out(o) {}
+
+  void rect(float x, float y, float w, float h, float rounding, uint32_t rgba) override {
+    out.fill_rect(x, y, w, h, rgba, rounding);
+  }
+  void line(float x0, float y0, float x1, float y1, float t, uint32_t rgba) override {
+    out.draw_line(x0, y0, x1, y1, t, rgba);
+  }
+  void circle(float cx, float cy, float r, uint32_t rgba) override { out.fill_circle(cx, cy, r, rgba); }
+  void sprite(float x, float y, float w, float h, float u0, float v0, float u1, float v1,
+              GPI_ImageHandle image, uint32_t tint) override {
+    if (const HostImage* im = images.get(image))
+      out.draw_image(x, y, w, h, u0, v0, u1, v1, im->rgba.data(), im->w, im->h, tint);
+  }
+  void text(float x, float y, float size_px, uint32_t align, uint32_t rgba, const char* s, const char* e) override {
+    if (align == GPI_TALIGN_CENTER) x -= out.measure_text(font, size_px, s, e) * 0.5f;
+    else if (align == GPI_TALIGN_RIGHT) x -= out.measure_text(font, size_px, s, e);
+    out.draw_text(font, x, y, size_px, rgba, s, e);
+  }
+  // Same truncation the ImGui GL backend applies to scissor rects.
+  void apply() {
+    if (clips.empty()) { out.reset_clip(); return; }
+    const auto& c = clips.back();
+    out.set_clip((int)c.x0, (int)c.y0, (int)c.x1, (int)c.y1);
+  }
+  void push_clip(float x0, float y0, float x1, float y1) override {
+    clips.push_back({std::max(x0, 0.0f), std::max(y0, 0.0f), x1, y1});
+    apply();
+  }
+  void pop_clip() override { if (!clips.empty()) clips.pop_back(); apply(); }
+};
+} // namespace
+
+Dl2Error render_drawlist_v2_soft(const GPI_DrawListV2* dl, uint32_t bytes, const HostFont& font,
+                                 const ImageStore& images, SoftRaster& out) {
+  GPI_ZONE("render_drawlist_v2_soft");
+  if (!dl || dl->size == 0) return Dl2Error::None;
+  const Dl2Error err = dl2_decode(dl, bytes, nullptr);
+  if (err != Dl2Error::None) return err;
+  SoftDl2Sink sink(font, images, out);
+  return dl2_decode(dl, bytes, &sink);
+}
@@ -0,0 +1,348 @@
+#include "soft_raster.h"
+#include "font_atlas.h"
+#include "glyph_cache.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+  #include <emmintrin.h>
+  #define GPI_SOFT_SSE2 1
+#endif
+
+namespace {
+
+// Exact round(t / 255) for t <= 65025; the SIMD path uses the same formula.
+inline uint32_t div255(uint32_t t) { t += 128; return (t + (t >> 8)) >> 8; }
+
+// src-over with effective alpha `a` (GL: SRC_ALPHA, ONE_MINUS_SRC_ALPHA / ONE, ONE_MINUS_SRC_ALPHA).
+inline uint32_t blend_px(uint32_t dst, uint32_t src, uint32_t a) {
+  if (a == 0) return dst;
+  if (a == 255) return (src & 0x00FFFFFFu) | 0xFF000000u;
+  const uint32_t ia = 255 - a;
+  uint32_t r = div255(( src        & 0xFF) * a + ( dst        & 0xFF) * ia);
+  uint32_t g = div255(((src >>  8) & 0xFF) * a + ((dst >>  8) & 0xFF) * ia);
+  uint32_t b = div255(((src >> 16) & 0xFF) * a + ((dst >> 16) & 0xFF) * ia);
+  uint32_t o = div255(255u * a                 + ((dst >> 24) & 0xFF) * ia);
+  return r | (g << 8) | (b << 16) | (o << 24);
+}
+
+// Constant-colour span: the interior of every rect, so this is where the time goes.
+void blend_span(uint32_t* d, int n, uint32_t src, uint32_t a) {
+  if (n <= 0 || a == 0) return;
+  if (a == 255) { std::fill_n(d, n, (src & 0x00FFFFFFu) | 0xFF000000u); return; }
+  int i = 0;
+#if defined(GPI_SOFT_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const uint32_t s = (src & 0x00FFFFFFu) | 0xFF000000u;  // alpha lane blends towards 255
+  const __m128i sa   = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32((int)s), zero),
+                                       _mm_set1_epi16((short)a));
+  const __m128i ia   = _mm_set1_epi16((short)(255 - a));
+  const __m128i c128 = _mm_set1_epi16(128);
+  for (; i + 4 <= n; i += 4) {
+    __m128i dv = _mm_loadu_si128((const __m128i*)(d + i));
+    __m128i lo = _mm_unpacklo_epi8(dv, zero);
+    __m128i hi = _mm_unpackhi_epi8(dv, zero);
+    lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, ia), sa), c128);
+    hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, ia), sa), c128);
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+    _mm_storeu_si128((__m128i*)(d + i), _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (; i < n; ++i) d[i] = blend_px(d[i], src, a);
+}
+
+inline uint32_t scale_alpha(uint32_t rgba, float cov) {
+  return (uint32_t)std::lround((float)(rgba >> 24) * cov);
+}
+
+float sd_round_rect(float px, float py, float cx, float cy, float hx, float hy, float r) {
+  const float qx = std::fabs(px - cx) - (hx - r);
+  const float qy = std::fabs(py - cy) - (hy - r);
+  const float ox = std::max(qx, 0.0f), oy = std::max(qy, 0.0f);
+  return std::sqrt(ox * ox + oy * oy) + std::min(std::max(qx, qy), 0.0f) - r;
+}
+
+// Bilinear, clamp-to-edge, texel centres at +0.5 (GL_LINEAR semantics).
+inline void sample_bilinear(const uint8_t* tex, int tw, int th, int comps, float u, float v, float out[4]) {
+  float fx = u * tw - 0.5f, fy = v * th - 0.5f;
+  int x0 = (int)std::floor(fx), y0 = (int)std::floor(fy);
+  float ax = fx - x0, ay = fy - y0;
+  int x1 = std::clamp(x0 + 1, 0, tw - 1), y1 = std::clamp(y0 + 1, 0, th - 1);
+  x0 = std::clamp(x0, 0, tw - 1); y0 = std::clamp(y0, 0, th - 1);
+  const uint8_t* p00 = tex + ((size_t)y0 * tw + x0) * comps;
+  const uint8_t* p10 = tex + ((size_t)y0 * tw + x1) * comps;
+  const uint8_t* p01 = tex + ((size_t)y1 * tw + x0) * comps;
+  const uint8_t* p11 = tex + ((size_t)y1 * tw + x1) * comps;
+  for (int c = 0; c < comps; ++c) {
+    float top = p00[c] + (p10[c] - p00[c]) * ax;
+    float bot = p01[c] + (p11[c] - p01[c]) * ax;
+    out[c] = top + (bot - top) * ay;
+  }
+}
+
+uint32_t decode_utf8(const char*& s, const char* e) {
+  const auto* p = (const unsigned char*)s;
+  uint32_t c = *p;
+  int n = (c < 0x80) ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 1;
+  if (s + n > e) { s = e; return 0xFFFD; }
+  if (n == 2) c = ((c & 0x1F) << 6) | (p[1] & 0x3F);
+  else if (n == 3) c = ((c & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+  else if (n == 4) c = ((c & 0x07) << 18) | ((p[1] & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+  s += n;
+  return c;
+}
+
+// Pixel-centre coverage range for [a, b): GL/ImGui top-left fill rule.
+inline int px_lo(float a) { return (int)std::ceil(a - 0.5f); }
+
+} // namespace
+
+SoftRaster::SoftRaster(unsigned threads) : pool_(threads) {}
+
+void SoftRaster::begin(int w, int h, uint32_t clear_rgba) {
+  w_ = std::max(0, w); h_ = std::max(0, h);
+  tiles_x_ = (w_ + kTile - 1) / kTile;
+  tiles_y_ = (h_ + kTile - 1) / kTile;
+  clear_ = clear_rgba;
+  px_.resize((size_t)w_ * h_);
+  cmds_.clear();
+  bins_.resize((size_t)tiles_x_ * tiles_y_);
+  for (auto& b : bins_) b.clear();
+  reset_clip();
+}
+
+void SoftRaster::set_clip(int x0, int y0, int x1, int y1) {
+  clip_[0] = std::clamp(x0, 0, w_); clip_[1] = std::clamp(y0, 0, h_);
+  clip_[2] = std::clamp(x1, 0, w_); clip_[3] = std::clamp(y1, 0, h_);
+}
+
+void SoftRaster::reset_clip() { set_clip(0, 0, w_, h_); }
+
+void SoftRaster::push(Cmd c) {
+  c.bx0 = std::max(c.bx0, clip_[0]); c.by0 = std::max(c.by0, clip_[1]);
+  c.bx1 = std::min(c.bx1, clip_[2]); c.by1 = std::min(c.by1, clip_[3]);
+  if (c.bx0 >= c.bx1 || c.by0 >= c.by1) return;
+  const uint32_t idx = (uint32_t)cmds_.size();
+  cmds_.push_back(c);
+  const int tx1 = (c.bx1 - 1) / kTile, ty1 = (c.by1 - 1) / kTile;
+  for (int ty = c.by0 / kTile; ty <= ty1; ++ty)
+    for (int tx = c.bx0 / kTile; tx <= tx1; ++tx)
+      bins_[(size_t)ty * tiles_x_ + tx].push_back(idx);
+}
+
+void SoftRaster::fill_rect(float x, float y, float w, float h, uint32_t rgba, float rounding) {
+  if (w <= 0 || h <= 0 || (rgba >> 24) == 0) return;
+  Cmd c{};
+  c.x0 = x; c.y0 = y; c.x1 = x + w; c.y1 = y + h; c.rgba = rgba;
+  // Same clamp as ImDrawList::AddRectFilled; below 0.5 ImGui emits a non-AA rect.
+  c.radius = std::min(rounding, std::min(w, h) * 0.5f - 1.0f);
+  if (c.radius >= 0.5f) {
+    c.kind = K_RRECT;
+    c.bx0 = (int)std::floor(c.x0 - 0.5f); c.by0 = (int)std::floor(c.y0 - 0.5f);
+    c.bx1 = (int)std::ceil(c.x1 + 0.5f);  c.by1 = (int)std::ceil(c.y1 + 0.5f);
+  } else {
+    c.kind = K_RECT;
+    c.bx0 = px_lo(c.x0); c.by0 = px_lo(c.y0); c.bx1 = px_lo(c.x1); c.by1 = px_lo(c.y1);
+  }
+  push(c);
+}
+
+void SoftRaster::fill_circle(float cx, float cy, float r, uint32_t rgba) {
+  if (r <= 0 || (rgba >> 24) == 0) return;
+  Cmd c{};
+  c.kind = K_CIRCLE;
+  c.x0 = cx; c.y0 = cy; c.radius = r; c.rgba = rgba;
+  c.bx0 = (int)std::floor(cx - r - 0.5f); c.by0 = (int)std::floor(cy - r - 0.5f);
+  c.bx1 = (int)std::ceil(cx + r + 0.5f);  c.by1 = (int)std::ceil(cy + r + 0.5f);
+  push(c);
+}
+
+void SoftRaster::draw_line(float x0, float y0, float x1, float y1, float thickness, uint32_t rgba) {
+  if (thickness <= 0 || (rgba >> 24) == 0) return;
+  Cmd c{};
+  c.kind = K_LINE;
+  c.x0 = x0; c.y0 = y0; c.x1 = x1; c.y1 = y1; c.radius = thickness * 0.5f; c.rgba = rgba;
+  const float pad = c.radius + 1.0f;
+  c.bx0 = (int)std::floor(std::min(x0, x1) - pad); c.by0 = (int)std::floor(std::min(y0, y1) - pad);
+  c.bx1 = (int)std::ceil(std::max(x0, x1) + pad);  c.by1 = (int)std::ceil(std::max(y0, y1) + pad);
+  push(c);
+}
+
+void SoftRaster::draw_image(float x, float y, float w, float h, float u0, float v0, float u1, float v1,
+                            const uint8_t* rgba, int iw, int ih, uint32_t tint) {
+  if (!rgba || iw <= 0 || ih <= 0 || w <= 0 || h <= 0 || (tint >> 24) == 0) return;
+  Cmd c{};
+  c.kind = K_TEX_RGBA;
+  c.x0 = x; c.y0 = y; c.x1 = x + w; c.y1 = y + h; c.rgba = tint;
+  c.u0 = u0; c.v0 = v0; c.u1 = u1; c.v1 = v1; c.tex = rgba; c.tw = iw; c.th = ih;
+  c.bx0 = px_lo(c.x0); c.by0 = px_lo(c.y0); c.bx1 = px_lo(c.x1); c.by1 = px_lo(c.y1);
+  push(c);
+}
+
+float SoftRaster::measure_text(const HostFont& font, float size_px, const char* s, const char* e) const {
+  if (font.atlas_px_height <= 0) return 0.0f;
+  const float scale = size_px / font.atlas_px_height;
+  float line = 0, widest = 0;
+  while (s < e) {
+    uint32_t cp = decode_utf8(s, e);
+    if (cp == '\n') { widest = std::max(widest, line); line = 0; continue; }
+    if (cp == '\r') continue;
+    if (const FontGlyph* g = font.resolve(cp).g) line += g->advance * scale;
+  }
+  return std::max(widest, line);
+}
+
+void SoftRaster::draw_text(const HostFont& font, float x, float y, float size_px, uint32_t rgba,
+                           const char* s, const char* e) {
+  if (font.atlas_alpha.empty() || font.atlas_px_height <= 0 || (rgba >> 24) == 0) return;
+  const float scale = size_px / font.atlas_px_height;
+  // ImFont::RenderText snaps the origin to whole pixels.
+  const float ox = std::floor(x);
+  float cx = ox, cy = std::floor(y);
+  while (s < e) {
+    uint32_t cp = decode_utf8(s, e);
+    if (cp == '\n') { cx = ox; cy += size_px; continue; }
+    if (cp == '\r') continue;
+    const GlyphRef ref = font.resolve(cp);
+    const FontGlyph* g = ref.g;
+    if (!g) continue;
+    if (g->x1 > g->x0) {
+      Cmd c{};
+      c.kind = K_TEX_A8;
+      c.x0 = cx + g->x0 * scale; c.y0 = cy + g->y0 * scale;
+      c.x1 = cx + g->x1 * scale; c.y1 = cy + g->y1 * scale;
+      c.rgba = rgba;
+      c.u0 = g->u0; c.v0 = g->v0; c.u1 = g->u1; c.v1 = g->v1;
+      if (ref.page < 0) { c.tex = font.atlas_alpha.data(); c.tw = font.atlas_w; c.th = font.atlas_h; }
+      else {
+        c.tex = font.dynamic->page_pixels(ref.page);
+        c.tw = c.th = GlyphCache::kPageSize;
+      }
+      c.bx0 = px_lo(c.x0); c.by0 = px_lo(c.y0); c.bx1 = px_lo(c.x1); c.by1 = px_lo(c.y1);
+      push(c);
+    }
+    cx += g->advance * scale;
+  }
+}
+
+void SoftRaster::end() {
+  pool_.parallel_for(tiles_x_ * tiles_y_, [this](int t){ raster_tile(t); });
+}
+
+void SoftRaster::raster_tile(int t) {
+  const int tx0 = (t % tiles_x_) * kTile, ty0 = (t / tiles_x_) * kTile;
+  const int tx1 = std::min(tx0 + kTile, w_), ty1 = std::min(ty0 + kTile, h_);
+  for (int y = ty0; y < ty1; ++y) std::fill(&px_[(size_t)y * w_ + tx0], &px_[(size_t)y * w_ + tx1], clear_);
+
+  for (uint32_t ci : bins_[t]) {
+    const Cmd& c = cmds_[ci];
+    const int x0 = std::max(c.bx0, tx0), x1 = std::min(c.bx1, tx1);
+    const int y0 = std::max(c.by0, ty0), y1 = std::min(c.by1, ty1);
+    if (x0 >= x1 || y0 >= y1) continue;
+    const uint32_t a = c.rgba >> 24;
+
+    switch (c.kind) {
+      case K_RECT:
+        for (int y = y0; y < y1; ++y) blend_span(&px_[(size_t)y * w_ + x0], x1 - x0, c.rgba, a);
+        break;
+
+      case K_RRECT: {
+        const float cx = (c.x0 + c.x1) * 0.5f, cy = (c.y0 + c.y1) * 0.5f;
+        const float hx = (c.x1 - c.x0) * 0.5f, hy = (c.y1 - c.y0) * 0.5f, r = c.radius;
+        const float ro = r + 0.5f, ri = r - 0.5f;
+        for (int y = y0; y < y1; ++y) {
+          uint32_t* row = &px_[(size_t)y * w_];
+          const float qy = std::fabs(y + 0.5f - cy) - (hy - r);
+          if (qy >= ro) continue;
+          // Fully covered interior (d <= -0.5) goes through the span filler; only the
+          // AA fringe is evaluated per pixel.
+          int in_lo = x1, in_hi = x1;
+          if (qy <= ri) {
+            const float ix = (qy <= 0.0f) ? hx - 0.5f : (hx - r) + std::sqrt(ri * ri - qy * qy);
+            in_lo = std::max(x0, px_lo(cx - ix));
+            in_hi = std::min(x1, (int)std::floor(cx + ix - 0.5f) + 1);
+            if (in_lo >= in_hi) in_lo = in_hi = x1;
+          }
+          for (int x = x0; x < x1; ++x) {
+            if (x == in_lo) { blend_span(row + in_lo, in_hi - in_lo, c.rgba, a); x = in_hi - 1; continue; }
+            const float d = sd_round_rect(x + 0.5f, y + 0.5f, cx, cy, hx, hy, r);
+            const float cov = std::clamp(0.5f - d, 0.0f, 1.0f);
+            if (cov > 0.0f) row[x] = blend_px(row[x], c.rgba, scale_alpha(c.rgba, cov));
+          }
+        }
+        break;
+      }
+
+      case K_CIRCLE: {
+        const float r = c.radius, ri = r - 0.5f, ro = r + 0.5f;
+        for (int y = y0; y < y1; ++y) {
+          uint32_t* row = &px_[(size_t)y * w_];
+          const float dy = y + 0.5f - c.y0;
+          if (std::fabs(dy) >= ro) continue;
+          int in_lo = x1, in_hi = x1;
+          if (ri > 0.0f && std::fabs(dy) < ri) {
+            const float ix = std::sqrt(ri * ri - dy * dy);
+            in_lo = std::max(x0, px_lo(c.x0 - ix));
+            in_hi = std::min(x1, (int)std::floor(c.x0 + ix - 0.5f) + 1);
+            if (in_lo >= in_hi) in_lo = in_hi = x1;
+          }
+          for (int x = x0; x < x1; ++x) {
+            if (x == in_lo) { blend_span(row + in_lo, in_hi - in_lo, c.rgba, a); x = in_hi - 1; continue; }
+            const float dx = x + 0.5f - c.x0;
+            const float cov = std::clamp(ro - std::sqrt(dx * dx + dy * dy), 0.0f, 1.0f);
+            if (cov > 0.0f) row[x] = blend_px(row[x], c.rgba, scale_alpha(c.rgba, cov));
+          }
+        }
+        break;
+      }
+
+      case K_LINE: {
+        // Oriented-box SDF around the segment (butt caps, like ImGui's AA lines).
+        const float ex = c.x1 - c.x0, ey = c.y1 - c.y0;
+        const float len = std::sqrt(ex * ex + ey * ey);
+        const float ux = len > 0 ? ex / len : 1.0f, uy = len > 0 ? ey / len : 0.0f;
+        const float mx = (c.x0 + c.x1) * 0.5f, my = (c.y0 + c.y1) * 0.5f, hl = len * 0.5f;
+        for (int y = y0; y < y1; ++y) {
+          uint32_t* row = &px_[(size_t)y * w_];
+          const float py = y + 0.5f - my;
+          for (int x = x0; x < x1; ++x) {
+            const float px = x + 0.5f - mx;
+            const float qx = std::fabs(px * ux + py * uy) - hl;
+            const float qy = std::fabs(py * ux - px * uy) - c.radius;
+            const float ox = std::max(qx, 0.0f), oy = std::max(qy, 0.0f);
+            const float d = std::sqrt(ox * ox + oy * oy) + std::min(std::max(qx, qy), 0.0f);
+            const float cov = std::clamp(0.5f - d, 0.0f, 1.0f);
+            if (cov > 0.0f) row[x] = blend_px(row[x], c.rgba, scale_alpha(c.rgba, cov));
+          }
+        }
+        break;
+      }
+
+      case K_TEX_A8:
+      case K_TEX_RGBA: {
+        const int comps = (c.kind == K_TEX_A8) ? 1 : 4;
+        const float du = (c.u1 - c.u0) / (c.x1 - c.x0), dv = (c.v1 - c.v0) / (c.y1 - c.y0);
+        for (int y = y0; y < y1; ++y) {
+          uint32_t* row = &px_[(size_t)y * w_];
+          const float v = c.v0 + (y + 0.5f - c.y0) * dv;
+          for (int x = x0; x < x1; ++x) {
+            const float u = c.u0 + (x + 0.5f - c.x0) * du;
+            float s[4];
+            sample_bilinear(c.tex, c.tw, c.th, comps, u, v, s);
+            if (comps == 1) {
+              row[x] = blend_px(row[x], c.rgba, (uint32_t)std::lround(s[0] * a / 255.0f));
+            } else {
+              uint32_t sr = div255((uint32_t)std::lround(s[0]) * ( c.rgba        & 0xFF));
+              uint32_t sg = div255((uint32_t)std::lround(s[1]) * ((c.rgba >>  8) & 0xFF));
+              uint32_t sb = div255((uint32_t)std::lround(s[2]) * ((c.rgba >> 16) & 0xFF));
+              uint32_t sa = div255((uint32_t)std::lround(s[3]) * a);
+              row[x] = blend_px(row[x], sr | (sg << 8) | (sb << 16), sa);
+            }
+          }
+        }
+        break;
+      }
+    }
+  }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "../platform/thread_pool.h"
+
+struct HostFont;
+
+// CPU rasterizer for the plugin draw lists. Commands are queued between
+// begin()/end(), binned into 64x64 tiles and rasterized in parallel.
+// Output matches the ImGui/GL path (AA rounded rects, bilinear glyphs,
+// src-over blending) closely enough for golden comparisons.
+//
+// Pixels are RGBA8 in memory order (0xAABBGGRR as uint32 on little endian),
+// rows top-down, same packing as GPI colors.
+class SoftRaster {
+public:
+  static constexpr int kTile = 64;
+
+  explicit SoftRaster(unsigned threads = 0);
+
+  void begin(int w, int h, uint32_t clear_rgba);
+  void end();
+
+  // Scissor applied to subsequently queued commands (pixel coords, exclusive max).
+  void set_clip(int x0, int y0, int x1, int y1);
+  void reset_clip();
+
+  void fill_rect(float x, float y, float w, float h, uint32_t rgba, float rounding = 0.0f);
+  // AA filled circle and butt-capped line (ImDrawList::AddCircleFilled / AddLine).
+  void fill_circle(float cx, float cy, float r, uint32_t rgba);
+  void draw_line(float x0, float y0, float x1, float y1, float thickness, uint32_t rgba);
+  // Text at top-left `x,y` scaled to size_px, like ImDrawList::AddText.
+  void draw_text(const HostFont& font, float x, float y, float size_px, uint32_t rgba,
+                 const char* s, const char* e);
+  float measure_text(const HostFont& font, float size_px, const char* s, const char* e) const;
+  // Bilinear-sampled RGBA8 image, tinted.
+  void draw_image(float x, float y, float w, float h, float u0, float v0, float u1, float v1,
+                  const uint8_t* rgba, int iw, int ih, uint32_t tint);
+
+  int width() const { return w_; }
+  int height() const { return h_; }
+  const uint32_t* pixels() const { return px_.data(); }
+  std::size_t command_count() const { return cmds_.size(); }
+
+private:
+  enum Kind : uint8_t { K_RECT, K_RRECT, K_CIRCLE, K_LINE, K_TEX_A8, K_TEX_RGBA };
+  struct Cmd {
+    Kind kind;
+    float x0, y0, x1, y1;       // geometry, pixel space (K_LINE: endpoints)
+    float radius;               // K_LINE: half thickness
+    uint32_t rgba;
+    int bx0, by0, bx1, by1;     // integer bounds, already clipped
+    float u0, v0, u1, v1;
+    const uint8_t* tex;
+    int tw, th;
+  };
+
+  void push(Cmd c);
+  void raster_tile(int tile_idx);
+
+  int w_ = 0, h_ = 0;
+  int tiles_x_ = 0, tiles_y_ = 0;
+  uint32_t clear_ = 0;
+  int clip_[4] = {0, 0, 0, 0};
+  std::vector<uint32_t> px_;
+  std::vector<Cmd> cmds_;
+  std::vector<std::vector<uint32_t>> bins_;
+  ThreadPool pool_;
+};
@@ -0,0 +1,91 @@
+#include "zone_view.h"
+#include "../services/zones.h"
+#include <imgui.h>
+#if GPI_ZONES
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+static ImU32 zone_color(const char* name) {
+  uint32_t h = 2166136261u;
+  for (const char* p = name; *p; ++p) h = (h ^ (uint8_t)*p) * 16777619u;
+  return ImColor::HSV((h % 360) / 360.0f, 0.45f, 0.80f);
+}
+
+// Threads stacked top to bottom, depth 0 on top; x is the frame's tick span
+static void icicle(const char* id, const gpi::ZoneProfiler& p, const gpi::ZoneFrame& f) {
+  const float row = ImGui::GetTextLineHeight() + 2.0f;
+  const float gutter = 90.0f;
+  std::vector<uint16_t> threads;
+  std::vector<int> rows;   // per band: max depth + 1
+  for (const auto& z : f.zones) {
+    if (threads.empty() || threads.back() != z.thread) { threads.push_back(z.thread); rows.push_back(1); }
+    rows.back() = std::max<int>(rows.back(), z.depth + 1);
+  }
+  if (threads.empty()) { ImGui::TextDisabled("no zones"); return; }
+  int total = 0;
+  for (int r : rows) total += r;
+
+  const ImVec2 o = ImGui::GetCursorScreenPos();
+  const float w = std::max(ImGui::GetContentRegionAvail().x, gutter + 50.0f);
+  const ImVec2 size(w, total * row + (threads.size() - 1) * 4.0f);
+  ImGui::InvisibleButton(id, size);
+  const bool hovered = ImGui::IsItemHovered();
+  const ImVec2 mouse = ImGui::GetMousePos();
+  ImDrawList* dl = ImGui::GetWindowDrawList();
+  dl->PushClipRect(o, ImVec2(o.x + size.x, o.y + size.y), true);
+
+  const double span = (double)std::max<uint64_t>(f.t1 - f.t0, 1);
+  const float plot = w - gutter;
+  auto x_at = [&](uint64_t t) {
+    const uint64_t c = std::clamp(t, f.t0, f.t1);
+    return o.x + gutter + (float)((double)(c - f.t0) / span) * plot;
+  };
+  const gpi::ZoneSample* hit = nullptr;
+  float band_y = o.y;
+  std::size_t band = 0;
+  for (std::size_t i = 0; i < f.zones.size(); ++i) {
+    const auto& z = f.zones[i];
+    if (z.thread != threads[band]) { band_y += rows[band] * row + 4.0f; ++band; }
+    if (i == 0 || f.zones[i - 1].thread != z.thread) {
+      const char* tn = p.thread_name(z.thread);
+      char buf[32];
+      if (!tn) { std::snprintf(buf, sizeof(buf), "thread %u", (unsigned)z.thread); tn = buf; }
+      dl->AddText(ImVec2(o.x, band_y + 1.0f), ImGui::GetColorU32(ImGuiCol_TextDisabled), tn);
+    }
+    const float x0 = x_at(z.t0);
+    const float x1 = std::max(x_at(z.t1), x0 + 1.0f);
+    const float y0 = band_y + z.depth * row;
+    const ImVec2 a(x0, y0), b(x1, y0 + row - 1.0f);
+    dl->AddRectFilled(a, b, zone_color(z.name));
+    const float tw = ImGui::CalcTextSize(z.name).x;
+    if (x1 - x0 > tw + 6.0f) dl->AddText(ImVec2(x0 + 3.0f, y0 + 1.0f), IM_COL32(20, 20, 20, 255), z.name);
+    if (hovered && mouse.x >= a.x && mouse.x < b.x && mouse.y >= a.y && mouse.y < b.y) hit = &z;
+  }
+  dl->PopClipRect();
+  if (hit) ImGui::SetTooltip("%s\n%.3f ms", hit->name, p.ms(hit->t1 - hit->t0));
+}
+#endif
+
+void ZoneView::draw() {
+  if (!open) return;
+  ImGui::SetNextWindowSize({720,360}, ImGuiCond_FirstUseEver);
+  if (ImGui::Begin("Zones", &open)) {
+#if GPI_ZONES
+    static gpi::ZoneFrame held_last, held_worst;
+    const auto& p = gpi::zones();
+    ImGui::Checkbox("Freeze", &freeze);
+    if (!freeze) { held_last = p.last(); held_worst = p.worst(); }
+    ImGui::SameLine();
+    ImGui::TextDisabled("%.3f ns/tick  %llu dropped", p.ns_per_tick(), (unsigned long long)p.dropped());
+    ImGui::Text("Last frame  %.2f ms", p.ms(held_last.t1 - held_last.t0));
+    icicle("##last", p, held_last);
+    ImGui::Separator();
+    ImGui::Text("Worst of last %d frames  %.2f ms", gpi::ZoneProfiler::kHistory, p.ms(held_worst.t1 - held_worst.t0));
+    icicle("##worst", p, held_worst);
+#else
+    ImGui::TextDisabled("Built without zones (configure with -DGPI_WITH_ZONES=ON)");
+#endif
+  }
+  ImGui::End();
+}
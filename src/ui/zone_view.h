@@ -0,0 +1,10 @@
+#pragma once
+
+// Icicle view of the GPI_ZONE timings: the frame that just ended and the
+// slowest frame still in the profiler's history, one band per thread.
+class ZoneView {
+public:
+  void draw();
+  bool open = false;
+  bool freeze = false;   // keep showing the captured pair
+};
@@ -0,0 +1,120 @@
+// gpi_artifacts: inspect, convert and merge .gpisession files.
+//
+//   gpi_artifacts info FILE...              sections, counts, checksum status
+//   gpi_artifacts convert FILE [OUT_BASE]   the -frames.csv / -summary.json /
+//                                           -telemetry*.csv|json text files
+//   gpi_artifacts merge OUT FILE...         one session on a shared timeline
+//   gpi_artifacts pack BASE [OUT]           text session (BASE-frames.csv,
+//                                           -summary.json, -telemetry.csv,
+//                                           -counters.csv if any) -> binary
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "services/session_file.h"
+
+namespace {
+
+int usage() {
+  std::fprintf(stderr,
+    "usage: gpi_artifacts info FILE...\n"
+    "       gpi_artifacts convert FILE [OUT_BASE]\n"
+    "       gpi_artifacts merge OUT FILE...\n"
+    "       gpi_artifacts pack BASE [OUT]\n");
+  return 2;
+}
+
+bool load(const std::string& path, session_file::Session& s) {
+  std::string err;
+  if (!session_file::read(path, s, &err)) {
+    std::fprintf(stderr, "%s: %s\n", path.c_str(), err.c_str());
+    return false;
+  }
+  if (!s.complete) std::fprintf(stderr, "%s: warning: truncated (no END section)\n", path.c_str());
+  if (s.bad_sections) std::fprintf(stderr, "%s: warning: %d damaged section(s) skipped\n", path.c_str(), s.bad_sections);
+  return true;
+}
+
+std::string strip_ext(const std::string& path) {
+  const auto dot = path.find_last_of('.');
+  const auto sep = path.find_last_of("/\\");
+  return (dot == std::string::npos || (sep != std::string::npos && dot < sep)) ? path : path.substr(0, dot);
+}
+
+int cmd_info(int argc, char** argv) {
+  int rc = 0;
+  for (int i = 0; i < argc; ++i) {
+    session_file::Session s;
+    if (!load(argv[i], s)) { rc = 1; continue; }
+    uint64_t points = 0, buckets = 0;
+    for (const auto& ser : s.series) { points += ser.t_us.size(); buckets += ser.r1.size() + ser.r10.size(); }
+    std::printf("%s\n  plugin %s  os %s  app %s  pacing %s @ %.0f fps\n", argv[i], s.info.plugin.c_str(),
+                s.info.os.c_str(), s.info.app_version.c_str(), s.info.pacing.c_str(), s.info.target_fps);
+    std::printf("  frames %zu  avg %.2f ms  p99 %.2f ms  max %.2f ms  dropped %.1f%%\n", s.frame_ms.size(),
+                s.summary.avg_ms, s.summary.p99_ms, s.summary.max_ms, s.summary.dropped_pct);
+    for (const auto* p : { &s.summary.proc_host, &s.summary.proc_child }) {
+      if (p->seconds <= 0) continue;
+      std::printf("  %s cpu avg %.1f%% max %.1f%%  rss %.1f MB  pss %.1f MB  faults %.0f/%.0f  ctxsw %.0f/%.0f\n",
+                  p == &s.summary.proc_host ? "host " : "child", p->cpu_avg_pct, p->cpu_max_pct,
+                  p->rss_peak_mb, p->pss_peak_mb, p->minflt, p->majflt, p->vcsw, p->ivcsw);
+    }
+    for (const auto& c : s.counters) {
+      std::printf("  %s %s: %llu calls  IPC %.2f", c.plugin.c_str(), c.phase.c_str(),
+                  (unsigned long long)c.calls, c.ipc());
+      for (int e : { kPerfL1dMisses, kPerfLlcMisses, kPerfBranchMisses })
+        if (c.has(e)) std::printf("  %s %.2f/ki", PerfCounters::name(e), c.mpki(e));
+      std::printf("\n");
+    }
+    std::printf("  telemetry %zu keys  %llu points  %llu rollup buckets\n", s.series.size(),
+                (unsigned long long)points, (unsigned long long)buckets);
+    std::printf("  %s, %d damaged section(s)\n", s.complete ? "complete" : "TRUNCATED", s.bad_sections);
+    if (!s.complete || s.bad_sections) rc = 1;
+  }
+  return rc;
+}
+
+int cmd_convert(int argc, char** argv) {
+  if (argc < 1) return usage();
+  session_file::Session s;
+  if (!load(argv[0], s)) return 1;
+  const std::string base = argc > 1 ? argv[1] : strip_ext(argv[0]);
+  const int64_t n = session_file::export_text(s, base);
+  if (n < 0) { std::fprintf(stderr, "convert: failed writing %s-*\n", base.c_str()); return 1; }
+  std::printf("%s-{frames.csv,summary.json,telemetry.csv,telemetry.json,telemetry-rollups.csv}: %lld bytes\n",
+              base.c_str(), (long long)n);
+  return 0;
+}
+
+int cmd_merge(int argc, char** argv) {
+  if (argc < 2) return usage();
+  std::vector<session_file::Session> in(argc - 1);
+  for (int i = 1; i < argc; ++i) if (!load(argv[i], in[i - 1])) return 1;
+  const int64_t n = session_file::write(argv[0], session_file::merge(in));
+  if (n < 0) { std::fprintf(stderr, "merge: failed writing %s\n", argv[0]); return 1; }
+  std::printf("%s: %d sessions, %lld bytes\n", argv[0], argc - 1, (long long)n);
+  return 0;
+}
+
+int cmd_pack(int argc, char** argv) {
+  if (argc < 1) return usage();
+  const std::string base = argv[0];
+  const std::string out = argc > 1 ? argv[1] : base + ".gpisession";
+  session_file::Session s;
+  std::string err;
+  if (!session_file::import_text(base, s, &err)) { std::fprintf(stderr, "pack: %s\n", err.c_str()); return 1; }
+  const int64_t n = session_file::write(out, s);
+  if (n < 0) { std::fprintf(stderr, "pack: failed writing %s\n", out.c_str()); return 1; }
+  std::printf("%s: %lld bytes\n", out.c_str(), (long long)n);
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) return usage();
+  const std::string cmd = argv[1];
+  if (cmd == "info" && argc > 2) return cmd_info(argc - 2, argv + 2);
+  if (cmd == "convert") return cmd_convert(argc - 2, argv + 2);
+  if (cmd == "merge") return cmd_merge(argc - 2, argv + 2);
+  if (cmd == "pack") return cmd_pack(argc - 2, argv + 2);
+  return usage();
+}
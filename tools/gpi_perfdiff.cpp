@@ -0,0 +1,264 @@
+// gpi_perfdiff: did a build get slower? Compares the frame times and the
+// per-call times (telemetry "call.*") of sessions from two builds.
+//
+//   gpi_perfdiff [options] BASE CAND...        every CAND against BASE
+//   gpi_perfdiff [options] BASE... -- CAND...  runs of each build pooled
+//
+// A session is a .gpisession file or a text session: its BASE (as in
+// BASE-frames.csv) or the path of its -frames.csv / -summary.json.
+//
+// For every distribution: mean, p50, p95, p99 and, for frames, dropped% (over
+// the baseline's frame budget), each with the candidate's delta and a
+// bootstrap confidence interval, plus a Mann-Whitney U test for a shift of
+// the whole distribution. Frame and call times are autocorrelated (one hitch
+// spans several frames), so the bootstrap resamples blocks of consecutive
+// values, not single ones. Call times are the raw telemetry points still in
+// the session: the last [telemetry] raw_seconds of it.
+//
+// A statistic regressed when its interval lies above zero and the delta is
+// at least --threshold (dropped%: --drop-pts); the U test counts when
+// p < --alpha, the candidate is the larger side and p50 grew by the threshold.
+// Exit status: 0 no regression, 1 at least one, 2 bad usage or input.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "platform/thread_pool.h"
+#include "perfdiff_stats.h"
+#include "services/session_file.h"
+
+namespace {
+
+using namespace perfdiff;
+
+struct Options {
+  double alpha = 0.01;
+  double threshold_pct = 3.0;
+  double drop_pts = 0.5;
+  int boot = 2000;
+  int block = 0;                        // 0: cube root of n
+  uint64_t seed = 1;
+  std::vector<std::string> series;      // telemetry key prefixes
+};
+
+// One side of the comparison: one session, or several runs pooled
+struct Side {
+  std::string label;
+  std::string plugin;
+  double target_fps = 0;
+  std::vector<double> frames;
+  std::map<std::string, std::vector<double>> series;
+};
+
+int usage() {
+  std::fprintf(stderr,
+    "usage: gpi_perfdiff [options] BASE CAND...\n"
+    "       gpi_perfdiff [options] BASE... -- CAND...\n"
+    "  --alpha A       significance level; intervals are 1-A (default 0.01)\n"
+    "  --threshold P   smallest slowdown to flag, %% of the baseline (default 3)\n"
+    "  --drop-pts D    smallest dropped%% increase to flag, points (default 0.5)\n"
+    "  --boot N        bootstrap resamples (default 2000)\n"
+    "  --block N       bootstrap block length, 0 = cube root of n (default 0)\n"
+    "  --seed S        bootstrap seed (default 1)\n"
+    "  --series PFX    telemetry keys to compare besides frames (default call.)\n");
+  return 2;
+}
+
+bool ends_with(const std::string& s, const char* suffix) {
+  const std::size_t n = std::strlen(suffix);
+  return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+bool load(const std::string& arg, session_file::Session& s) {
+  std::string err;
+  bool ok;
+  if (ends_with(arg, ".gpisession")) {
+    ok = session_file::read(arg, s, &err);
+  } else {
+    std::string base = arg;
+    for (const char* suffix : { "-frames.csv", "-summary.json" })
+      if (ends_with(base, suffix)) base.resize(base.size() - std::strlen(suffix));
+    ok = session_file::import_text(base, s, &err);
+  }
+  if (!ok) { std::fprintf(stderr, "%s: %s\n", arg.c_str(), err.c_str()); return false; }
+  if (!s.complete) std::fprintf(stderr, "%s: warning: truncated (no END section)\n", arg.c_str());
+  return true;
+}
+
+bool load_side(const std::vector<std::string>& args, const Options& o, Side& side) {
+  for (const auto& arg : args) {
+    session_file::Session s;
+    if (!load(arg, s)) return false;
+    if (side.frames.empty() && side.series.empty()) { side.plugin = s.info.plugin; side.target_fps = s.info.target_fps; }
+    side.frames.insert(side.frames.end(), s.frame_ms.begin(), s.frame_ms.end());
+    for (const auto& ser : s.series)
+      for (const auto& pfx : o.series)
+        if (ser.key.compare(0, pfx.size(), pfx) == 0) {
+          auto& v = side.series[ser.key];
+          v.insert(v.end(), ser.value.begin(), ser.value.end());
+          break;
+        }
+  }
+  side.label = args.size() == 1 ? args[0] : std::to_string(args.size()) + " sessions (" + args[0] + ", ...)";
+  return true;
+}
+
+// Circular block bootstrap: n values in blocks of len from random starts
+void resample(const std::vector<double>& src, std::size_t len, std::mt19937_64& rng, std::vector<double>& out) {
+  const std::size_t n = src.size();
+  out.resize(n);
+  for (std::size_t i = 0; i < n;) {
+    std::size_t j = (std::size_t)(rng() % n);
+    for (std::size_t k = 0; k < len && i < n; ++k, ++i) {
+      out[i] = src[j];
+      if (++j == n) j = 0;
+    }
+  }
+}
+
+struct Interval { Stats lo, hi; };
+
+Interval bootstrap(const std::vector<double>& b, const std::vector<double>& c, double budget_ms,
+                   const Options& o, ThreadPool& pool) {
+  auto block = [&](std::size_t n) {
+    return o.block > 0 ? (std::size_t)o.block : std::max<std::size_t>(1, (std::size_t)std::lround(std::cbrt((double)n)));
+  };
+  const std::size_t lb = block(b.size()), lc = block(c.size());
+  // Fixed chunks with their own seeds: the same intervals for any pool size
+  constexpr int kChunk = 32;
+  const int chunks = (o.boot + kChunk - 1) / kChunk;
+  std::vector<Stats> d((std::size_t)o.boot);
+  pool.parallel_for(chunks, [&](int ch) {
+    std::seed_seq seq{ (uint32_t)o.seed, (uint32_t)(o.seed >> 32), (uint32_t)ch };
+    std::mt19937_64 rng(seq);
+    std::vector<double> rb, rc;
+    for (int r = ch * kChunk; r < std::min(o.boot, (ch + 1) * kChunk); ++r) {
+      resample(b, lb, rng, rb);
+      resample(c, lc, rng, rc);
+      d[(std::size_t)r] = delta(stats_of(rb, budget_ms), stats_of(rc, budget_ms));
+    }
+  });
+  Interval iv;
+  std::vector<double> col(d.size());
+  for (int i = 0; i < kStats; ++i) {
+    for (std::size_t r = 0; r < d.size(); ++r) col[r] = d[r][i];
+    std::sort(col.begin(), col.end());
+    auto at = [&](double q) { return col[std::min(col.size() - 1, (std::size_t)(q * (double)col.size()))]; };
+    iv.lo[i] = at(o.alpha / 2);
+    iv.hi[i] = at(1.0 - o.alpha / 2);
+  }
+  return iv;
+}
+
+void print_side(const char* role, const Side& s) {
+  std::printf("%s  %s  (%s, %.0f fps, %zu frames)\n", role, s.label.c_str(),
+              s.plugin.empty() ? "?" : s.plugin.c_str(), s.target_fps, s.frames.size());
+}
+
+// Prints one distribution's rows; returns its regressions
+int compare(const char* name, std::vector<double> b, std::vector<double> c, double budget_ms,
+            const Options& o, ThreadPool& pool) {
+  constexpr std::size_t kMinN = 20;
+  if (b.size() < kMinN || c.size() < kMinN) {
+    std::printf("%-16s skipped: %zu / %zu samples\n", name, b.size(), c.size());
+    return 0;
+  }
+  // In time order for the blocks; stats_of reorders
+  const UTest u = mann_whitney(b, c);
+  const Interval iv = bootstrap(b, c, budget_ms, o, pool);
+  const Stats sb = stats_of(b, budget_ms), sc = stats_of(c, budget_ms);
+  const Stats d = delta(sb, sc);
+
+  int regressions = 0;
+  for (int i = 0; i < kStats; ++i) {
+    if (i == kDropped && budget_ms <= 0) continue;
+    const double thr = i == kDropped ? o.drop_pts : o.threshold_pct;
+    const char* unit = i == kDropped ? "pt" : "%";
+    const char* verdict = "";
+    if (iv.lo[i] > 0 && d[i] >= thr) { verdict = "REGRESSED"; ++regressions; }
+    else if (iv.hi[i] < 0 && d[i] <= -thr) verdict = "improved";
+    char ci[64];
+    std::snprintf(ci, sizeof(ci), "[%+.1f%s, %+.1f%s]", iv.lo[i], unit, iv.hi[i], unit);
+    std::printf("%-16s %-9s %9.3f %9.3f %+8.1f%-2s %-*s%s\n", i ? "" : name, kStatNames[i],
+                sb[i], sc[i], d[i], unit, *verdict ? 23 : 0, ci, verdict);
+  }
+  const bool shifted = u.p < o.alpha;
+  const char* verdict = "";
+  if (shifted && u.p_greater > 0.5 && d[kP50] >= o.threshold_pct) { verdict = "REGRESSED"; ++regressions; }
+  else if (shifted && u.p_greater < 0.5 && d[kP50] <= -o.threshold_pct) verdict = "improved";
+  char p[32];
+  if (u.p < 1e-16) std::snprintf(p, sizeof(p), "p<1e-16");
+  else std::snprintf(p, sizeof(p), "p=%.2g", u.p);
+  std::printf("%-16s %-9s %9s  P(cand>base)=%.3f%*s%s\n", "", "U test", p, u.p_greater,
+              *verdict ? 23 : 0, "", verdict);
+  return regressions;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options o;
+  std::vector<std::string> pos, before;
+  bool split = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    auto val = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+    const char* v = nullptr;
+    if (a == "--") { if (split) return usage(); split = true; before.swap(pos); continue; }
+    if (a.size() < 2 || a[0] != '-' || a[1] != '-') { pos.push_back(a); continue; }
+    if (!(v = val())) return usage();
+    if (a == "--alpha") o.alpha = std::atof(v);
+    else if (a == "--threshold") o.threshold_pct = std::atof(v);
+    else if (a == "--drop-pts") o.drop_pts = std::atof(v);
+    else if (a == "--boot") o.boot = std::atoi(v);
+    else if (a == "--block") o.block = std::atoi(v);
+    else if (a == "--seed") o.seed = std::strtoull(v, nullptr, 10);
+    else if (a == "--series") o.series.push_back(v);
+    else return usage();
+  }
+  if (o.series.empty()) o.series.push_back("call.");
+  if (o.alpha <= 0 || o.alpha >= 1 || o.boot < 100) return usage();
+
+  // BASE... -- CAND...: one pooled comparison; otherwise the first argument
+  // is the baseline of all the others
+  std::vector<std::vector<std::string>> cands;
+  std::vector<std::string> base_args;
+  if (split) {
+    if (before.empty() || pos.empty()) return usage();
+    base_args = before;
+    cands.push_back(pos);
+  } else {
+    if (pos.size() < 2) return usage();
+    base_args.push_back(pos[0]);
+    for (std::size_t i = 1; i < pos.size(); ++i) cands.push_back({ pos[i] });
+  }
+
+  Side base;
+  if (!load_side(base_args, o, base)) return 2;
+  // Same threshold on both sides: the baseline's own (16.6 ms when unknown)
+  const double budget_ms = base.target_fps > 0 ? 1000.0 / base.target_fps : 16.6;
+  ThreadPool pool;
+  int regressions = 0;
+  for (const auto& args : cands) {
+    Side cand;
+    if (!load_side(args, o, cand)) return 2;
+    print_side("base", base);
+    print_side("cand", cand);
+    if (cand.target_fps != base.target_fps)
+      std::printf("warning: target fps differs; dropped%% uses the baseline's %.2f ms\n", budget_ms);
+    std::printf("%-16s %-9s %9s %9s %10s %g%% CI\n", "", "stat", "base", "cand", "delta", 100 * (1 - o.alpha));
+    regressions += compare("frame_ms", base.frames, cand.frames, budget_ms, o, pool);
+    for (const auto& [key, values] : base.series) {
+      const auto it = cand.series.find(key);
+      if (it != cand.series.end()) regressions += compare(key.c_str(), values, it->second, 0.0, o, pool);
+    }
+    std::printf("\n");
+  }
+  std::printf("%d regression(s)\n", regressions);
+  return regressions ? 1 : 0;
+}
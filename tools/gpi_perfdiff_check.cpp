@@ -0,0 +1,132 @@
+// gpi_perfdiff_check: pins down the statistics gpi_perfdiff gates on. Known
+// Mann-Whitney U values (with ties), nearest-rank quantiles, and the tool's
+// exit status on synthetic sessions that do and do not differ.
+//
+//   gpi_perfdiff_check PATH_TO_GPI_PERFDIFF
+//
+// Writes its sessions to perfdiff_check/ in the working directory. Exit
+// status: 0 every check passed, 1 otherwise.
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include "perfdiff_stats.h"
+#include "services/session_file.h"
+#if !defined(_WIN32)
+#include <sys/wait.h>
+#endif
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+  std::printf("%s  %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok) ++failures;
+}
+
+bool near(double a, double b, double tol) { return std::fabs(a - b) <= tol; }
+
+void check_u_test() {
+  // Ranks of 1 2 3 3 4 4 5 6: the candidate holds 3.5 + 5.5 + 7 + 8 = 24,
+  // so U = 24 - 4 * 5 / 2 = 14 of 16. Two tie groups of two: sigma =
+  // sqrt(16 / 12 * (9 - 12 / 56)), z = (|14 - 8| - 0.5) / sigma
+  const perfdiff::UTest t = perfdiff::mann_whitney({ 1, 2, 3, 4 }, { 3, 4, 5, 6 });
+  check(near(t.u, 14.0, 1e-12), "U with ties");
+  check(near(t.p_greater, 0.875, 1e-12), "P(cand > base) with ties");
+  check(near(t.p, 0.1080633729, 1e-8), "two-sided p, tie and continuity corrected");
+
+  // Swapping the sides mirrors U; p stays
+  const perfdiff::UTest r = perfdiff::mann_whitney({ 3, 4, 5, 6 }, { 1, 2, 3, 4 });
+  check(near(r.u, 2.0, 1e-12) && near(r.p, t.p, 1e-12), "U of the swapped sides");
+
+  // Identical samples: no shift at all
+  const perfdiff::UTest e = perfdiff::mann_whitney({ 5, 5, 5, 7 }, { 5, 5, 5, 7 });
+  check(near(e.p_greater, 0.5, 1e-12) && near(e.p, 1.0, 1e-12), "U of identical samples");
+}
+
+void check_quantiles() {
+  std::vector<double> x = { 7, 3, 10, 1, 9, 2, 8, 4, 6, 5 };
+  std::size_t from = 0;
+  const double p10 = perfdiff::quantile(x, 0.10, from);
+  const double p50 = perfdiff::quantile(x, 0.50, from);
+  const double p95 = perfdiff::quantile(x, 0.95, from);
+  check(p10 == 1 && p50 == 5 && p95 == 10, "nearest rank on 1..10 (p10 p50 p95)");
+
+  std::vector<double> y;
+  for (int i = 100; i >= 1; --i) y.push_back(i);
+  const perfdiff::Stats st = perfdiff::stats_of(y, 90.0);
+  check(st[perfdiff::kP50] == 50 && st[perfdiff::kP95] == 95 && st[perfdiff::kP99] == 99,
+        "stats_of 1..100: p50 p95 p99");
+  check(near(st[perfdiff::kMean], 50.5, 1e-12) && near(st[perfdiff::kDropped], 10.0, 1e-12),
+        "stats_of 1..100: mean, dropped% over 90");
+
+  std::vector<double> one = { 42 };
+  from = 0;
+  check(perfdiff::quantile(one, 0.99, from) == 42, "nearest rank of a single value");
+}
+
+// Frame times around 10 ms with a slow drift and rare hitches, times scale
+bool write_session(const std::string& path, uint64_t seed, double scale) {
+  session_file::Session s;
+  s.info.plugin = "check";
+  s.info.target_fps = 60;
+  std::mt19937_64 rng(seed);
+  std::normal_distribution<double> noise(0.0, 0.4);
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  for (int i = 0; i < 3000; ++i) {
+    double ms = 10.0 + 0.3 * std::sin(i / 50.0) + noise(rng);
+    if (u(rng) < 0.01) ms += 6.0;
+    s.frame_ms.push_back(ms * scale);
+  }
+  s.complete = true;
+  return session_file::write(path, s) > 0;
+}
+
+int run(const std::string& tool, const std::string& args) {
+  const std::string cmd = "\"" + tool + "\" --boot 500 " + args + " > perfdiff_check/last.txt";
+  const int rc = std::system(cmd.c_str());
+#if defined(_WIN32)
+  return rc;
+#else
+  return WIFEXITED(rc) ? WEXITSTATUS(rc) : -1;
+#endif
+}
+
+void check_exit_codes(const std::string& tool) {
+  std::error_code ec;
+  std::filesystem::create_directories("perfdiff_check", ec);
+  const bool wrote = write_session("perfdiff_check/base.gpisession", 1, 1.0) &&
+                     write_session("perfdiff_check/same.gpisession", 2, 1.0) &&
+                     write_session("perfdiff_check/slow.gpisession", 3, 1.06) &&
+                     write_session("perfdiff_check/fast.gpisession", 4, 0.94);
+  check(wrote, "write synthetic sessions");
+  if (!wrote) return;
+  check(run(tool, "perfdiff_check/base.gpisession perfdiff_check/same.gpisession") == 0,
+        "same distribution: exit 0");
+  check(run(tool, "perfdiff_check/base.gpisession perfdiff_check/slow.gpisession") == 1,
+        "6% slower: exit 1");
+  check(run(tool, "perfdiff_check/base.gpisession perfdiff_check/fast.gpisession") == 0,
+        "6% faster: exit 0");
+  check(run(tool, "perfdiff_check/base.gpisession perfdiff_check/same.gpisession -- "
+                  "perfdiff_check/slow.gpisession") == 1, "pooled base vs slower: exit 1");
+  check(run(tool, "perfdiff_check/base.gpisession perfdiff_check/missing.gpisession") == 2,
+        "missing session: exit 2");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::fprintf(stderr, "usage: gpi_perfdiff_check PATH_TO_GPI_PERFDIFF\n");
+    return 2;
+  }
+  check_u_test();
+  check_quantiles();
+  check_exit_codes(argv[1]);
+  std::printf("%d failure(s)\n", failures);
+  return failures ? 1 : 0;
+}
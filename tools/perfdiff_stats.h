@@ -0,0 +1,87 @@
+#pragma once
+// The statistics behind gpi_perfdiff's verdicts, kept apart from the tool so
+// gpi_perfdiff_check can pin them down.
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace perfdiff {
+
+enum Stat { kMean, kP50, kP95, kP99, kDropped, kStats };
+inline const char* const kStatNames[kStats] = { "mean", "p50", "p95", "p99", "dropped%" };
+using Stats = std::array<double, kStats>;
+
+// Nearest rank on x, which it reorders; from = where the previous (lower)
+// quantile left its element, so the searches narrow
+inline double quantile(std::vector<double>& x, double q, std::size_t& from) {
+  std::size_t k = (std::size_t)std::ceil(q * (double)x.size());
+  k = std::min(std::max<std::size_t>(k, 1), x.size()) - 1;
+  k = std::max(k, from);
+  std::nth_element(x.begin() + (std::ptrdiff_t)from, x.begin() + (std::ptrdiff_t)k, x.end());
+  from = k;
+  return x[k];
+}
+
+// budget_ms <= 0: no dropped%
+inline Stats stats_of(std::vector<double>& x, double budget_ms) {
+  Stats st{};
+  double total = 0;
+  std::size_t over = 0;
+  for (double v : x) { total += v; over += budget_ms > 0 && v > budget_ms; }
+  st[kMean] = total / (double)x.size();
+  st[kDropped] = 100.0 * (double)over / (double)x.size();
+  std::size_t from = 0;
+  st[kP50] = quantile(x, 0.50, from);
+  st[kP95] = quantile(x, 0.95, from);
+  st[kP99] = quantile(x, 0.99, from);
+  return st;
+}
+
+// Candidate minus baseline: percent of the baseline, dropped% in points
+inline Stats delta(const Stats& b, const Stats& c) {
+  Stats d{};
+  for (int i = 0; i < kStats; ++i)
+    d[i] = i == kDropped ? c[i] - b[i] : 100.0 * (c[i] - b[i]) / std::max(std::fabs(b[i]), 1e-9);
+  return d;
+}
+
+struct UTest {
+  double u = 0;           // the candidate's U
+  double p = 1;           // two-sided
+  double p_greater = 0.5; // P(cand > base), ties count half
+};
+
+// Normal approximation with tie and continuity corrections; fine for the
+// sample sizes sessions have (hundreds and up)
+inline UTest mann_whitney(const std::vector<double>& b, const std::vector<double>& c) {
+  std::vector<std::pair<double, bool>> all;   // value, from cand
+  all.reserve(b.size() + c.size());
+  for (double v : b) all.emplace_back(v, false);
+  for (double v : c) all.emplace_back(v, true);
+  std::sort(all.begin(), all.end(), [](const auto& x, const auto& y) { return x.first < y.first; });
+  const double nb = (double)b.size(), nc = (double)c.size(), n = nb + nc;
+  double rank_c = 0, ties = 0;
+  for (std::size_t i = 0; i < all.size();) {
+    std::size_t j = i;
+    std::size_t in_c = 0;
+    while (j < all.size() && all[j].first == all[i].first) in_c += all[j++].second;
+    const double t = (double)(j - i);
+    rank_c += (double)in_c * ((double)i + 1 + (double)j) / 2;
+    ties += t * t * t - t;
+    i = j;
+  }
+  UTest u;
+  u.u = rank_c - nc * (nc + 1) / 2;
+  u.p_greater = u.u / (nb * nc);
+  const double sigma = std::sqrt(nb * nc / 12 * ((n + 1) - ties / (n * (n - 1))));
+  if (sigma > 0) {
+    const double z = std::max(0.0, std::fabs(u.u - nb * nc / 2) - 0.5) / sigma;
+    u.p = std::erfc(z / std::sqrt(2.0));
+  }
+  return u;
+}
+
+} // namespace perfdiff